@@ -0,0 +1,176 @@
+/*
+    Compares the opcode dispatch loops of m6800_cpu_device
+
+    Each workload is first single-stepped to count how many instructions fit in the cycle
+    budget, then run from the same starting state through each dispatch loop. Every loop has
+    to end in the same state as the first one, or the bench fails.
+*/
+
+#include "../src/cpu/jit_x64.h"
+#include "../src/cpu/m6800.h"
+#include "../src/dev/devices.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef ET3400_ROM_DIR
+#define ET3400_ROM_DIR "src/resources/rom"
+#endif
+
+static const int CYCLES_PER_SLICE = 16667;
+static const int SLICES = 6000;
+
+// A loop of loads, stores, ALU and branch instructions running from RAM
+static const uint8_t ram_program[] = {
+    0xCE, 0x01, 0x00, // 0000 LDX  #$0100
+    0x86, 0x12, //       0003 LDAA #$12
+    0xC6, 0x34, //       0005 LDAB #$34
+    0x1B, //             0007 ABA
+    0x97, 0x80, //       0008 STAA $80
+    0xD6, 0x80, //       000A LDAB $80
+    0xE7, 0x00, //       000C STAB 0,X
+    0x08, //             000E INX
+    0x8C, 0x01, 0x40, // 000F CPX  #$0140
+    0x26, 0xEF, //       0012 BNE  $0003
+    0x20, 0xEA, //       0014 BRA  $0000
+};
+
+struct Machine {
+    MemoryMapManager memory_map;
+    memory_device ram { 0x0000, 0x0800, false };
+    memory_device rom { 0xFC00, 0x0400, true };
+    keypad_io keypad;
+    display_io display;
+    m6800_cpu_device cpu { &memory_map };
+
+    Machine(bool run_monitor) {
+        memset(ram.get_mapped_memory(), 0, 0x0800);
+        memset(display.get_mapped_memory(), 0, 96);
+        memory_map.map(&ram);
+        memory_map.map(&keypad);
+        memory_map.map(&display);
+        memory_map.map(&rom);
+        keypad.init();
+
+        FILE* file = fopen(ET3400_ROM_DIR "/monitor.bin", "rb");
+        if (file != NULL) {
+            uint8_t buffer[0x400];
+            size_t size = fread(buffer, 1, sizeof(buffer), file);
+            rom.load(0xFC00, buffer, size);
+            fclose(file);
+        } else {
+            memset(rom.get_mapped_memory(), 0, 0x400);
+        }
+
+        ram.load(0x0000, (uint8_t*)ram_program, sizeof(ram_program));
+
+        cpu.check_breakpoint = [](uint32_t) { return false; };
+        cpu.device_start();
+        cpu.device_reset();
+        if (!run_monitor) {
+            cpu.m_pc.d = 0x0000;
+        }
+    }
+};
+
+typedef void (m6800_cpu_device::*run_func)();
+
+// FNV-1a over the CPU registers, RAM and display
+static uint64_t hash_bytes(uint64_t hash, const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static uint64_t state_hash(Machine& machine) {
+    m6800_state state;
+    memset(&state, 0, sizeof(state));
+    machine.cpu.save_state(state);
+    uint64_t hash = hash_bytes(0xCBF29CE484222325ULL, (uint8_t*)&state, sizeof(state));
+    hash = hash_bytes(hash, machine.ram.get_mapped_memory(), 0x0800);
+    return hash_bytes(hash, machine.display.get_mapped_memory(), 96);
+}
+
+static long long count_instructions(bool run_monitor) {
+    Machine machine(run_monitor);
+    long long instructions = 0;
+    for (int slice = 0; slice < SLICES; slice++) {
+        machine.cpu.m_icount = CYCLES_PER_SLICE;
+        while (machine.cpu.m_icount > 0) {
+            machine.cpu.execute_step();
+            instructions++;
+        }
+    }
+    return instructions;
+}
+
+static double run(bool run_monitor, run_func func, uint64_t& hash) {
+    Machine machine(run_monitor);
+    auto start = std::chrono::steady_clock::now();
+    for (int slice = 0; slice < SLICES; slice++) {
+        machine.cpu.m_icount = CYCLES_PER_SLICE;
+        (machine.cpu.*func)();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    hash = state_hash(machine);
+    return seconds;
+}
+
+// returns false when a loop ends in a different state than the first one
+static bool benchmark(const char* name, bool run_monitor) {
+    struct {
+        const char* name;
+        run_func func;
+    } loops[] = {
+        { "table", &m6800_cpu_device::execute_run_table },
+        { "switch", &m6800_cpu_device::execute_run_switch },
+#if defined(__GNUC__)
+        { "goto", &m6800_cpu_device::execute_run_goto },
+#endif
+        { "blocks", &m6800_cpu_device::execute_run_blocks },
+#if M6800_JIT_X64
+        { "jit", &m6800_cpu_device::execute_run_jit },
+#endif
+    };
+
+    long long instructions = count_instructions(run_monitor);
+    double cycles = (double)CYCLES_PER_SLICE * SLICES;
+    double baseline = 0;
+    uint64_t expected = 0;
+    bool same = true;
+
+    printf("%s: %lld instructions, %.0f cycles\n", name, instructions, cycles);
+    for (auto& loop : loops) {
+        double best = 1e9;
+        uint64_t hash = 0;
+        for (int i = 0; i < 3; i++) {
+            double seconds = run(run_monitor, loop.func, hash);
+            if (seconds < best) {
+                best = seconds;
+            }
+        }
+        if (baseline == 0) {
+            baseline = best;
+            expected = hash;
+        }
+        printf("  %-8s %8.2f Minstr/s %8.2f emulated MHz %6.2fx", loop.name, instructions / best / 1e6, cycles / best / 1e6, baseline / best);
+        if (hash != expected) {
+            printf("  state %016llx, expected %016llx", (unsigned long long)hash, (unsigned long long)expected);
+            same = false;
+        }
+        printf("\n");
+    }
+    return same;
+}
+
+int main() {
+    bool same = benchmark("RAM loop", false);
+    same = benchmark("Monitor ROM", true) && same;
+    if (!same) {
+        printf("dispatch loops ended in different states\n");
+        return 1;
+    }
+    return 0;
+}
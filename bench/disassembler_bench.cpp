@@ -0,0 +1,117 @@
+/*
+    Measures the disassembler
+
+    Decodes a 64K image of random bytes with the monitor ROM at $FC00 three ways: one
+    instruction at each of the 65,536 start addresses, the way the debugger lands on an
+    arbitrary address; the whole image with disassembleRange() into a reused vector, the way
+    a listing is built; and the every-address sweep again on every core at once, which the
+    old disassembler could not do because it formatted into two shared static buffers. The
+    text each thread decodes is checked against the single-threaded sweep.
+*/
+
+#include "../src/dasm/disassembler.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#ifndef ET3400_ROM_DIR
+#define ET3400_ROM_DIR "src/resources/rom"
+#endif
+
+static const int PASSES = 40;
+
+// the image, and two bytes past the end for the operands of an instruction at $FFFF
+static uint8_t image[0x10002];
+
+static void load_image() {
+    uint32_t seed = 0x6800;
+    for (size_t i = 0; i < sizeof(image); i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        image[i] = seed;
+    }
+    FILE* file = fopen(ET3400_ROM_DIR "/monitor.bin", "rb");
+    if (file != NULL) {
+        fread(&image[0xFC00], 1, 0x400, file);
+        fclose(file);
+    }
+}
+
+// FNV-1a over the text and length of a line
+static uint64_t hash_line(uint64_t hash, const DasmLine& line) {
+    const char* strings[] = { line.instruction, line.operand };
+    for (const char* text : strings) {
+        while (*text != 0) {
+            hash = (hash ^ (uint8_t)*text++) * 0x100000001B3ULL;
+        }
+        hash = (hash ^ 0xFF) * 0x100000001B3ULL;
+    }
+    return (hash ^ line.length) * 0x100000001B3ULL;
+}
+
+static uint64_t every_address(int passes) {
+    uint64_t hash = 0;
+    DasmLine line;
+    for (int pass = 0; pass < passes; pass++) {
+        hash = 0xCBF29CE484222325ULL;
+        for (int address = 0; address <= 0xFFFF; address++) {
+            Disassembler::disassemble(&image[address], address, line);
+            hash = hash_line(hash, line);
+        }
+    }
+    return hash;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    load_image();
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t expected = every_address(PASSES);
+    double seconds = seconds_since(start);
+    double count = 65536.0 * PASSES;
+    printf("every address  %8.1f ns/instruction  %7.1f M instructions/s\n",
+        seconds / count * 1e9, count / seconds / 1e6);
+
+    std::vector<DasmLine> lines;
+    size_t decoded = 0;
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < PASSES; pass++) {
+        lines.clear();
+        decoded += Disassembler::disassembleRange(image, 0, 0xFFFF, lines);
+    }
+    seconds = seconds_since(start);
+    printf("range          %8.1f ns/instruction  %7.1f M instructions/s  (%zu lines)\n",
+        seconds / decoded * 1e9, decoded / seconds / 1e6, lines.size());
+
+    int threads = std::thread::hardware_concurrency();
+    if (threads < 2) {
+        threads = 2;
+    }
+    std::vector<uint64_t> hashes(threads);
+    std::vector<std::thread> workers;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back([&hashes, i]() { hashes[i] = every_address(PASSES); });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    seconds = seconds_since(start);
+    count *= threads;
+    int mismatches = 0;
+    for (uint64_t hash : hashes) {
+        mismatches += hash != expected;
+    }
+    printf("%2d threads     %8.1f ns/instruction  %7.1f M instructions/s  %d mismatches\n",
+        threads, seconds / count * 1e9, count / seconds / 1e6, mismatches);
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,230 @@
+/*
+    Measures the cost of painting the trainer's display
+
+    Shows the Display widget and compares it with the way it used to paint: every address from
+    $C16F down to $C110 drawn on every paint, each segment's pixmap blitted under its own
+    save()/translate()/restore() along with the digit's flag letter. Three workloads are timed:
+    every digit changing, one digit changing, and nothing changing, which the old pipeline
+    repainted all the same. Both widgets are painted by Qt from the event loop, so each paint
+    covers what the widget itself invalidated, and the area Qt asked for is counted from the
+    paint events.
+
+    Runs on the offscreen platform unless QT_QPA_PLATFORM says otherwise.
+*/
+
+#include "../src/widgets/display.h"
+
+#include <QApplication>
+#include <QPaintEvent>
+#include <QPainter>
+#include <chrono>
+#include <stdio.h>
+
+static const int PAINTS = 20000;
+
+// segment patterns of the hex digits, bit 0 = g up to bit 6 = a
+static const uint8_t hex_patterns[] = {
+    0x7E, 0x30, 0x6D, 0x79, 0x33, 0x5B, 0x5F, 0x70, 0x7F, 0x7B, 0x77, 0x1F, 0x4E, 0x3D, 0x4F, 0x47
+};
+
+// pixels in the region of a paint event
+static long long area(const QRegion& region) {
+    long long pixels = 0;
+    for (const QRect& rect : region) {
+        pixels += (long long)rect.width() * rect.height();
+    }
+    return pixels;
+}
+
+// the paintEvent the Display widget had before the glyph cache
+class LegacyDisplay : public QWidget {
+public:
+    display_io* device;
+    long long painted = 0; /* pixels Qt asked to paint */
+
+    LegacyDisplay(display_io* device) {
+        this->device = device;
+        hr[0].load(":/images/hr_off.png");
+        hr[1].load(":/images/hr_on.png");
+        vt[0].load(":/images/vt_off.png");
+        vt[1].load(":/images/vt_on.png");
+        dp[0].load(":/images/dp_off.png");
+        dp[1].load(":/images/dp_on.png");
+        setFixedSize(QSize(320, 85));
+    }
+
+protected:
+    void paintEvent(QPaintEvent* event) override {
+        painted += area(event->region());
+        QPainter painter(this);
+        QString letters[] = { "H", "I", "N", "Z", "V", "C" };
+        painter.setBrush(QBrush(Qt::black));
+        painter.fillRect(this->rect(), painter.brush());
+        painter.setPen(Qt::white);
+
+        painter.save();
+        for (int address = 0xC16F; address >= 0xC110; address--) {
+            if ((address & 0x08) != 0x08) {
+                int position = 6 - ((address & 0xF0) >> 4);
+                int segment = address & 0x7;
+                uint8_t state = device->read(address) & 1;
+
+                painter.save();
+                painter.translate(20 + position * 45, 10);
+                switch (segment) {
+                case 0:
+                    painter.drawPixmap(11, 23, hr[state]);
+                    break;
+                case 1:
+                    painter.drawPixmap(5, 11, vt[state]);
+                    break;
+                case 2:
+                    painter.drawPixmap(4, 27, vt[state]);
+                    break;
+                case 3:
+                    painter.drawPixmap(8, 42, hr[state]);
+                    break;
+                case 4:
+                    painter.drawPixmap(25, 27, vt[state]);
+                    break;
+                case 5:
+                    painter.drawPixmap(26, 11, vt[state]);
+                    break;
+                case 6:
+                    painter.drawPixmap(11, 5, hr[state]);
+                    break;
+                case 7:
+                    painter.drawPixmap(31, 42, dp[state]);
+                    break;
+                }
+                painter.restore();
+
+                painter.save();
+                painter.translate(20 + position * 45, 10);
+                painter.drawText(15, 65, letters[position]);
+                painter.restore();
+            }
+        }
+        painter.restore();
+        painter.end();
+    }
+
+private:
+    QPixmap hr[2];
+    QPixmap vt[2];
+    QPixmap dp[2];
+};
+
+// the Display widget as it is, counting the region of each paint it gets
+class MeasuredDisplay : public Display {
+public:
+    long long painted = 0;
+
+protected:
+    void paintEvent(QPaintEvent* event) override {
+        painted += area(event->region());
+        Display::paintEvent(event);
+    }
+};
+
+static void show_digit(display_io* device, int position, uint8_t pattern) {
+    offs_t base = 0xC110 + (5 - position) * 0x10;
+    for (int segment = 0; segment < 8; segment++) {
+        device->write(base + segment, (pattern >> segment) & 1);
+    }
+}
+
+enum Workload {
+    AllDigits,
+    OneDigit,
+    Unchanged
+};
+
+// what the display shows before paint i
+static void change(display_io* device, Workload workload, int i) {
+    switch (workload) {
+    case AllDigits:
+        for (int position = 0; position < Display::DIGITS; position++) {
+            show_digit(device, position, hex_patterns[(i + position) & 15]);
+        }
+        break;
+    case OneDigit:
+        show_digit(device, i % Display::DIGITS, hex_patterns[i & 15]);
+        break;
+    case Unchanged:
+        break;
+    }
+}
+
+struct Timing {
+    double seconds;
+    long long painted;
+};
+
+static Timing time_legacy(Workload workload) {
+    LegacyDisplay display(new display_io);
+    display.show();
+    QApplication::processEvents();
+    display.painted = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < PAINTS; i++) {
+        change(display.device, workload, i);
+        // the worker asked for a full repaint after every frame
+        display.update();
+        QApplication::processEvents();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    delete display.device;
+    return Timing { seconds, display.painted };
+}
+
+static Timing time_cached(Workload workload) {
+    MeasuredDisplay display;
+    display.show();
+    QApplication::processEvents();
+
+    // build the glyphs outside the timed loop, like a display that has been running a while
+    for (int i = 0; i < 16; i++) {
+        change(display.device, AllDigits, i);
+        display.redraw();
+        QApplication::processEvents();
+    }
+    display.painted = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < PAINTS; i++) {
+        change(display.device, workload, i);
+        // what the refresh timer does, the paints are the regions redraw() passed to update()
+        display.redraw();
+        QApplication::processEvents();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return Timing { seconds, display.painted };
+}
+
+int main(int argc, char** argv) {
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    struct {
+        const char* name;
+        Workload workload;
+    } workloads[] = {
+        { "all digits", AllDigits },
+        { "one digit", OneDigit },
+        { "unchanged", Unchanged },
+    };
+
+    printf("%d paints\n", PAINTS);
+    for (auto& workload : workloads) {
+        Timing legacy = time_legacy(workload.workload);
+        Timing cached = time_cached(workload.workload);
+        printf("  %-12s legacy %8.2f us %6lld px/paint  cached %8.2f us %6lld px/paint  %7.1fx\n", workload.name,
+            legacy.seconds / PAINTS * 1e6, legacy.painted / PAINTS, cached.seconds / PAINTS * 1e6, cached.painted / PAINTS,
+            cached.seconds > 0 ? legacy.seconds / cached.seconds : 0);
+    }
+    return 0;
+}
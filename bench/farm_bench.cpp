@@ -0,0 +1,86 @@
+/*
+    Measures how EmulatorFarm throughput scales with the number of threads
+
+    The sample programs are run as a batch of jobs, each starting at its entry point for a
+    fixed cycle budget, once per thread count from 1 up to the number of cores. A report of
+    the last run is written to the file given on the command line.
+*/
+
+#include "../src/emu/emulator_farm.h"
+
+#include <stdio.h>
+#include <thread>
+
+#ifndef ET3400_ROM_DIR
+#define ET3400_ROM_DIR "src/resources/rom"
+#endif
+
+#ifndef ET3400_SAMPLES_DIR
+#define ET3400_SAMPLES_DIR "samples"
+#endif
+
+static const int COPIES = 32;
+static const unsigned long long CYCLE_BUDGET = 5000000;
+
+int main(int argc, char* argv[]) {
+    struct {
+        const char* file;
+        int start;
+    } samples[] = {
+        { "samp123a.s19", 0x0000 },
+        { "samp123a.s19", 0x0030 },
+        { "samp123a.s19", 0x0060 },
+        { "samp45a.s19", 0x0000 },
+        { "samp6a.s19", 0x0000 },
+    };
+
+    std::vector<FarmJob> jobs;
+    for (int copy = 0; copy < COPIES; copy++) {
+        for (auto& sample : samples) {
+            char name[64];
+            snprintf(name, sizeof(name), "%s@%04X#%d", sample.file, sample.start, copy);
+            FarmJob job = EmulatorFarm::make_job(name, CYCLE_BUDGET);
+            job.roms = EmulatorFarm::standard_roms(ET3400_ROM_DIR);
+            job.srecords.push_back(std::string(ET3400_SAMPLES_DIR "/") + sample.file);
+            job.start_pc = sample.start;
+            jobs.push_back(job);
+        }
+    }
+
+    int cores = std::thread::hardware_concurrency();
+    if (cores < 1) {
+        cores = 1;
+    }
+
+    std::vector<int> counts;
+    for (int threads = 1; threads < cores; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(cores);
+
+    double single = 0;
+    std::vector<FarmResult> results;
+    EmulatorFarm* farm = nullptr;
+
+    printf("%d jobs of %llu cycles\n", (int)jobs.size(), CYCLE_BUDGET);
+    for (size_t i = 0; i < counts.size(); i++) {
+        delete farm;
+        farm = new EmulatorFarm(counts[i]);
+        results = farm->run(jobs);
+        double mhz = farm->get_cycles() / farm->get_seconds() / 1e6;
+        if (i == 0) {
+            single = mhz;
+        }
+        printf("  %3d threads %8.2f jobs/s %10.2f emulated MHz %6.2fx\n", counts[i], jobs.size() / farm->get_seconds(), mhz, mhz / single);
+    }
+
+    if (argc > 1) {
+        FILE* out = fopen(argv[1], "w");
+        if (out != NULL) {
+            farm->write_report(out, results);
+            fclose(out);
+        }
+    }
+    delete farm;
+    return 0;
+}
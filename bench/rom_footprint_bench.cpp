@@ -0,0 +1,170 @@
+/*
+    Measures the memory cost of each emulator instance with shared and private ROMs
+
+    Builds 1,000 machines (RAM, keypad, display, PIA, CPU and the three trainer ROMs), runs
+    each through the monitor's start-up code so the CPU caches are populated, and reports the
+    growth of the resident set per machine. In the shared case the ROMs come from rom_registry
+    and every machine maps the same pages; in the private case each machine gets its own copy
+    in a memory_device, which is how ROMs were loaded before the registry.
+*/
+
+#include "../src/cpu/m6800.h"
+#include "../src/dev/devices.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif // __linux__
+
+#ifndef ET3400_ROM_DIR
+#define ET3400_ROM_DIR "src/resources/rom"
+#endif
+
+static const int INSTANCES = 1000;
+static const int WARMUP_CYCLES = 50000;
+
+static const struct {
+    const char* file;
+    offs_t address;
+    size_t size;
+} roms[] = {
+    { ET3400_ROM_DIR "/monitor.bin", 0xFC00, 0x0400 },
+    { ET3400_ROM_DIR "/fantomii.bin", 0x1400, 0x0800 },
+    { ET3400_ROM_DIR "/tinybasic.bin", 0x1C00, 0x0800 },
+};
+
+struct Machine {
+    MemoryMapManager memory_map;
+    memory_device ram { 0x0000, 0x0800, false };
+    keypad_io keypad;
+    display_io display;
+    RS232Adapter serial;
+    MC6820 pia { &serial };
+    std::vector<memory_mapped_device*> roms;
+    m6800_cpu_device* cpu;
+
+    Machine() {
+        memset(ram.get_mapped_memory(), 0, 0x0800);
+        memset(display.get_mapped_memory(), 0, 96);
+        memory_map.map(&ram);
+        memory_map.map(&keypad);
+        memory_map.map(&display);
+        memory_map.map(&pia);
+        keypad.init();
+        cpu = new m6800_cpu_device(&memory_map);
+    }
+
+    ~Machine() {
+        delete cpu;
+        std::vector<memory_mapped_device*>::iterator it = roms.begin();
+        while (it != roms.end()) {
+            delete *it;
+            it++;
+        }
+    }
+
+    void add_rom(memory_mapped_device* rom) {
+        memory_map.map(rom);
+        roms.push_back(rom);
+    }
+
+    void run() {
+        cpu->device_start();
+        cpu->device_reset();
+        cpu->m_icount = WARMUP_CYCLES;
+        cpu->pre_execute_run();
+        cpu->execute_run();
+    }
+};
+
+// resident set size in bytes, 0 where /proc isn't available
+static size_t resident_bytes() {
+    size_t resident = 0;
+#ifdef __linux__
+    size_t pages = 0;
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (file != NULL) {
+        if (fscanf(file, "%zu %zu", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(file);
+    }
+    resident *= sysconf(_SC_PAGESIZE);
+#endif // __linux__
+    return resident;
+}
+
+static bool load_file(const char* path, uint8_t* buffer, size_t size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    size_t read = fread(buffer, 1, size, file);
+    fclose(file);
+    return read > 0;
+}
+
+static void measure(bool shared, std::vector<Machine*>& machines) {
+    size_t before = resident_bytes();
+
+    for (int i = 0; i < INSTANCES; i++) {
+        Machine* machine = new Machine;
+        for (auto& rom : roms) {
+            if (shared) {
+                std::shared_ptr<const rom_image> image = rom_registry::acquire_file(rom.file, rom.size);
+                if (!image) {
+                    printf("can't read %s\n", rom.file);
+                    delete machine;
+                    return;
+                }
+                machine->add_rom(new rom_device(rom.address, image));
+            } else {
+                memory_device* copy = new memory_device(rom.address, rom.size, true);
+                memset(copy->get_mapped_memory(), 0xFF, rom.size);
+                if (!load_file(rom.file, copy->get_mapped_memory(), rom.size)) {
+                    printf("can't read %s\n", rom.file);
+                    delete copy;
+                    delete machine;
+                    return;
+                }
+                machine->add_rom(copy);
+            }
+        }
+        machine->run();
+        machines.push_back(machine);
+    }
+
+    size_t after = resident_bytes();
+    if (after > 0) {
+        printf("  %-8s %4d instances %8.1f KB total %6.2f KB each, %zu shared ROM images (%zu bytes)\n",
+            shared ? "shared" : "private", INSTANCES, (after - before) / 1024.0, (after - before) / 1024.0 / INSTANCES,
+            rom_registry::get_count(), rom_registry::get_bytes());
+    } else {
+        printf("  %-8s resident set size not available on this system\n", shared ? "shared" : "private");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    printf("sizeof m6800_cpu_device %zu, MemoryMapManager %zu, machine %zu bytes\n",
+        sizeof(m6800_cpu_device), sizeof(MemoryMapManager), sizeof(Machine));
+
+    // both sets stay alive until the end, so neither run is measured in memory freed by the other
+    std::vector<Machine*> machines;
+    measure(true, machines);
+    measure(false, machines);
+
+    std::vector<Machine*>::iterator it = machines.begin();
+    while (it != machines.end()) {
+        delete *it;
+        it++;
+    }
+
+    if (rom_registry::get_count() != 0) {
+        printf("ROM images still alive after every machine was deleted\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,266 @@
+// license:BSD-3-Clause
+/*
+    Opcode list used by the switch and computed-goto dispatch loops in m6800.cpp
+
+    OP(opcode, handler, cycles)
+
+    This must stay in sync with m6800_insn and cycles_6800.
+*/
+
+#define M6800_OPCODES(OP) \
+    OP(0x00, illegl1, 5) \
+    OP(0x01, nop, 2) \
+    OP(0x02, illegl1, 5) \
+    OP(0x03, illegl1, 5) \
+    OP(0x04, illegl1, 5) \
+    OP(0x05, illegl1, 5) \
+    OP(0x06, tap, 2) \
+    OP(0x07, tpa, 2) \
+    OP(0x08, inx, 4) \
+    OP(0x09, dex, 4) \
+    OP(0x0a, clv, 2) \
+    OP(0x0b, sev, 2) \
+    OP(0x0c, clc, 2) \
+    OP(0x0d, sec, 2) \
+    OP(0x0e, cli, 2) \
+    OP(0x0f, sei, 2) \
+    OP(0x10, sba, 2) \
+    OP(0x11, cba, 2) \
+    OP(0x12, illegl1, 5) \
+    OP(0x13, illegl1, 5) \
+    OP(0x14, illegl1, 5) \
+    OP(0x15, illegl1, 5) \
+    OP(0x16, tab, 2) \
+    OP(0x17, tba, 2) \
+    OP(0x18, illegl1, 5) \
+    OP(0x19, daa, 2) \
+    OP(0x1a, illegl1, 5) \
+    OP(0x1b, aba, 2) \
+    OP(0x1c, illegl1, 5) \
+    OP(0x1d, illegl1, 5) \
+    OP(0x1e, illegl1, 5) \
+    OP(0x1f, illegl1, 5) \
+    OP(0x20, bra, 4) \
+    OP(0x21, brn, 4) \
+    OP(0x22, bhi, 4) \
+    OP(0x23, bls, 4) \
+    OP(0x24, bcc, 4) \
+    OP(0x25, bcs, 4) \
+    OP(0x26, bne, 4) \
+    OP(0x27, beq, 4) \
+    OP(0x28, bvc, 4) \
+    OP(0x29, bvs, 4) \
+    OP(0x2a, bpl, 4) \
+    OP(0x2b, bmi, 4) \
+    OP(0x2c, bge, 4) \
+    OP(0x2d, blt, 4) \
+    OP(0x2e, bgt, 4) \
+    OP(0x2f, ble, 4) \
+    OP(0x30, tsx, 4) \
+    OP(0x31, ins, 4) \
+    OP(0x32, pula, 4) \
+    OP(0x33, pulb, 4) \
+    OP(0x34, des, 4) \
+    OP(0x35, txs, 4) \
+    OP(0x36, psha, 4) \
+    OP(0x37, pshb, 4) \
+    OP(0x38, illegl1, 5) \
+    OP(0x39, rts, 5) \
+    OP(0x3a, illegl1, 5) \
+    OP(0x3b, rti, 10) \
+    OP(0x3c, illegl1, 5) \
+    OP(0x3d, illegl1, 5) \
+    OP(0x3e, wai, 9) \
+    OP(0x3f, swi, 12) \
+    OP(0x40, nega, 2) \
+    OP(0x41, illegl1, 5) \
+    OP(0x42, illegl1, 5) \
+    OP(0x43, coma, 2) \
+    OP(0x44, lsra, 2) \
+    OP(0x45, illegl1, 5) \
+    OP(0x46, rora, 2) \
+    OP(0x47, asra, 2) \
+    OP(0x48, asla, 2) \
+    OP(0x49, rola, 2) \
+    OP(0x4a, deca, 2) \
+    OP(0x4b, illegl1, 5) \
+    OP(0x4c, inca, 2) \
+    OP(0x4d, tsta, 2) \
+    OP(0x4e, illegl1, 5) \
+    OP(0x4f, clra, 2) \
+    OP(0x50, negb, 2) \
+    OP(0x51, illegl1, 5) \
+    OP(0x52, illegl1, 5) \
+    OP(0x53, comb, 2) \
+    OP(0x54, lsrb, 2) \
+    OP(0x55, illegl1, 5) \
+    OP(0x56, rorb, 2) \
+    OP(0x57, asrb, 2) \
+    OP(0x58, aslb, 2) \
+    OP(0x59, rolb, 2) \
+    OP(0x5a, decb, 2) \
+    OP(0x5b, illegl1, 5) \
+    OP(0x5c, incb, 2) \
+    OP(0x5d, tstb, 2) \
+    OP(0x5e, illegl1, 5) \
+    OP(0x5f, clrb, 2) \
+    OP(0x60, neg_ix, 7) \
+    OP(0x61, illegl2, 5) \
+    OP(0x62, illegl2, 5) \
+    OP(0x63, com_ix, 7) \
+    OP(0x64, lsr_ix, 7) \
+    OP(0x65, illegl2, 5) \
+    OP(0x66, ror_ix, 7) \
+    OP(0x67, asr_ix, 7) \
+    OP(0x68, asl_ix, 7) \
+    OP(0x69, rol_ix, 7) \
+    OP(0x6a, dec_ix, 7) \
+    OP(0x6b, illegl2, 5) \
+    OP(0x6c, inc_ix, 7) \
+    OP(0x6d, tst_ix, 7) \
+    OP(0x6e, jmp_ix, 4) \
+    OP(0x6f, clr_ix, 7) \
+    OP(0x70, neg_ex, 6) \
+    OP(0x71, illegl3, 5) \
+    OP(0x72, illegl3, 5) \
+    OP(0x73, com_ex, 6) \
+    OP(0x74, lsr_ex, 6) \
+    OP(0x75, illegl3, 5) \
+    OP(0x76, ror_ex, 6) \
+    OP(0x77, asr_ex, 6) \
+    OP(0x78, asl_ex, 6) \
+    OP(0x79, rol_ex, 6) \
+    OP(0x7a, dec_ex, 6) \
+    OP(0x7b, illegl3, 5) \
+    OP(0x7c, inc_ex, 6) \
+    OP(0x7d, tst_ex, 6) \
+    OP(0x7e, jmp_ex, 3) \
+    OP(0x7f, clr_ex, 6) \
+    OP(0x80, suba_im, 2) \
+    OP(0x81, cmpa_im, 2) \
+    OP(0x82, sbca_im, 2) \
+    OP(0x83, illegl2, 5) \
+    OP(0x84, anda_im, 2) \
+    OP(0x85, bita_im, 2) \
+    OP(0x86, lda_im, 2) \
+    OP(0x87, sta_im, 3) \
+    OP(0x88, eora_im, 2) \
+    OP(0x89, adca_im, 2) \
+    OP(0x8a, ora_im, 2) \
+    OP(0x8b, adda_im, 2) \
+    OP(0x8c, cmpx_im, 3) \
+    OP(0x8d, bsr, 8) \
+    OP(0x8e, lds_im, 3) \
+    OP(0x8f, sts_im, 4) \
+    OP(0x90, suba_di, 3) \
+    OP(0x91, cmpa_di, 3) \
+    OP(0x92, sbca_di, 3) \
+    OP(0x93, illegl2, 5) \
+    OP(0x94, anda_di, 3) \
+    OP(0x95, bita_di, 3) \
+    OP(0x96, lda_di, 3) \
+    OP(0x97, sta_di, 4) \
+    OP(0x98, eora_di, 3) \
+    OP(0x99, adca_di, 3) \
+    OP(0x9a, ora_di, 3) \
+    OP(0x9b, adda_di, 3) \
+    OP(0x9c, cmpx_di, 4) \
+    OP(0x9d, jsr_di, 6) \
+    OP(0x9e, lds_di, 4) \
+    OP(0x9f, sts_di, 5) \
+    OP(0xa0, suba_ix, 5) \
+    OP(0xa1, cmpa_ix, 5) \
+    OP(0xa2, sbca_ix, 5) \
+    OP(0xa3, illegl2, 5) \
+    OP(0xa4, anda_ix, 5) \
+    OP(0xa5, bita_ix, 5) \
+    OP(0xa6, lda_ix, 5) \
+    OP(0xa7, sta_ix, 6) \
+    OP(0xa8, eora_ix, 5) \
+    OP(0xa9, adca_ix, 5) \
+    OP(0xaa, ora_ix, 5) \
+    OP(0xab, adda_ix, 5) \
+    OP(0xac, cmpx_ix, 6) \
+    OP(0xad, jsr_ix, 8) \
+    OP(0xae, lds_ix, 6) \
+    OP(0xaf, sts_ix, 7) \
+    OP(0xb0, suba_ex, 4) \
+    OP(0xb1, cmpa_ex, 4) \
+    OP(0xb2, sbca_ex, 4) \
+    OP(0xb3, illegl3, 5) \
+    OP(0xb4, anda_ex, 4) \
+    OP(0xb5, bita_ex, 4) \
+    OP(0xb6, lda_ex, 4) \
+    OP(0xb7, sta_ex, 5) \
+    OP(0xb8, eora_ex, 4) \
+    OP(0xb9, adca_ex, 4) \
+    OP(0xba, ora_ex, 4) \
+    OP(0xbb, adda_ex, 4) \
+    OP(0xbc, cmpx_ex, 5) \
+    OP(0xbd, jsr_ex, 9) \
+    OP(0xbe, lds_ex, 5) \
+    OP(0xbf, sts_ex, 6) \
+    OP(0xc0, subb_im, 2) \
+    OP(0xc1, cmpb_im, 2) \
+    OP(0xc2, sbcb_im, 2) \
+    OP(0xc3, illegl2, 5) \
+    OP(0xc4, andb_im, 2) \
+    OP(0xc5, bitb_im, 2) \
+    OP(0xc6, ldb_im, 2) \
+    OP(0xc7, stb_im, 3) \
+    OP(0xc8, eorb_im, 2) \
+    OP(0xc9, adcb_im, 2) \
+    OP(0xca, orb_im, 2) \
+    OP(0xcb, addb_im, 2) \
+    OP(0xcc, illegl3, 5) \
+    OP(0xcd, illegl3, 5) \
+    OP(0xce, ldx_im, 3) \
+    OP(0xcf, stx_im, 4) \
+    OP(0xd0, subb_di, 3) \
+    OP(0xd1, cmpb_di, 3) \
+    OP(0xd2, sbcb_di, 3) \
+    OP(0xd3, illegl2, 5) \
+    OP(0xd4, andb_di, 3) \
+    OP(0xd5, bitb_di, 3) \
+    OP(0xd6, ldb_di, 3) \
+    OP(0xd7, stb_di, 4) \
+    OP(0xd8, eorb_di, 3) \
+    OP(0xd9, adcb_di, 3) \
+    OP(0xda, orb_di, 3) \
+    OP(0xdb, addb_di, 3) \
+    OP(0xdc, illegl2, 5) \
+    OP(0xdd, illegl2, 5) \
+    OP(0xde, ldx_di, 4) \
+    OP(0xdf, stx_di, 5) \
+    OP(0xe0, subb_ix, 5) \
+    OP(0xe1, cmpb_ix, 5) \
+    OP(0xe2, sbcb_ix, 5) \
+    OP(0xe3, illegl2, 5) \
+    OP(0xe4, andb_ix, 5) \
+    OP(0xe5, bitb_ix, 5) \
+    OP(0xe6, ldb_ix, 5) \
+    OP(0xe7, stb_ix, 6) \
+    OP(0xe8, eorb_ix, 5) \
+    OP(0xe9, adcb_ix, 5) \
+    OP(0xea, orb_ix, 5) \
+    OP(0xeb, addb_ix, 5) \
+    OP(0xec, illegl2, 5) \
+    OP(0xed, illegl2, 5) \
+    OP(0xee, ldx_ix, 6) \
+    OP(0xef, stx_ix, 7) \
+    OP(0xf0, subb_ex, 4) \
+    OP(0xf1, cmpb_ex, 4) \
+    OP(0xf2, sbcb_ex, 4) \
+    OP(0xf3, illegl3, 5) \
+    OP(0xf4, andb_ex, 4) \
+    OP(0xf5, bitb_ex, 4) \
+    OP(0xf6, ldb_ex, 4) \
+    OP(0xf7, stb_ex, 5) \
+    OP(0xf8, eorb_ex, 4) \
+    OP(0xf9, adcb_ex, 4) \
+    OP(0xfa, orb_ex, 4) \
+    OP(0xfb, addb_ex, 4) \
+    OP(0xfc, illegl3, 5) \
+    OP(0xfd, illegl3, 5) \
+    OP(0xfe, ldx_ex, 5) \
+    OP(0xff, stx_ex, 6)
@@ -72,8 +72,7 @@ OP_HANDLER(asld) {
     uint16_t t;
     t = D;
     r = t << 1;
-    CLR_NZVC;
-    SET_FLAGS16(t, t, r);
+    FLAGS_NZVC16(t, t, r);
     D = r;
 }
 
@@ -141,8 +140,7 @@ OP_HANDLER(sei) {
 OP_HANDLER(sba) {
     uint16_t t;
     t = A - B;
-    CLR_NZVC;
-    SET_FLAGS8(A, B, t);
+    FLAGS_NZVC8(A, B, t);
     A = t;
 }
 
@@ -150,8 +148,7 @@ OP_HANDLER(sba) {
 OP_HANDLER(cba) {
     uint16_t t;
     t = A - B;
-    CLR_NZVC;
-    SET_FLAGS8(A, B, t);
+    FLAGS_NZVC8(A, B, t);
 }
 
 /* $12 ILLEGAL */
@@ -171,15 +168,13 @@ OP_HANDLER(undoc2) {
 /* $16 TAB inherent -**0- */
 OP_HANDLER(tab) {
     B = A;
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $17 TBA inherent -**0- */
 OP_HANDLER(tba) {
     A = B;
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $18 XGDX inherent ----- */ /* HD63701YO only */
@@ -221,9 +216,7 @@ OP_HANDLER(slp) {
 OP_HANDLER(aba) {
     uint16_t t;
     t = A + B;
-    CLR_HNZVC;
-    SET_FLAGS8(A, B, t);
-    SET_H(A, B, t);
+    FLAGS_HNZVC8(A, B, t);
     A = t;
 }
 
@@ -443,8 +436,7 @@ OP_HANDLER(swi) {
 OP_HANDLER(nega) {
     uint16_t r;
     r = -A;
-    CLR_NZVC;
-    SET_FLAGS8(0, A, r);
+    FLAGS_NZVC8(0, A, r);
     A = r;
 }
 
@@ -500,8 +492,7 @@ OP_HANDLER(asra) {
 OP_HANDLER(asla) {
     uint16_t r;
     r = A << 1;
-    CLR_NZVC;
-    SET_FLAGS8(A, A, r);
+    FLAGS_NZVC8(A, A, r);
     A = r;
 }
 
@@ -511,16 +502,14 @@ OP_HANDLER(rola) {
     t = A;
     r = CC & 0x01;
     r |= t << 1;
-    CLR_NZVC;
-    SET_FLAGS8(t, t, r);
+    FLAGS_NZVC8(t, t, r);
     A = r;
 }
 
 /* $4a DECA inherent -***- */
 OP_HANDLER(deca) {
     --A;
-    CLR_NZV;
-    SET_FLAGS8D(A);
+    FLAGS_DEC8(A);
 }
 
 /* $4b ILLEGAL */
@@ -528,14 +517,12 @@ OP_HANDLER(deca) {
 /* $4c INCA inherent -***- */
 OP_HANDLER(inca) {
     ++A;
-    CLR_NZV;
-    SET_FLAGS8I(A);
+    FLAGS_INC8(A);
 }
 
 /* $4d TSTA inherent -**0- */
 OP_HANDLER(tsta) {
-    CLR_NZVC;
-    SET_NZ8(A);
+    FLAGS_TST8(A);
 }
 
 /* $4e ILLEGAL */
@@ -551,8 +538,7 @@ OP_HANDLER(clra) {
 OP_HANDLER(negb) {
     uint16_t r;
     r = -B;
-    CLR_NZVC;
-    SET_FLAGS8(0, B, r);
+    FLAGS_NZVC8(0, B, r);
     B = r;
 }
 
@@ -608,8 +594,7 @@ OP_HANDLER(asrb) {
 OP_HANDLER(aslb) {
     uint16_t r;
     r = B << 1;
-    CLR_NZVC;
-    SET_FLAGS8(B, B, r);
+    FLAGS_NZVC8(B, B, r);
     B = r;
 }
 
@@ -619,16 +604,14 @@ OP_HANDLER(rolb) {
     t = B;
     r = CC & 0x01;
     r |= t << 1;
-    CLR_NZVC;
-    SET_FLAGS8(t, t, r);
+    FLAGS_NZVC8(t, t, r);
     B = r;
 }
 
 /* $5a DECB inherent -***- */
 OP_HANDLER(decb) {
     --B;
-    CLR_NZV;
-    SET_FLAGS8D(B);
+    FLAGS_DEC8(B);
 }
 
 /* $5b ILLEGAL */
@@ -636,14 +619,12 @@ OP_HANDLER(decb) {
 /* $5c INCB inherent -***- */
 OP_HANDLER(incb) {
     ++B;
-    CLR_NZV;
-    SET_FLAGS8I(B);
+    FLAGS_INC8(B);
 }
 
 /* $5d TSTB inherent -**0- */
 OP_HANDLER(tstb) {
-    CLR_NZVC;
-    SET_NZ8(B);
+    FLAGS_TST8(B);
 }
 
 /* $5e ILLEGAL */
@@ -660,8 +641,7 @@ OP_HANDLER(neg_ix) {
     uint16_t r, t;
     IDXBYTE(t);
     r = -t;
-    CLR_NZVC;
-    SET_FLAGS8(0, t, r);
+    FLAGS_NZVC8(0, t, r);
     WM(EAD, r);
 }
 
@@ -671,8 +651,7 @@ OP_HANDLER(aim_ix) {
     IMMBYTE(t);
     IDXBYTE(r);
     r &= t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
     WM(EAD, r);
 }
 
@@ -682,8 +661,7 @@ OP_HANDLER(oim_ix) {
     IMMBYTE(t);
     IDXBYTE(r);
     r |= t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
     WM(EAD, r);
 }
 
@@ -717,8 +695,7 @@ OP_HANDLER(eim_ix) {
     IMMBYTE(t);
     IDXBYTE(r);
     r ^= t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
     WM(EAD, r);
 }
 
@@ -755,8 +732,7 @@ OP_HANDLER(asl_ix) {
     uint16_t t, r;
     IDXBYTE(t);
     r = t << 1;
-    CLR_NZVC;
-    SET_FLAGS8(t, t, r);
+    FLAGS_NZVC8(t, t, r);
     WM(EAD, r);
 }
 
@@ -766,8 +742,7 @@ OP_HANDLER(rol_ix) {
     IDXBYTE(t);
     r = CC & 0x01;
     r |= t << 1;
-    CLR_NZVC;
-    SET_FLAGS8(t, t, r);
+    FLAGS_NZVC8(t, t, r);
     WM(EAD, r);
 }
 
@@ -776,8 +751,7 @@ OP_HANDLER(dec_ix) {
     uint8_t t;
     IDXBYTE(t);
     --t;
-    CLR_NZV;
-    SET_FLAGS8D(t);
+    FLAGS_DEC8(t);
     WM(EAD, t);
 }
 
@@ -787,8 +761,7 @@ OP_HANDLER(tim_ix) {
     IMMBYTE(t);
     IDXBYTE(r);
     r &= t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
 }
 
 /* $6c INC indexed -***- */
@@ -796,8 +769,7 @@ OP_HANDLER(inc_ix) {
     uint8_t t;
     IDXBYTE(t);
     ++t;
-    CLR_NZV;
-    SET_FLAGS8I(t);
+    FLAGS_INC8(t);
     WM(EAD, t);
 }
 
@@ -805,8 +777,7 @@ OP_HANDLER(inc_ix) {
 OP_HANDLER(tst_ix) {
     uint8_t t;
     IDXBYTE(t);
-    CLR_NZVC;
-    SET_NZ8(t);
+    FLAGS_TST8(t);
 }
 
 /* $6e JMP indexed ----- */
@@ -828,8 +799,7 @@ OP_HANDLER(neg_ex) {
     uint16_t r, t;
     EXTBYTE(t);
     r = -t;
-    CLR_NZVC;
-    SET_FLAGS8(0, t, r);
+    FLAGS_NZVC8(0, t, r);
     WM(EAD, r);
 }
 
@@ -839,8 +809,7 @@ OP_HANDLER(aim_di) {
     IMMBYTE(t);
     DIRBYTE(r);
     r &= t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
     WM(EAD, r);
 }
 
@@ -850,8 +819,7 @@ OP_HANDLER(oim_di) {
     IMMBYTE(t);
     DIRBYTE(r);
     r |= t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
     WM(EAD, r);
 }
 
@@ -885,8 +853,7 @@ OP_HANDLER(eim_di) {
     IMMBYTE(t);
     DIRBYTE(r);
     r ^= t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
     WM(EAD, r);
 }
 
@@ -923,8 +890,7 @@ OP_HANDLER(asl_ex) {
     uint16_t t, r;
     EXTBYTE(t);
     r = t << 1;
-    CLR_NZVC;
-    SET_FLAGS8(t, t, r);
+    FLAGS_NZVC8(t, t, r);
     WM(EAD, r);
 }
 
@@ -934,8 +900,7 @@ OP_HANDLER(rol_ex) {
     EXTBYTE(t);
     r = CC & 0x01;
     r |= t << 1;
-    CLR_NZVC;
-    SET_FLAGS8(t, t, r);
+    FLAGS_NZVC8(t, t, r);
     WM(EAD, r);
 }
 
@@ -944,8 +909,7 @@ OP_HANDLER(dec_ex) {
     uint8_t t;
     EXTBYTE(t);
     --t;
-    CLR_NZV;
-    SET_FLAGS8D(t);
+    FLAGS_DEC8(t);
     WM(EAD, t);
 }
 
@@ -955,8 +919,7 @@ OP_HANDLER(tim_di) {
     IMMBYTE(t);
     DIRBYTE(r);
     r &= t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
 }
 
 /* $7c INC extended -***- */
@@ -964,8 +927,7 @@ OP_HANDLER(inc_ex) {
     uint8_t t;
     EXTBYTE(t);
     ++t;
-    CLR_NZV;
-    SET_FLAGS8I(t);
+    FLAGS_INC8(t);
     WM(EAD, t);
 }
 
@@ -973,8 +935,7 @@ OP_HANDLER(inc_ex) {
 OP_HANDLER(tst_ex) {
     uint8_t t;
     EXTBYTE(t);
-    CLR_NZVC;
-    SET_NZ8(t);
+    FLAGS_TST8(t);
 }
 
 /* $7e JMP extended ----- */
@@ -996,8 +957,7 @@ OP_HANDLER(suba_im) {
     uint16_t t, r;
     IMMBYTE(t);
     r = A - t;
-    CLR_NZVC;
-    SET_FLAGS8(A, t, r);
+    FLAGS_NZVC8(A, t, r);
     A = r;
 }
 
@@ -1006,8 +966,7 @@ OP_HANDLER(cmpa_im) {
     uint16_t t, r;
     IMMBYTE(t);
     r = A - t;
-    CLR_NZVC;
-    SET_FLAGS8(A, t, r);
+    FLAGS_NZVC8(A, t, r);
 }
 
 /* $82 SBCA immediate ?**** */
@@ -1015,8 +974,7 @@ OP_HANDLER(sbca_im) {
     uint16_t t, r;
     IMMBYTE(t);
     r = A - t - (CC & 0x01);
-    CLR_NZVC;
-    SET_FLAGS8(A, t, r);
+    FLAGS_NZVC8(A, t, r);
     A = r;
 }
 
@@ -1027,8 +985,7 @@ OP_HANDLER(subd_im) {
     IMMWORD(b);
     d = D;
     r = d - b.d;
-    CLR_NZVC;
-    SET_FLAGS16(d, b.d, r);
+    FLAGS_NZVC16(d, b.d, r);
     D = r;
 }
 
@@ -1037,8 +994,7 @@ OP_HANDLER(anda_im) {
     uint8_t t;
     IMMBYTE(t);
     A &= t;
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $85 BITA immediate -**0- */
@@ -1046,22 +1002,19 @@ OP_HANDLER(bita_im) {
     uint8_t t, r;
     IMMBYTE(t);
     r = A & t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
 }
 
 /* $86 LDA immediate -**0- */
 OP_HANDLER(lda_im) {
     IMMBYTE(A);
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* is this a legal instruction? */
 /* $87 STA immediate -**0- */
 OP_HANDLER(sta_im) {
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
     IMM8;
     WM(EAD, A);
 }
@@ -1071,8 +1024,7 @@ OP_HANDLER(eora_im) {
     uint8_t t;
     IMMBYTE(t);
     A ^= t;
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $89 ADCA immediate ***** */
@@ -1080,9 +1032,7 @@ OP_HANDLER(adca_im) {
     uint16_t t, r;
     IMMBYTE(t);
     r = A + t + (CC & 0x01);
-    CLR_HNZVC;
-    SET_FLAGS8(A, t, r);
-    SET_H(A, t, r);
+    FLAGS_HNZVC8(A, t, r);
     A = r;
 }
 
@@ -1091,8 +1041,7 @@ OP_HANDLER(ora_im) {
     uint8_t t;
     IMMBYTE(t);
     A |= t;
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $8b ADDA immediate ***** */
@@ -1100,9 +1049,7 @@ OP_HANDLER(adda_im) {
     uint16_t t, r;
     IMMBYTE(t);
     r = A + t;
-    CLR_HNZVC;
-    SET_FLAGS8(A, t, r);
-    SET_H(A, t, r);
+    FLAGS_HNZVC8(A, t, r);
     A = r;
 }
 
@@ -1126,8 +1073,7 @@ OP_HANDLER(cpx_im) {
     IMMWORD(b);
     d = X;
     r = d - b.d;
-    CLR_NZVC;
-    SET_FLAGS16(d, b.d, r);
+    FLAGS_NZVC16(d, b.d, r);
 }
 
 /* $8d BSR ----- */
@@ -1141,14 +1087,12 @@ OP_HANDLER(bsr) {
 /* $8e LDS immediate -**0- */
 OP_HANDLER(lds_im) {
     IMMWORD(m_s);
-    CLR_NZV;
-    SET_NZ16(S);
+    FLAGS_NZ16(S);
 }
 
 /* $8f STS immediate -**0- */
 OP_HANDLER(sts_im) {
-    CLR_NZV;
-    SET_NZ16(S);
+    FLAGS_NZ16(S);
     IMM16;
     WM16(EAD, &m_s);
 }
@@ -1158,8 +1102,7 @@ OP_HANDLER(suba_di) {
     uint16_t t, r;
     DIRBYTE(t);
     r = A - t;
-    CLR_NZVC;
-    SET_FLAGS8(A, t, r);
+    FLAGS_NZVC8(A, t, r);
     A = r;
 }
 
@@ -1168,8 +1111,7 @@ OP_HANDLER(cmpa_di) {
     uint16_t t, r;
     DIRBYTE(t);
     r = A - t;
-    CLR_NZVC;
-    SET_FLAGS8(A, t, r);
+    FLAGS_NZVC8(A, t, r);
 }
 
 /* $92 SBCA direct ?**** */
@@ -1177,8 +1119,7 @@ OP_HANDLER(sbca_di) {
     uint16_t t, r;
     DIRBYTE(t);
     r = A - t - (CC & 0x01);
-    CLR_NZVC;
-    SET_FLAGS8(A, t, r);
+    FLAGS_NZVC8(A, t, r);
     A = r;
 }
 
@@ -1189,8 +1130,7 @@ OP_HANDLER(subd_di) {
     DIRWORD(b);
     d = D;
     r = d - b.d;
-    CLR_NZVC;
-    SET_FLAGS16(d, b.d, r);
+    FLAGS_NZVC16(d, b.d, r);
     D = r;
 }
 
@@ -1199,8 +1139,7 @@ OP_HANDLER(anda_di) {
     uint8_t t;
     DIRBYTE(t);
     A &= t;
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $95 BITA direct -**0- */
@@ -1208,21 +1147,18 @@ OP_HANDLER(bita_di) {
     uint8_t t, r;
     DIRBYTE(t);
     r = A & t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
 }
 
 /* $96 LDA direct -**0- */
 OP_HANDLER(lda_di) {
     DIRBYTE(A);
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $97 STA direct -**0- */
 OP_HANDLER(sta_di) {
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
     DIRECT;
     WM(EAD, A);
 }
@@ -1232,8 +1168,7 @@ OP_HANDLER(eora_di) {
     uint8_t t;
     DIRBYTE(t);
     A ^= t;
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $99 ADCA direct ***** */
@@ -1241,9 +1176,7 @@ OP_HANDLER(adca_di) {
     uint16_t t, r;
     DIRBYTE(t);
     r = A + t + (CC & 0x01);
-    CLR_HNZVC;
-    SET_FLAGS8(A, t, r);
-    SET_H(A, t, r);
+    FLAGS_HNZVC8(A, t, r);
     A = r;
 }
 
@@ -1252,8 +1185,7 @@ OP_HANDLER(ora_di) {
     uint8_t t;
     DIRBYTE(t);
     A |= t;
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $9b ADDA direct ***** */
@@ -1261,9 +1193,7 @@ OP_HANDLER(adda_di) {
     uint16_t t, r;
     DIRBYTE(t);
     r = A + t;
-    CLR_HNZVC;
-    SET_FLAGS8(A, t, r);
-    SET_H(A, t, r);
+    FLAGS_HNZVC8(A, t, r);
     A = r;
 }
 
@@ -1287,8 +1217,7 @@ OP_HANDLER(cpx_di) {
     DIRWORD(b);
     d = X;
     r = d - b.d;
-    CLR_NZVC;
-    SET_FLAGS16(d, b.d, r);
+    FLAGS_NZVC16(d, b.d, r);
 }
 
 /* $9d JSR direct ----- */
@@ -1301,14 +1230,12 @@ OP_HANDLER(jsr_di) {
 /* $9e LDS direct -**0- */
 OP_HANDLER(lds_di) {
     DIRWORD(m_s);
-    CLR_NZV;
-    SET_NZ16(S);
+    FLAGS_NZ16(S);
 }
 
 /* $9f STS direct -**0- */
 OP_HANDLER(sts_di) {
-    CLR_NZV;
-    SET_NZ16(S);
+    FLAGS_NZ16(S);
     DIRECT;
     WM16(EAD, &m_s);
 }
@@ -1318,8 +1245,7 @@ OP_HANDLER(suba_ix) {
     uint16_t t, r;
     IDXBYTE(t);
     r = A - t;
-    CLR_NZVC;
-    SET_FLAGS8(A, t, r);
+    FLAGS_NZVC8(A, t, r);
     A = r;
 }
 
@@ -1328,8 +1254,7 @@ OP_HANDLER(cmpa_ix) {
     uint16_t t, r;
     IDXBYTE(t);
     r = A - t;
-    CLR_NZVC;
-    SET_FLAGS8(A, t, r);
+    FLAGS_NZVC8(A, t, r);
 }
 
 /* $a2 SBCA indexed ?**** */
@@ -1337,8 +1262,7 @@ OP_HANDLER(sbca_ix) {
     uint16_t t, r;
     IDXBYTE(t);
     r = A - t - (CC & 0x01);
-    CLR_NZVC;
-    SET_FLAGS8(A, t, r);
+    FLAGS_NZVC8(A, t, r);
     A = r;
 }
 
@@ -1349,8 +1273,7 @@ OP_HANDLER(subd_ix) {
     IDXWORD(b);
     d = D;
     r = d - b.d;
-    CLR_NZVC;
-    SET_FLAGS16(d, b.d, r);
+    FLAGS_NZVC16(d, b.d, r);
     D = r;
 }
 
@@ -1359,8 +1282,7 @@ OP_HANDLER(anda_ix) {
     uint8_t t;
     IDXBYTE(t);
     A &= t;
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $a5 BITA indexed -**0- */
@@ -1368,21 +1290,18 @@ OP_HANDLER(bita_ix) {
     uint8_t t, r;
     IDXBYTE(t);
     r = A & t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
 }
 
 /* $a6 LDA indexed -**0- */
 OP_HANDLER(lda_ix) {
     IDXBYTE(A);
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $a7 STA indexed -**0- */
 OP_HANDLER(sta_ix) {
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
     INDEXED;
     WM(EAD, A);
 }
@@ -1392,8 +1311,7 @@ OP_HANDLER(eora_ix) {
     uint8_t t;
     IDXBYTE(t);
     A ^= t;
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $a9 ADCA indexed ***** */
@@ -1401,9 +1319,7 @@ OP_HANDLER(adca_ix) {
     uint16_t t, r;
     IDXBYTE(t);
     r = A + t + (CC & 0x01);
-    CLR_HNZVC;
-    SET_FLAGS8(A, t, r);
-    SET_H(A, t, r);
+    FLAGS_HNZVC8(A, t, r);
     A = r;
 }
 
@@ -1412,8 +1328,7 @@ OP_HANDLER(ora_ix) {
     uint8_t t;
     IDXBYTE(t);
     A |= t;
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $ab ADDA indexed ***** */
@@ -1421,9 +1336,7 @@ OP_HANDLER(adda_ix) {
     uint16_t t, r;
     IDXBYTE(t);
     r = A + t;
-    CLR_HNZVC;
-    SET_FLAGS8(A, t, r);
-    SET_H(A, t, r);
+    FLAGS_HNZVC8(A, t, r);
     A = r;
 }
 
@@ -1447,8 +1360,7 @@ OP_HANDLER(cpx_ix) {
     IDXWORD(b);
     d = X;
     r = d - b.d;
-    CLR_NZVC;
-    SET_FLAGS16(d, b.d, r);
+    FLAGS_NZVC16(d, b.d, r);
 }
 
 /* $ad JSR indexed ----- */
@@ -1461,14 +1373,12 @@ OP_HANDLER(jsr_ix) {
 /* $ae LDS indexed -**0- */
 OP_HANDLER(lds_ix) {
     IDXWORD(m_s);
-    CLR_NZV;
-    SET_NZ16(S);
+    FLAGS_NZ16(S);
 }
 
 /* $af STS indexed -**0- */
 OP_HANDLER(sts_ix) {
-    CLR_NZV;
-    SET_NZ16(S);
+    FLAGS_NZ16(S);
     INDEXED;
     WM16(EAD, &m_s);
 }
@@ -1478,8 +1388,7 @@ OP_HANDLER(suba_ex) {
     uint16_t t, r;
     EXTBYTE(t);
     r = A - t;
-    CLR_NZVC;
-    SET_FLAGS8(A, t, r);
+    FLAGS_NZVC8(A, t, r);
     A = r;
 }
 
@@ -1488,8 +1397,7 @@ OP_HANDLER(cmpa_ex) {
     uint16_t t, r;
     EXTBYTE(t);
     r = A - t;
-    CLR_NZVC;
-    SET_FLAGS8(A, t, r);
+    FLAGS_NZVC8(A, t, r);
 }
 
 /* $b2 SBCA extended ?**** */
@@ -1497,8 +1405,7 @@ OP_HANDLER(sbca_ex) {
     uint16_t t, r;
     EXTBYTE(t);
     r = A - t - (CC & 0x01);
-    CLR_NZVC;
-    SET_FLAGS8(A, t, r);
+    FLAGS_NZVC8(A, t, r);
     A = r;
 }
 
@@ -1509,8 +1416,7 @@ OP_HANDLER(subd_ex) {
     EXTWORD(b);
     d = D;
     r = d - b.d;
-    CLR_NZVC;
-    SET_FLAGS16(d, b.d, r);
+    FLAGS_NZVC16(d, b.d, r);
     D = r;
 }
 
@@ -1519,8 +1425,7 @@ OP_HANDLER(anda_ex) {
     uint8_t t;
     EXTBYTE(t);
     A &= t;
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $b5 BITA extended -**0- */
@@ -1528,21 +1433,18 @@ OP_HANDLER(bita_ex) {
     uint8_t t, r;
     EXTBYTE(t);
     r = A & t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
 }
 
 /* $b6 LDA extended -**0- */
 OP_HANDLER(lda_ex) {
     EXTBYTE(A);
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $b7 STA extended -**0- */
 OP_HANDLER(sta_ex) {
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
     EXTENDED;
     WM(EAD, A);
 }
@@ -1552,8 +1454,7 @@ OP_HANDLER(eora_ex) {
     uint8_t t;
     EXTBYTE(t);
     A ^= t;
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $b9 ADCA extended ***** */
@@ -1561,9 +1462,7 @@ OP_HANDLER(adca_ex) {
     uint16_t t, r;
     EXTBYTE(t);
     r = A + t + (CC & 0x01);
-    CLR_HNZVC;
-    SET_FLAGS8(A, t, r);
-    SET_H(A, t, r);
+    FLAGS_HNZVC8(A, t, r);
     A = r;
 }
 
@@ -1572,8 +1471,7 @@ OP_HANDLER(ora_ex) {
     uint8_t t;
     EXTBYTE(t);
     A |= t;
-    CLR_NZV;
-    SET_NZ8(A);
+    FLAGS_NZ8(A);
 }
 
 /* $bb ADDA extended ***** */
@@ -1581,9 +1479,7 @@ OP_HANDLER(adda_ex) {
     uint16_t t, r;
     EXTBYTE(t);
     r = A + t;
-    CLR_HNZVC;
-    SET_FLAGS8(A, t, r);
-    SET_H(A, t, r);
+    FLAGS_HNZVC8(A, t, r);
     A = r;
 }
 
@@ -1607,8 +1503,7 @@ OP_HANDLER(cpx_ex) {
     EXTWORD(b);
     d = X;
     r = d - b.d;
-    CLR_NZVC;
-    SET_FLAGS16(d, b.d, r);
+    FLAGS_NZVC16(d, b.d, r);
 }
 
 /* $bd JSR extended ----- */
@@ -1621,14 +1516,12 @@ OP_HANDLER(jsr_ex) {
 /* $be LDS extended -**0- */
 OP_HANDLER(lds_ex) {
     EXTWORD(m_s);
-    CLR_NZV;
-    SET_NZ16(S);
+    FLAGS_NZ16(S);
 }
 
 /* $bf STS extended -**0- */
 OP_HANDLER(sts_ex) {
-    CLR_NZV;
-    SET_NZ16(S);
+    FLAGS_NZ16(S);
     EXTENDED;
     WM16(EAD, &m_s);
 }
@@ -1638,8 +1531,7 @@ OP_HANDLER(subb_im) {
     uint16_t t, r;
     IMMBYTE(t);
     r = B - t;
-    CLR_NZVC;
-    SET_FLAGS8(B, t, r);
+    FLAGS_NZVC8(B, t, r);
     B = r;
 }
 
@@ -1648,8 +1540,7 @@ OP_HANDLER(cmpb_im) {
     uint16_t t, r;
     IMMBYTE(t);
     r = B - t;
-    CLR_NZVC;
-    SET_FLAGS8(B, t, r);
+    FLAGS_NZVC8(B, t, r);
 }
 
 /* $c2 SBCB immediate ?**** */
@@ -1657,8 +1548,7 @@ OP_HANDLER(sbcb_im) {
     uint16_t t, r;
     IMMBYTE(t);
     r = B - t - (CC & 0x01);
-    CLR_NZVC;
-    SET_FLAGS8(B, t, r);
+    FLAGS_NZVC8(B, t, r);
     B = r;
 }
 
@@ -1669,8 +1559,7 @@ OP_HANDLER(addd_im) {
     IMMWORD(b);
     d = D;
     r = d + b.d;
-    CLR_NZVC;
-    SET_FLAGS16(d, b.d, r);
+    FLAGS_NZVC16(d, b.d, r);
     D = r;
 }
 
@@ -1679,8 +1568,7 @@ OP_HANDLER(andb_im) {
     uint8_t t;
     IMMBYTE(t);
     B &= t;
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $c5 BITB immediate -**0- */
@@ -1688,22 +1576,19 @@ OP_HANDLER(bitb_im) {
     uint8_t t, r;
     IMMBYTE(t);
     r = B & t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
 }
 
 /* $c6 LDB immediate -**0- */
 OP_HANDLER(ldb_im) {
     IMMBYTE(B);
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* is this a legal instruction? */
 /* $c7 STB immediate -**0- */
 OP_HANDLER(stb_im) {
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
     IMM8;
     WM(EAD, B);
 }
@@ -1713,8 +1598,7 @@ OP_HANDLER(eorb_im) {
     uint8_t t;
     IMMBYTE(t);
     B ^= t;
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $c9 ADCB immediate ***** */
@@ -1722,9 +1606,7 @@ OP_HANDLER(adcb_im) {
     uint16_t t, r;
     IMMBYTE(t);
     r = B + t + (CC & 0x01);
-    CLR_HNZVC;
-    SET_FLAGS8(B, t, r);
-    SET_H(B, t, r);
+    FLAGS_HNZVC8(B, t, r);
     B = r;
 }
 
@@ -1733,8 +1615,7 @@ OP_HANDLER(orb_im) {
     uint8_t t;
     IMMBYTE(t);
     B |= t;
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $cb ADDB immediate ***** */
@@ -1742,39 +1623,33 @@ OP_HANDLER(addb_im) {
     uint16_t t, r;
     IMMBYTE(t);
     r = B + t;
-    CLR_HNZVC;
-    SET_FLAGS8(B, t, r);
-    SET_H(B, t, r);
+    FLAGS_HNZVC8(B, t, r);
     B = r;
 }
 
 /* $CC LDD immediate -**0- */
 OP_HANDLER(ldd_im) {
     IMMWORD(m_d);
-    CLR_NZV;
-    SET_NZ16(D);
+    FLAGS_NZ16(D);
 }
 
 /* is this a legal instruction? */
 /* $cd STD immediate -**0- */
 OP_HANDLER(std_im) {
     IMM16;
-    CLR_NZV;
-    SET_NZ16(D);
+    FLAGS_NZ16(D);
     WM16(EAD, &m_d);
 }
 
 /* $ce LDX immediate -**0- */
 OP_HANDLER(ldx_im) {
     IMMWORD(m_x);
-    CLR_NZV;
-    SET_NZ16(X);
+    FLAGS_NZ16(X);
 }
 
 /* $cf STX immediate -**0- */
 OP_HANDLER(stx_im) {
-    CLR_NZV;
-    SET_NZ16(X);
+    FLAGS_NZ16(X);
     IMM16;
     WM16(EAD, &m_x);
 }
@@ -1784,8 +1659,7 @@ OP_HANDLER(subb_di) {
     uint16_t t, r;
     DIRBYTE(t);
     r = B - t;
-    CLR_NZVC;
-    SET_FLAGS8(B, t, r);
+    FLAGS_NZVC8(B, t, r);
     B = r;
 }
 
@@ -1794,8 +1668,7 @@ OP_HANDLER(cmpb_di) {
     uint16_t t, r;
     DIRBYTE(t);
     r = B - t;
-    CLR_NZVC;
-    SET_FLAGS8(B, t, r);
+    FLAGS_NZVC8(B, t, r);
 }
 
 /* $d2 SBCB direct ?**** */
@@ -1803,8 +1676,7 @@ OP_HANDLER(sbcb_di) {
     uint16_t t, r;
     DIRBYTE(t);
     r = B - t - (CC & 0x01);
-    CLR_NZVC;
-    SET_FLAGS8(B, t, r);
+    FLAGS_NZVC8(B, t, r);
     B = r;
 }
 
@@ -1815,8 +1687,7 @@ OP_HANDLER(addd_di) {
     DIRWORD(b);
     d = D;
     r = d + b.d;
-    CLR_NZVC;
-    SET_FLAGS16(d, b.d, r);
+    FLAGS_NZVC16(d, b.d, r);
     D = r;
 }
 
@@ -1825,8 +1696,7 @@ OP_HANDLER(andb_di) {
     uint8_t t;
     DIRBYTE(t);
     B &= t;
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $d5 BITB direct -**0- */
@@ -1834,21 +1704,18 @@ OP_HANDLER(bitb_di) {
     uint8_t t, r;
     DIRBYTE(t);
     r = B & t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
 }
 
 /* $d6 LDB direct -**0- */
 OP_HANDLER(ldb_di) {
     DIRBYTE(B);
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $d7 STB direct -**0- */
 OP_HANDLER(stb_di) {
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
     DIRECT;
     WM(EAD, B);
 }
@@ -1858,8 +1725,7 @@ OP_HANDLER(eorb_di) {
     uint8_t t;
     DIRBYTE(t);
     B ^= t;
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $d9 ADCB direct ***** */
@@ -1867,9 +1733,7 @@ OP_HANDLER(adcb_di) {
     uint16_t t, r;
     DIRBYTE(t);
     r = B + t + (CC & 0x01);
-    CLR_HNZVC;
-    SET_FLAGS8(B, t, r);
-    SET_H(B, t, r);
+    FLAGS_HNZVC8(B, t, r);
     B = r;
 }
 
@@ -1878,8 +1742,7 @@ OP_HANDLER(orb_di) {
     uint8_t t;
     DIRBYTE(t);
     B |= t;
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $db ADDB direct ***** */
@@ -1887,38 +1750,32 @@ OP_HANDLER(addb_di) {
     uint16_t t, r;
     DIRBYTE(t);
     r = B + t;
-    CLR_HNZVC;
-    SET_FLAGS8(B, t, r);
-    SET_H(B, t, r);
+    FLAGS_HNZVC8(B, t, r);
     B = r;
 }
 
 /* $dc LDD direct -**0- */
 OP_HANDLER(ldd_di) {
     DIRWORD(m_d);
-    CLR_NZV;
-    SET_NZ16(D);
+    FLAGS_NZ16(D);
 }
 
 /* $dd STD direct -**0- */
 OP_HANDLER(std_di) {
     DIRECT;
-    CLR_NZV;
-    SET_NZ16(D);
+    FLAGS_NZ16(D);
     WM16(EAD, &m_d);
 }
 
 /* $de LDX direct -**0- */
 OP_HANDLER(ldx_di) {
     DIRWORD(m_x);
-    CLR_NZV;
-    SET_NZ16(X);
+    FLAGS_NZ16(X);
 }
 
 /* $dF STX direct -**0- */
 OP_HANDLER(stx_di) {
-    CLR_NZV;
-    SET_NZ16(X);
+    FLAGS_NZ16(X);
     DIRECT;
     WM16(EAD, &m_x);
 }
@@ -1928,8 +1785,7 @@ OP_HANDLER(subb_ix) {
     uint16_t t, r;
     IDXBYTE(t);
     r = B - t;
-    CLR_NZVC;
-    SET_FLAGS8(B, t, r);
+    FLAGS_NZVC8(B, t, r);
     B = r;
 }
 
@@ -1938,8 +1794,7 @@ OP_HANDLER(cmpb_ix) {
     uint16_t t, r;
     IDXBYTE(t);
     r = B - t;
-    CLR_NZVC;
-    SET_FLAGS8(B, t, r);
+    FLAGS_NZVC8(B, t, r);
 }
 
 /* $e2 SBCB indexed ?**** */
@@ -1947,8 +1802,7 @@ OP_HANDLER(sbcb_ix) {
     uint16_t t, r;
     IDXBYTE(t);
     r = B - t - (CC & 0x01);
-    CLR_NZVC;
-    SET_FLAGS8(B, t, r);
+    FLAGS_NZVC8(B, t, r);
     B = r;
 }
 
@@ -1959,8 +1813,7 @@ OP_HANDLER(addd_ix) {
     IDXWORD(b);
     d = D;
     r = d + b.d;
-    CLR_NZVC;
-    SET_FLAGS16(d, b.d, r);
+    FLAGS_NZVC16(d, b.d, r);
     D = r;
 }
 
@@ -1969,8 +1822,7 @@ OP_HANDLER(andb_ix) {
     uint8_t t;
     IDXBYTE(t);
     B &= t;
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $e5 BITB indexed -**0- */
@@ -1978,21 +1830,18 @@ OP_HANDLER(bitb_ix) {
     uint8_t t, r;
     IDXBYTE(t);
     r = B & t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
 }
 
 /* $e6 LDB indexed -**0- */
 OP_HANDLER(ldb_ix) {
     IDXBYTE(B);
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $e7 STB indexed -**0- */
 OP_HANDLER(stb_ix) {
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
     INDEXED;
     WM(EAD, B);
 }
@@ -2002,8 +1851,7 @@ OP_HANDLER(eorb_ix) {
     uint8_t t;
     IDXBYTE(t);
     B ^= t;
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $e9 ADCB indexed ***** */
@@ -2011,9 +1859,7 @@ OP_HANDLER(adcb_ix) {
     uint16_t t, r;
     IDXBYTE(t);
     r = B + t + (CC & 0x01);
-    CLR_HNZVC;
-    SET_FLAGS8(B, t, r);
-    SET_H(B, t, r);
+    FLAGS_HNZVC8(B, t, r);
     B = r;
 }
 
@@ -2022,8 +1868,7 @@ OP_HANDLER(orb_ix) {
     uint8_t t;
     IDXBYTE(t);
     B |= t;
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $eb ADDB indexed ***** */
@@ -2031,17 +1876,14 @@ OP_HANDLER(addb_ix) {
     uint16_t t, r;
     IDXBYTE(t);
     r = B + t;
-    CLR_HNZVC;
-    SET_FLAGS8(B, t, r);
-    SET_H(B, t, r);
+    FLAGS_HNZVC8(B, t, r);
     B = r;
 }
 
 /* $ec LDD indexed -**0- */
 OP_HANDLER(ldd_ix) {
     IDXWORD(m_d);
-    CLR_NZV;
-    SET_NZ16(D);
+    FLAGS_NZ16(D);
 }
 
 /* $ec ADCX immediate -****    NSC8105 only.  Flags are a guess - copied from addb_im() */
@@ -2050,31 +1892,26 @@ OP_HANDLER(adcx_im) {
     uint16_t t, r;
     IMMBYTE(t);
     r = X + t;
-    CLR_HNZVC;
-    SET_FLAGS8(X, t, r);
-    SET_H(X, t, r);
+    FLAGS_HNZVC8(X, t, r);
     X = r;
 }
 
 /* $ed STD indexed -**0- */
 OP_HANDLER(std_ix) {
     INDEXED;
-    CLR_NZV;
-    SET_NZ16(D);
+    FLAGS_NZ16(D);
     WM16(EAD, &m_d);
 }
 
 /* $ee LDX indexed -**0- */
 OP_HANDLER(ldx_ix) {
     IDXWORD(m_x);
-    CLR_NZV;
-    SET_NZ16(X);
+    FLAGS_NZ16(X);
 }
 
 /* $ef STX indexed -**0- */
 OP_HANDLER(stx_ix) {
-    CLR_NZV;
-    SET_NZ16(X);
+    FLAGS_NZ16(X);
     INDEXED;
     WM16(EAD, &m_x);
 }
@@ -2084,8 +1921,7 @@ OP_HANDLER(subb_ex) {
     uint16_t t, r;
     EXTBYTE(t);
     r = B - t;
-    CLR_NZVC;
-    SET_FLAGS8(B, t, r);
+    FLAGS_NZVC8(B, t, r);
     B = r;
 }
 
@@ -2094,8 +1930,7 @@ OP_HANDLER(cmpb_ex) {
     uint16_t t, r;
     EXTBYTE(t);
     r = B - t;
-    CLR_NZVC;
-    SET_FLAGS8(B, t, r);
+    FLAGS_NZVC8(B, t, r);
 }
 
 /* $f2 SBCB extended ?**** */
@@ -2103,8 +1938,7 @@ OP_HANDLER(sbcb_ex) {
     uint16_t t, r;
     EXTBYTE(t);
     r = B - t - (CC & 0x01);
-    CLR_NZVC;
-    SET_FLAGS8(B, t, r);
+    FLAGS_NZVC8(B, t, r);
     B = r;
 }
 
@@ -2115,8 +1949,7 @@ OP_HANDLER(addd_ex) {
     EXTWORD(b);
     d = D;
     r = d + b.d;
-    CLR_NZVC;
-    SET_FLAGS16(d, b.d, r);
+    FLAGS_NZVC16(d, b.d, r);
     D = r;
 }
 
@@ -2125,8 +1958,7 @@ OP_HANDLER(andb_ex) {
     uint8_t t;
     EXTBYTE(t);
     B &= t;
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $f5 BITB extended -**0- */
@@ -2134,21 +1966,18 @@ OP_HANDLER(bitb_ex) {
     uint8_t t, r;
     EXTBYTE(t);
     r = B & t;
-    CLR_NZV;
-    SET_NZ8(r);
+    FLAGS_NZ8(r);
 }
 
 /* $f6 LDB extended -**0- */
 OP_HANDLER(ldb_ex) {
     EXTBYTE(B);
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $f7 STB extended -**0- */
 OP_HANDLER(stb_ex) {
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
     EXTENDED;
     WM(EAD, B);
 }
@@ -2158,8 +1987,7 @@ OP_HANDLER(eorb_ex) {
     uint8_t t;
     EXTBYTE(t);
     B ^= t;
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $f9 ADCB extended ***** */
@@ -2167,9 +1995,7 @@ OP_HANDLER(adcb_ex) {
     uint16_t t, r;
     EXTBYTE(t);
     r = B + t + (CC & 0x01);
-    CLR_HNZVC;
-    SET_FLAGS8(B, t, r);
-    SET_H(B, t, r);
+    FLAGS_HNZVC8(B, t, r);
     B = r;
 }
 
@@ -2178,8 +2004,7 @@ OP_HANDLER(orb_ex) {
     uint8_t t;
     EXTBYTE(t);
     B |= t;
-    CLR_NZV;
-    SET_NZ8(B);
+    FLAGS_NZ8(B);
 }
 
 /* $fb ADDB extended ***** */
@@ -2187,17 +2012,14 @@ OP_HANDLER(addb_ex) {
     uint16_t t, r;
     EXTBYTE(t);
     r = B + t;
-    CLR_HNZVC;
-    SET_FLAGS8(B, t, r);
-    SET_H(B, t, r);
+    FLAGS_HNZVC8(B, t, r);
     B = r;
 }
 
 /* $fc LDD extended -**0- */
 OP_HANDLER(ldd_ex) {
     EXTWORD(m_d);
-    CLR_NZV;
-    SET_NZ16(D);
+    FLAGS_NZ16(D);
 }
 
 /* $fc ADDX extended -****    NSC8105 only.  Flags are a guess */
@@ -2207,30 +2029,26 @@ OP_HANDLER(addx_ex) {
     EXTWORD(b);
     d = X;
     r = d + b.d;
-    CLR_NZVC;
-    SET_FLAGS16(d, b.d, r);
+    FLAGS_NZVC16(d, b.d, r);
     X = r;
 }
 
 /* $fd STD extended -**0- */
 OP_HANDLER(std_ex) {
     EXTENDED;
-    CLR_NZV;
-    SET_NZ16(D);
+    FLAGS_NZ16(D);
     WM16(EAD, &m_d);
 }
 
 /* $fe LDX extended -**0- */
 OP_HANDLER(ldx_ex) {
     EXTWORD(m_x);
-    CLR_NZV;
-    SET_NZ16(X);
+    FLAGS_NZ16(X);
 }
 
 /* $ff STX extended -**0- */
 OP_HANDLER(stx_ex) {
-    CLR_NZV;
-    SET_NZ16(X);
+    FLAGS_NZ16(X);
     EXTENDED;
     WM16(EAD, &m_x);
 }
@@ -2245,8 +2063,7 @@ OP_HANDLER(btst_ix) {
         PC += 2;
     }
     val = RM(EAD) & mask;
-    CLR_NZVC;
-    SET_NZ8(val);
+    FLAGS_TST8(val);
 }
 
 // $b2 - assuming correct, store first byte to (X + $disp8)
@@ -2255,7 +2072,6 @@ OP_HANDLER(stx_nsc) {
     uint8_t val = RM(EAD);
     IMM8;
     EA = X + RM(EAD);
-    CLR_NZV;
-    SET_NZ8(val);
+    FLAGS_NZ8(val);
     WM(EAD, val);
 }
\ No newline at end of file
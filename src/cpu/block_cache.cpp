@@ -0,0 +1,189 @@
+#include "block_cache.h"
+
+#define END 0x80
+
+/* addressing mode of each 6800 opcode, END marks instructions that finish a block */
+const uint8_t m6800_block_cache::modes_6800[256] = {
+    /*    0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F */
+    /*0*/ EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH | END, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH | END, EA_INH | END,
+    /*1*/ EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH,
+    /*2*/ EA_REL | END, EA_REL | END, EA_REL | END, EA_REL | END, EA_REL | END, EA_REL | END, EA_REL | END, EA_REL | END, EA_REL | END, EA_REL | END, EA_REL | END, EA_REL | END, EA_REL | END, EA_REL | END, EA_REL | END, EA_REL | END,
+    /*3*/ EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH | END, EA_INH, EA_INH | END, EA_INH, EA_INH, EA_INH | END, EA_INH | END,
+    /*4*/ EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH,
+    /*5*/ EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH, EA_INH,
+    /*6*/ EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX | END, EA_IDX,
+    /*7*/ EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT | END, EA_EXT,
+    /*8*/ EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM16, EA_REL | END, EA_IMM16, EA_IMM16,
+    /*9*/ EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR | END, EA_DIR, EA_DIR,
+    /*A*/ EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX | END, EA_IDX, EA_IDX,
+    /*B*/ EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT | END, EA_EXT, EA_EXT,
+    /*C*/ EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM8, EA_IMM16, EA_IMM16, EA_IMM16, EA_IMM16,
+    /*D*/ EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR, EA_DIR,
+    /*E*/ EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX, EA_IDX,
+    /*F*/ EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT, EA_EXT,
+};
+
+static const uint8_t mode_length[] = { 1, 2, 2, 3, 2, 2, 3 };
+
+int m6800_block_cache::instruction_length(uint8_t opcode) {
+    return mode_length[modes_6800[opcode] & ~END];
+}
+
+m6800_block_cache::m6800_block_cache(MemoryMapManager* memory_map) {
+    this->memory_map = memory_map;
+    invalidated = false;
+    for (int i = 0; i < MemoryMapManager::PAGE_COUNT; i++) {
+        pages[i] = nullptr;
+    }
+    memory_map->on_watched_write = [this](offs_t address) { invalidate_page(address >> MemoryMapManager::PAGE_SHIFT); };
+}
+
+m6800_block_cache::~m6800_block_cache() {
+    for (int i = 0; i < MemoryMapManager::PAGE_COUNT; i++) {
+        if (pages[i] != nullptr) {
+            clear_page(pages[i]);
+            delete pages[i];
+        }
+    }
+}
+
+m6800_block* m6800_block_cache::lookup(offs_t pc, const m6800_cpu_device::op_func* insn, const uint8_t* cycles) {
+    block_page* page = pages[pc >> MemoryMapManager::PAGE_SHIFT];
+
+    if (page != nullptr) {
+        if (page->stale) {
+            clear_page(page);
+        }
+        m6800_block* block = page->entry[pc & MemoryMapManager::PAGE_MASK];
+        if (block != nullptr) {
+            return block;
+        }
+    }
+
+    return build(pc, insn, cycles);
+}
+
+m6800_block* m6800_block_cache::build(offs_t pc, const m6800_cpu_device::op_func* insn, const uint8_t* cycles) {
+    uint8_t* memory = memory_map->get_page(pc);
+
+    if (memory == nullptr) {
+        return nullptr;
+    }
+
+    offs_t offset = pc & MemoryMapManager::PAGE_MASK;
+    m6800_block* block = new m6800_block;
+    block->start = pc;
+    block->cycles = 0;
+    block->count = 0;
+    block->hits = 0;
+    block->native = nullptr;
+
+    while (block->count < m6800_block::MAX_OPS) {
+        uint8_t opcode = memory[offset];
+        uint8_t length = mode_length[modes_6800[opcode] & ~END];
+
+        // instructions that straddle a page boundary are left to the interpreter
+        if (offset + length > MemoryMapManager::PAGE_SIZE) {
+            break;
+        }
+
+        m6800_uop& op = block->ops[block->count++];
+        op.handler = insn[opcode];
+        op.pc = (pc & ~MemoryMapManager::PAGE_MASK) | offset;
+        op.opcode = opcode;
+        op.cycles = cycles[opcode];
+        op.length = length;
+        op.operand = length == 3 ? (memory[offset + 1] << 8) | memory[offset + 2] : length == 2 ? memory[offset + 1] : 0;
+
+        block->cycles += op.cycles;
+        offset += length;
+
+        if ((modes_6800[opcode] & END) || offset == MemoryMapManager::PAGE_SIZE) {
+            break;
+        }
+    }
+
+    if (block->count == 0) {
+        delete block;
+        return nullptr;
+    }
+
+    block->end = (pc & ~MemoryMapManager::PAGE_MASK) + offset - 1;
+    block->loop = loop_kind(block);
+
+    int index = pc >> MemoryMapManager::PAGE_SHIFT;
+    if (pages[index] == nullptr) {
+        pages[index] = new block_page;
+        for (int i = 0; i < MemoryMapManager::PAGE_SIZE; i++) {
+            pages[index]->entry[i] = nullptr;
+        }
+        pages[index]->stale = false;
+    }
+
+    pages[index]->entry[pc & MemoryMapManager::PAGE_MASK] = block;
+    pages[index]->blocks.push_back(block);
+
+    if (memory_map->is_writable(pc)) {
+        memory_map->watch(block->start, block->end);
+    }
+
+    return block;
+}
+
+uint8_t m6800_block_cache::loop_kind(const m6800_block* block) {
+    const m6800_uop& branch = block->ops[block->count - 1];
+    if (block->count < 2 || branch.opcode != 0x26 || (uint16_t)(branch.pc + 2 + (int8_t)branch.operand) != block->start) {
+        return LOOP_NONE;
+    }
+    // the NOPs come after the counter, so the flags always come from its last turn
+    for (int i = 1; i < block->count - 1; i++) {
+        if (block->ops[i].opcode != 0x01) {
+            return LOOP_NONE;
+        }
+    }
+
+    switch (block->ops[0].opcode) {
+    case 0x09:
+        return LOOP_DEX;
+    case 0x08:
+        return LOOP_INX;
+    case 0x4a:
+        return LOOP_DECA;
+    case 0x4c:
+        return LOOP_INCA;
+    case 0x5a:
+        return LOOP_DECB;
+    case 0x5c:
+        return LOOP_INCB;
+    default:
+        return LOOP_NONE;
+    }
+}
+
+void m6800_block_cache::invalidate_page(int page) {
+    // blocks are only freed by the next lookup, as one of them may still be running
+    if (pages[page] != nullptr) {
+        pages[page]->stale = true;
+    }
+    memory_map->unwatch_page(page);
+    invalidated = true;
+}
+
+void m6800_block_cache::invalidate_all() {
+    for (int i = 0; i < MemoryMapManager::PAGE_COUNT; i++) {
+        if (pages[i] != nullptr && !pages[i]->blocks.empty()) {
+            invalidate_page(i);
+        }
+    }
+}
+
+void m6800_block_cache::clear_page(block_page* page) {
+    std::vector<m6800_block*>::iterator it = page->blocks.begin();
+    while (it != page->blocks.end()) {
+        page->entry[(*it)->start & MemoryMapManager::PAGE_MASK] = nullptr;
+        delete *it;
+        it++;
+    }
+    page->blocks.clear();
+    page->stale = false;
+}
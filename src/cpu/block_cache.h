@@ -0,0 +1,104 @@
+#ifndef M6800_BLOCK_CACHE_H
+#define M6800_BLOCK_CACHE_H
+
+#include "m6800.h"
+#include <stdint.h>
+#include <vector>
+
+/*
+    Predecoded basic block cache
+
+    Straight-line runs of 6800 instructions are decoded once into micro-op records, keyed by
+    the address of the first instruction. A block ends after the first instruction that changes
+    the program flow (branches, jumps, returns, SWI, WAI) or that runs the next instruction
+    itself (TAP, CLI, SEI), and never crosses a 256-byte page.
+
+    Only pages with a direct host pointer (RAM and ROM) are cached. The bytes of blocks built
+    from RAM are watched in the memory map, and a write to them drops every block on that page.
+    ROM pages can't be written, so their blocks stay cached.
+
+    Counted delay loops
+
+    A block made of DEX, INX, DECA, INCA, DECB or INCB, possibly followed by NOPs, and a BNE
+    back to its start only counts a register to zero: it reads and writes no memory and touches
+    no flag but the counter's. Such blocks are marked with the register and direction, so the
+    CPU can run all their turns but the last at once.
+*/
+
+enum m6800_ea_mode {
+    EA_INH, /* inherent */
+    EA_REL, /* relative */
+    EA_IMM8, /* immediate byte */
+    EA_IMM16, /* immediate word */
+    EA_DIR, /* direct */
+    EA_IDX, /* x + byte offset */
+    EA_EXT /* extended */
+};
+
+enum m6800_loop_kind {
+    LOOP_NONE,
+    LOOP_DEX,
+    LOOP_INX,
+    LOOP_DECA,
+    LOOP_INCA,
+    LOOP_DECB,
+    LOOP_INCB
+};
+
+struct m6800_uop {
+    m6800_cpu_device::op_func handler;
+    uint16_t pc;
+    uint16_t operand; /* immediate, address or branch offset, read by the JIT, the delay loop check and the trace */
+    uint8_t opcode;
+    uint8_t cycles;
+    uint8_t length;
+};
+
+struct m6800_block {
+    static const int MAX_OPS = 32;
+
+    typedef void (*native_func)(m6800_cpu_device* cpu);
+
+    uint16_t start;
+    uint16_t end; /* last byte of the block */
+    uint16_t cycles; /* sum of the cycles of all instructions */
+    uint16_t count;
+    uint8_t loop; /* m6800_loop_kind */
+    uint32_t hits; /* times run, for the JIT */
+    native_func native; /* translated code, if any */
+    m6800_uop ops[MAX_OPS];
+};
+
+class m6800_block_cache {
+public:
+    m6800_block_cache(MemoryMapManager* memory_map);
+    ~m6800_block_cache();
+
+    // returns the block starting at pc, decoding it on a miss, or nullptr if pc can't be cached
+    m6800_block* lookup(offs_t pc, const m6800_cpu_device::op_func* insn, const uint8_t* cycles);
+    void invalidate_page(int page);
+    void invalidate_all();
+    // bytes taken by a 6800 instruction, from its addressing mode
+    static int instruction_length(uint8_t opcode);
+
+    // set whenever blocks are dropped, so a block that is running can stop early
+    bool invalidated;
+
+private:
+    struct block_page {
+        m6800_block* entry[MemoryMapManager::PAGE_SIZE];
+        std::vector<m6800_block*> blocks;
+        bool stale;
+    };
+
+    static const uint8_t modes_6800[256];
+
+    MemoryMapManager* memory_map;
+    block_page* pages[MemoryMapManager::PAGE_COUNT];
+
+    m6800_block* build(offs_t pc, const m6800_cpu_device::op_func* insn, const uint8_t* cycles);
+    static uint8_t loop_kind(const m6800_block* block);
+    void clear_page(block_page* page);
+};
+
+#endif // M6800_BLOCK_CACHE_H
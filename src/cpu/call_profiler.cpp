@@ -0,0 +1,143 @@
+#include "call_profiler.h"
+
+#include <algorithm>
+
+m6800_call_profiler::m6800_call_profiler() {
+    clear();
+}
+
+m6800_call_profiler::m6800_call_profiler(const m6800_call_profiler& other) {
+    *this = other;
+}
+
+m6800_call_profiler& m6800_call_profiler::operator=(const m6800_call_profiler& other) {
+    nodes = other.nodes;
+    depth = other.depth;
+    std::copy(other.frames, other.frames + depth + 1, frames);
+    set_top();
+    return *this;
+}
+
+void m6800_call_profiler::clear() {
+    nodes.clear();
+    nodes.push_back(Node { ROOT, NONE, NONE, NONE, 0, 0 });
+    depth = 0;
+    frames[0] = Frame { NONE, 0 };
+    set_top();
+}
+
+void m6800_call_profiler::reset_stack() {
+    depth = 0;
+    set_top();
+}
+
+void m6800_call_profiler::pop(uint32_t sp) {
+    while (depth > 0 && frames[depth].sp <= sp) {
+        depth--;
+    }
+    set_top();
+}
+
+void m6800_call_profiler::set_top() {
+    top_sp = frames[depth].sp;
+    top_cycles = &nodes[frames[depth].node].exclusive;
+}
+
+void m6800_call_profiler::call(uint16_t function, uint32_t sp) {
+    // a frame at or below the caller's stack pointer was abandoned without returning
+    pop(sp);
+
+    if (depth + 1 >= MAX_DEPTH) {
+        return;
+    }
+    uint32_t node = child(frames[depth].node, function);
+    if (node == NONE) {
+        return;
+    }
+
+    nodes[node].calls++;
+    depth++;
+    frames[depth] = Frame { sp, node };
+    set_top();
+}
+
+uint32_t m6800_call_profiler::child(uint32_t parent, uint16_t function) {
+    uint32_t node = nodes[parent].first_child;
+    while (node != NONE) {
+        if (nodes[node].function == function) {
+            return node;
+        }
+        node = nodes[node].next_sibling;
+    }
+
+    if (nodes.size() >= MAX_NODES) {
+        return NONE;
+    }
+    node = nodes.size();
+    nodes.push_back(Node { function, parent, NONE, nodes[parent].first_child, 0, 0 });
+    nodes[parent].first_child = node;
+    return node;
+}
+
+std::vector<m6800_function_stats> m6800_call_profiler::summarize() const {
+    // children are always added after their parent, so one pass from the end sums subtrees
+    std::vector<unsigned long long> totals(nodes.size());
+    for (size_t i = nodes.size(); i-- > 0;) {
+        totals[i] += nodes[i].exclusive;
+        if (nodes[i].parent != NONE) {
+            totals[nodes[i].parent] += totals[i];
+        }
+    }
+
+    std::vector<m6800_function_stats> stats;
+    std::vector<int> index(ROOT + 1, -1);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const Node& node = nodes[i];
+        if (index[node.function] < 0) {
+            index[node.function] = stats.size();
+            stats.push_back(m6800_function_stats { node.function, 0, 0, 0 });
+        }
+        m6800_function_stats& entry = stats[index[node.function]];
+        entry.calls += node.calls;
+        entry.exclusive += node.exclusive;
+
+        // a recursive call is already inside the outer call's inclusive time
+        bool recursive = false;
+        uint32_t parent = node.parent;
+        while (parent != NONE && !recursive) {
+            recursive = nodes[parent].function == node.function;
+            parent = nodes[parent].parent;
+        }
+        if (!recursive) {
+            entry.inclusive += totals[i];
+        }
+    }
+    return stats;
+}
+
+void m6800_call_profiler::fold(std::function<void(const std::vector<uint32_t>& stack, unsigned long long cycles)> callback) const {
+    std::vector<uint32_t> stack;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i].exclusive == 0) {
+            continue;
+        }
+        stack.clear();
+        uint32_t node = i;
+        while (node != NONE) {
+            stack.push_back(nodes[node].function);
+            node = nodes[node].parent;
+        }
+        std::reverse(stack.begin(), stack.end());
+        callback(stack, nodes[i].exclusive);
+    }
+}
+
+unsigned long long m6800_call_profiler::get_total_cycles() const {
+    unsigned long long total = 0;
+    std::vector<Node>::const_iterator it = nodes.begin();
+    while (it != nodes.end()) {
+        total += (*it).exclusive;
+        it++;
+    }
+    return total;
+}
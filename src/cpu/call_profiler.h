@@ -0,0 +1,96 @@
+#ifndef M6800_CALL_PROFILER_H
+#define M6800_CALL_PROFILER_H
+
+#include <functional>
+#include <stdint.h>
+#include <vector>
+
+/*
+    Call profiler
+
+    Keeps a shadow of the program's call stack and charges every instruction's cycles to the
+    routine on top of it, building a call tree as routines are entered. A routine is the
+    target of a JSR or BSR, or the vector of an interrupt or SWI, so it is identified by its
+    entry address; naming it after a label is left to whoever reads the profile.
+
+    Frames are matched to the real stack rather than to RTS and RTI: each frame remembers
+    the stack pointer from before its return address was pushed, and after every instruction
+    the frames at or below the current stack pointer are dropped. So a routine that discards
+    its return address, returns with a JMP, or reloads S returns as soon as the stack gives
+    it away, and an interrupt returns on the RTI that pulls its registers. Code that runs
+    before the first call seen, or after the stack unwinds past it, is charged to the root.
+
+    The cycles charged are the instruction cycles, like m6800_profiler: time spent waiting in
+    WAI and entering interrupts goes uncounted.
+*/
+struct m6800_function_stats {
+    uint32_t function; /* entry address, or ROOT */
+    unsigned long long calls;
+    unsigned long long inclusive; /* cycles in the routine and everything it called */
+    unsigned long long exclusive; /* cycles in the routine itself */
+};
+
+class m6800_call_profiler {
+public:
+    static const uint32_t ROOT = 0x10000; /* function of the root node */
+    static const int MAX_DEPTH = 256; /* deeper calls are charged to the caller */
+    static const size_t MAX_NODES = 1 << 16; /* calls that would grow the tree further are too */
+
+    m6800_call_profiler();
+    m6800_call_profiler(const m6800_call_profiler& other);
+    m6800_call_profiler& operator=(const m6800_call_profiler& other);
+
+    void clear();
+    // drops every frame, for a CPU reset
+    void reset_stack();
+
+    void charge(uint8_t cycles) {
+        *top_cycles += cycles;
+    }
+
+    // after each instruction, with the CPU's stack pointer
+    void unwind(uint16_t sp) {
+        if (top_sp <= sp) {
+            pop(sp);
+        }
+    }
+
+    // a routine was entered at function, and its caller's stack pointer was sp
+    void call(uint16_t function, uint32_t sp);
+
+    // one line per routine that ran, in no particular order
+    std::vector<m6800_function_stats> summarize() const;
+    // calls back with each stack that ran instructions of its own, root first, and the cycles
+    void fold(std::function<void(const std::vector<uint32_t>& stack, unsigned long long cycles)> callback) const;
+    unsigned long long get_total_cycles() const;
+
+private:
+    struct Node {
+        uint32_t function;
+        uint32_t parent;
+        uint32_t first_child;
+        uint32_t next_sibling;
+        unsigned long long calls;
+        unsigned long long exclusive;
+    };
+
+    struct Frame {
+        uint32_t sp; /* above 0xFFFF for the root, which never unwinds */
+        uint32_t node;
+    };
+
+    static const uint32_t NONE = 0xFFFFFFFF;
+
+    std::vector<Node> nodes;
+    Frame frames[MAX_DEPTH];
+    int depth;
+    // the top frame, kept apart so the per-instruction calls don't index through it
+    uint32_t top_sp;
+    unsigned long long* top_cycles;
+
+    void pop(uint32_t sp);
+    void set_top();
+    uint32_t child(uint32_t parent, uint16_t function);
+};
+
+#endif // M6800_CALL_PROFILER_H
@@ -0,0 +1,455 @@
+#include "jit_x64.h"
+
+#if M6800_JIT_X64
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+/* x86 condition codes used with jcc */
+#define CC_Z 0x4
+#define CC_NZ 0x5
+#define CC_G 0xf
+
+/* register numbers used in ModRM.reg */
+#define REG_AL 0
+
+m6800_jit::m6800_jit(m6800_cpu_device* cpu, m6800_block_cache* block_cache) {
+    this->cpu = cpu;
+    this->block_cache = block_cache;
+    perf_map = nullptr;
+
+    uint8_t* base = (uint8_t*)cpu;
+    off_pc = (uint8_t*)&cpu->m_pc.d - base;
+    off_ppc = (uint8_t*)&cpu->m_ppc.d - base;
+    off_s = (uint8_t*)&cpu->m_s.d - base;
+    off_x = (uint8_t*)&cpu->m_x.d - base;
+    off_a = (uint8_t*)&cpu->m_d.b.h - base;
+    off_b = (uint8_t*)&cpu->m_d.b.l - base;
+    off_cc = (uint8_t*)&cpu->m_cc - base;
+    off_icount = (uint8_t*)&cpu->m_icount - base;
+    off_abort = (uint8_t*)&cpu->abort_run - base;
+    off_retired = (uint8_t*)&cpu->instructions_retired - base;
+#if defined(M6800_LAZY_FLAGS)
+    off_flag_op = (uint8_t*)&cpu->m_flag_op - base;
+#endif
+
+    for (int i = 0; i < 256; i++) {
+        nz_flags[i] = ((i & 0x80) >> 4) | (i == 0 ? 0x04 : 0);
+    }
+
+    // never writable and executable at once, compile() opens the pages it writes for the time it takes
+    void* memory = mmap(nullptr, CODE_CACHE_SIZE, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        code = nullptr;
+    } else {
+        code = (uint8_t*)memory;
+    }
+    code_top = code;
+}
+
+m6800_jit::~m6800_jit() {
+    if (code != nullptr) {
+        munmap(code, CODE_CACHE_SIZE);
+    }
+    if (perf_map != nullptr) {
+        fclose(perf_map);
+    }
+}
+
+void m6800_jit::enable_perf_map() {
+    if (perf_map == nullptr) {
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/perf-%d.map", (int)getpid());
+        perf_map = fopen(path, "a");
+    }
+}
+
+void m6800_jit::flush() {
+    code_top = code;
+    block_cache->invalidate_all();
+}
+
+bool m6800_jit::compile(m6800_block* block) {
+    if (code == nullptr) {
+        return false;
+    }
+
+    // out of room: start over, the blocks are rebuilt and translated again as they run
+    if (code_top + MAX_BLOCK_CODE > code + CODE_CACHE_SIZE) {
+        flush();
+        return false;
+    }
+
+    // the pages this block can be written to, from the one holding the end of the last block
+    uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    uint8_t* first_page = (uint8_t*)((uintptr_t)code_top & ~(page_size - 1));
+    uint8_t* end_page = (uint8_t*)(((uintptr_t)code_top + MAX_BLOCK_CODE + page_size - 1) & ~(page_size - 1));
+    if (end_page > code + CODE_CACHE_SIZE) {
+        end_page = code + CODE_CACHE_SIZE;
+    }
+    if (mprotect(first_page, end_page - first_page, PROT_READ | PROT_WRITE) != 0) {
+        return false;
+    }
+
+    std::vector<exit_stub> stubs;
+    uint8_t* entry = code_top;
+    p = entry;
+
+    // push rbx; push r12..r15, leaves the stack 16-byte aligned for calls
+    emit8(0x53);
+    emit16(0x5441);
+    emit16(0x5541);
+    emit16(0x5641);
+    emit16(0x5741);
+    // mov rbx, rdi
+    emit8(0x48), emit8(0x89), emit8(0xfb);
+    // mov r12, nz_flags; mov r13, flags8i; mov r14, flags8d; mov r15, &invalidated
+    emit16(0xbc49), emit64((uint64_t)nz_flags);
+    emit16(0xbd49), emit64((uint64_t)m6800_cpu_device::flags8i);
+    emit16(0xbe49), emit64((uint64_t)m6800_cpu_device::flags8d);
+    emit16(0xbf49), emit64((uint64_t)&block_cache->invalidated);
+
+    uint8_t* top = p;
+    int cycles = 0;
+    cc_pending = true;
+
+    for (int i = 0; i < block->count; i++) {
+        const m6800_uop& op = block->ops[i];
+        bool last = i == block->count - 1;
+
+        if (op.opcode >= 0x20 && op.opcode <= 0x2f) {
+            emit_branch(block, op, cycles + op.cycles, i + 1, top);
+            break;
+        }
+
+        cycles += op.cycles;
+
+        if (compile_inline(op)) {
+            if (last) {
+                sub_icount(cycles);
+                add_retired(i + 1);
+                store32(off_ppc, op.pc);
+                store32(off_pc, (op.pc + op.length) & 0xffff);
+                emit_epilogue();
+            }
+            continue;
+        }
+
+        if (last) {
+            // handlers that end a block may look at or eat m_icount, so it has to be up to date
+            sub_icount(cycles - op.cycles);
+            store32(off_ppc, op.pc);
+            emit_call(op);
+            sub_icount(op.cycles);
+            add_retired(i + 1);
+            emit_epilogue();
+            break;
+        }
+
+        emit_call(op);
+        // cmp byte [r15], 0; jne exit
+        emit32(0x003f8041);
+        exit_stub stub;
+        stub.patch = emit_jcc(CC_NZ);
+        stub.ppc = op.pc;
+        stub.cycles = cycles;
+        stub.count = i + 1;
+        stubs.push_back(stub);
+    }
+
+    // a store rewrote cached code, leave after the instruction that did it
+    std::vector<exit_stub>::iterator it = stubs.begin();
+    while (it != stubs.end()) {
+        patch((*it).patch, p);
+        sub_icount((*it).cycles);
+        add_retired((*it).count);
+        store32(off_ppc, (*it).ppc);
+        emit_epilogue();
+        it++;
+    }
+
+    if (mprotect(first_page, end_page - first_page, PROT_READ | PROT_EXEC) != 0) {
+        // blocks translated earlier into these pages can't run any more
+        flush();
+        return false;
+    }
+
+    block->native = (m6800_block::native_func)entry;
+    code_top = p;
+
+    if (perf_map != nullptr) {
+        fprintf(perf_map, "%lx %lx m6800_block_%04x\n", (unsigned long)entry, (unsigned long)(p - entry), block->start);
+        fflush(perf_map);
+    }
+
+    return true;
+}
+
+bool m6800_jit::compile_inline(const m6800_uop& op) {
+    int32_t reg;
+
+    switch (op.opcode) {
+    case 0x01: /* nop */
+        return true;
+    case 0x0a: /* clv */
+    case 0x0c: /* clc */
+        emit_update_cc();
+        emit_modrm_rbx(0x80, 4, off_cc), emit8(op.opcode == 0x0a ? 0xfd : 0xfe);
+        return true;
+    case 0x0b: /* sev */
+    case 0x0d: /* sec */
+        emit_update_cc();
+        emit_modrm_rbx(0x80, 1, off_cc), emit8(op.opcode == 0x0b ? 0x02 : 0x01);
+        return true;
+    case 0x08: /* inx */
+    case 0x09: /* dex */
+        emit_update_cc();
+        // add/sub word [x], 1; setz al; shl al, 2
+        emit8(0x66), emit_modrm_rbx(0x83, op.opcode == 0x08 ? 0 : 5, off_x), emit8(1);
+        emit8(0x0f), emit8(0x94), emit8(0xc0);
+        emit8(0xc0), emit8(0xe0), emit8(2);
+        emit_modrm_rbx(0x80, 4, off_cc), emit8(0xfb);
+        emit_modrm_rbx(0x08, REG_AL, off_cc);
+        return true;
+    case 0x31: /* ins */
+    case 0x34: /* des */
+        emit8(0x66), emit_modrm_rbx(0x83, op.opcode == 0x31 ? 0 : 5, off_s), emit8(1);
+        return true;
+    case 0x30: /* tsx */
+    case 0x35: /* txs */
+        // movzx eax, word [src]; inc/dec eax; mov word [dst], ax
+        emit8(0x0f), emit_modrm_rbx(0xb7, REG_AL, op.opcode == 0x30 ? off_s : off_x);
+        emit8(0xff), emit8(op.opcode == 0x30 ? 0xc0 : 0xc8);
+        emit8(0x66), emit_modrm_rbx(0x89, REG_AL, op.opcode == 0x30 ? off_x : off_s);
+        return true;
+    case 0x16: /* tab */
+    case 0x17: /* tba */
+        emit_update_cc();
+        emit8(0x0f), emit_modrm_rbx(0xb6, REG_AL, op.opcode == 0x16 ? off_a : off_b);
+        emit_modrm_rbx(0x88, REG_AL, op.opcode == 0x16 ? off_b : off_a);
+        emit_modrm_rbx(0x80, 4, off_cc), emit8(0xf1);
+        emit_nz8(op.opcode == 0x16 ? off_b : off_a);
+        return true;
+    case 0x4d: /* tsta */
+    case 0x5d: /* tstb */
+        emit_update_cc();
+        emit_modrm_rbx(0x80, 4, off_cc), emit8(0xf0);
+        emit_nz8(op.opcode == 0x4d ? off_a : off_b);
+        return true;
+    case 0x4f: /* clra */
+    case 0x5f: /* clrb */
+        emit_update_cc();
+        emit_modrm_rbx(0xc6, 0, op.opcode == 0x4f ? off_a : off_b), emit8(0);
+        emit_modrm_rbx(0x80, 4, off_cc), emit8(0xf0);
+        emit_modrm_rbx(0x80, 1, off_cc), emit8(0x04);
+        return true;
+    case 0x4a: /* deca */
+    case 0x4c: /* inca */
+    case 0x5a: /* decb */
+    case 0x5c: /* incb */
+        emit_update_cc();
+        reg = op.opcode < 0x50 ? off_a : off_b;
+        // inc/dec byte [reg]; movzx eax, byte [reg]
+        emit_modrm_rbx(0xfe, (op.opcode & 0x0f) == 0x0c ? 0 : 1, reg);
+        emit8(0x0f), emit_modrm_rbx(0xb6, REG_AL, reg);
+        emit_modrm_rbx(0x80, 4, off_cc), emit8(0xf1);
+        // mov al, [r13 + rax] (flags8i) or mov al, [r14 + rax] (flags8d)
+        if ((op.opcode & 0x0f) == 0x0c) {
+            emit32(0x05448a41), emit8(0);
+        } else {
+            emit32(0x06048a41);
+        }
+        emit_modrm_rbx(0x08, REG_AL, off_cc);
+        return true;
+    case 0x86: /* lda_im */
+    case 0xc6: /* ldb_im */
+        emit_update_cc();
+        emit_modrm_rbx(0xc6, 0, op.opcode == 0x86 ? off_a : off_b), emit8(op.operand);
+        emit_modrm_rbx(0x80, 4, off_cc), emit8(0xf1);
+        if (nz_flags[op.operand & 0xff]) {
+            emit_modrm_rbx(0x80, 1, off_cc), emit8(nz_flags[op.operand & 0xff]);
+        }
+        return true;
+    case 0x8e: /* lds_im */
+    case 0xce: /* ldx_im */
+        emit_update_cc();
+        store32(op.opcode == 0x8e ? off_s : off_x, op.operand);
+        emit_modrm_rbx(0x80, 4, off_cc), emit8(0xf1);
+        if (op.operand == 0 || (op.operand & 0x8000)) {
+            emit_modrm_rbx(0x80, 1, off_cc), emit8(((op.operand & 0x8000) >> 12) | (op.operand == 0 ? 0x04 : 0));
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void m6800_jit::emit_branch(m6800_block* block, const m6800_uop& op, int cycles, int count, uint8_t* top) {
+    uint16_t next = (op.pc + 2) & 0xffff;
+    uint16_t target = (next + (int8_t)op.operand) & 0xffff;
+    int condition = op.opcode & 0x0f;
+    uint8_t* taken = nullptr;
+
+    // every turn of a loop back to the top counts its instructions here
+    sub_icount(cycles);
+    add_retired(count);
+    store32(off_ppc, op.pc);
+
+    if (condition > 1) {
+        emit_update_cc();
+        // movzx eax, byte [cc]
+        emit8(0x0f), emit_modrm_rbx(0xb6, REG_AL, off_cc);
+
+        static const uint8_t masks[16] = { 0, 0, 0x05, 0x05, 0x01, 0x01, 0x04, 0x04, 0x02, 0x02, 0x08, 0x08 };
+
+        if (condition < 0x0c) {
+            // test al, mask
+            emit8(0xa8), emit8(masks[condition]);
+        } else {
+            // mov ecx, eax; shr ecx, 2; xor ecx, eax puts N ^ V in bit 1
+            emit8(0x89), emit8(0xc1);
+            emit8(0xc1), emit8(0xe9), emit8(2);
+            emit8(0x31), emit8(0xc1);
+            if (condition < 0x0e) {
+                // test cl, 2
+                emit8(0xf6), emit8(0xc1), emit8(0x02);
+            } else {
+                // and ecx, 2; shl ecx, 1; or ecx, eax; test cl, 4
+                emit8(0x83), emit8(0xe1), emit8(0x02);
+                emit8(0xd1), emit8(0xe1);
+                emit8(0x09), emit8(0xc1);
+                emit8(0xf6), emit8(0xc1), emit8(0x04);
+            }
+        }
+
+        // even conditions branch when the tested bits are clear
+        taken = emit_jcc(condition & 1 ? CC_NZ : CC_Z);
+    }
+
+    if (condition != 0) {
+        store32(off_pc, next);
+        emit_epilogue();
+    }
+
+    if (condition != 1) {
+        if (taken != nullptr) {
+            patch(taken, p);
+        }
+        if (target == block->start) {
+            // cmp byte [abort_run], 0; jne out; cmp dword [icount], cycles; jg top
+            emit_modrm_rbx(0x80, 7, off_abort), emit8(0);
+            uint8_t* out = emit_jcc(CC_NZ);
+            emit_modrm_rbx(0x81, 7, off_icount), emit32(block->cycles);
+            patch(emit_jcc(CC_G), top);
+            patch(out, p);
+        }
+        store32(off_pc, target);
+        emit_epilogue();
+    }
+}
+
+void m6800_jit::emit_epilogue() {
+    // pop r15..r12; pop rbx; ret
+    emit16(0x5f41), emit16(0x5e41), emit16(0x5d41), emit16(0x5c41);
+    emit8(0x5b), emit8(0xc3);
+}
+
+void m6800_jit::emit_call(const m6800_uop& op) {
+    store32(off_pc, (op.pc + 1) & 0xffff);
+    // mov rdi, rbx; mov rax, thunk; call rax
+    emit8(0x48), emit8(0x89), emit8(0xdf);
+    emit16(0xb848), emit64((uint64_t)m6800_cpu_device::m6800_thunks[op.opcode]);
+    emit8(0xff), emit8(0xd0);
+    // the handler may have left its flags pending
+    cc_pending = true;
+}
+
+void m6800_jit::emit_update_cc() {
+#if defined(M6800_LAZY_FLAGS)
+    if (cc_pending) {
+        // cmp byte [flag_op], 0; je skip; mov rdi, rbx; mov rax, update_cc; call rax
+        emit_modrm_rbx(0x80, 7, off_flag_op), emit8(0);
+        emit8(0x74), emit8(15);
+        emit8(0x48), emit8(0x89), emit8(0xdf);
+        emit16(0xb848), emit64((uint64_t)&m6800_jit::update_cc);
+        emit8(0xff), emit8(0xd0);
+        cc_pending = false;
+    }
+#endif
+}
+
+#if defined(M6800_LAZY_FLAGS)
+void m6800_jit::update_cc(m6800_cpu_device* cpu) {
+    cpu->update_cc();
+}
+#endif
+
+void m6800_jit::emit_nz8(int32_t reg) {
+    // movzx eax, byte [reg]; mov al, [r12 + rax]; or byte [cc], al
+    emit8(0x0f), emit_modrm_rbx(0xb6, REG_AL, reg);
+    emit32(0x04048a41);
+    emit_modrm_rbx(0x08, REG_AL, off_cc);
+}
+
+void m6800_jit::store32(int32_t offset, uint32_t value) {
+    emit_modrm_rbx(0xc7, 0, offset), emit32(value);
+}
+
+void m6800_jit::sub_icount(uint32_t cycles) {
+    if (cycles != 0) {
+        emit_modrm_rbx(0x81, 5, off_icount), emit32(cycles);
+    }
+}
+
+void m6800_jit::add_retired(uint32_t count) {
+    // add qword [retired], count
+    emit8(0x48), emit_modrm_rbx(0x81, 0, off_retired), emit32(count);
+}
+
+void m6800_jit::emit_modrm_rbx(uint8_t opcode, uint8_t reg, int32_t offset) {
+    // [rbx + disp32]
+    emit8(opcode);
+    emit8(0x80 | (reg << 3) | 3);
+    emit32(offset);
+}
+
+uint8_t* m6800_jit::emit_jump(uint8_t opcode) {
+    emit8(opcode);
+    emit32(0);
+    return p - 4;
+}
+
+uint8_t* m6800_jit::emit_jcc(uint8_t condition) {
+    emit8(0x0f);
+    return emit_jump(0x80 | condition);
+}
+
+void m6800_jit::patch(uint8_t* rel, uint8_t* target) {
+    int32_t distance = (int32_t)(target - (rel + 4));
+    rel[0] = distance;
+    rel[1] = distance >> 8;
+    rel[2] = distance >> 16;
+    rel[3] = distance >> 24;
+}
+
+void m6800_jit::emit8(uint8_t value) {
+    *p++ = value;
+}
+
+void m6800_jit::emit16(uint16_t value) {
+    emit8(value);
+    emit8(value >> 8);
+}
+
+void m6800_jit::emit32(uint32_t value) {
+    emit16(value);
+    emit16(value >> 16);
+}
+
+void m6800_jit::emit64(uint64_t value) {
+    emit32(value);
+    emit32(value >> 32);
+}
+
+#endif // M6800_JIT_X64
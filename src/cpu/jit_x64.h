@@ -0,0 +1,103 @@
+#ifndef M6800_JIT_X64_H
+#define M6800_JIT_X64_H
+
+#include "block_cache.h"
+#include "m6800.h"
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+    x86-64 translator for predecoded blocks
+
+    Blocks from the block cache that have run a few times are translated into native code.
+    Register-only instructions (loads of immediates, inc/dec, transfers, flag operations) and
+    the relative branches are generated inline; everything else calls the instruction handler,
+    so memory and I/O accesses still go through the memory map. The CPU state is never held in
+    host registers between instructions. With lazy flags, generated code brings m_cc up to date
+    before the first inline instruction that uses it after a handler call.
+
+    A block is only entered when it can't run out of cycles part way through, and subtracts
+    its cycles from m_icount and adds its instructions to instructions_retired on the way out,
+    so a slice ends exactly where the interpreter would end it. A branch back to the start of its own block loops in native code while the
+    slice lasts and abort_run is clear. A handler that stores into cached code leaves the
+    block straight away.
+
+    The code cache is mapped read and execute; compile() makes the pages it writes writable
+    and takes execute away while it writes them, so no page is ever both.
+
+    Only built with -DM6800_JIT on x86-64 Linux. Breakpoints and single stepping always use the
+    interpreter.
+*/
+
+#if defined(M6800_JIT) && defined(__x86_64__) && defined(__linux__)
+#define M6800_JIT_X64 1
+#else
+#define M6800_JIT_X64 0
+#endif
+
+#if M6800_JIT_X64
+
+class m6800_jit {
+public:
+    static const int HOT_THRESHOLD = 8; /* runs of a block before it is translated */
+    static const size_t CODE_CACHE_SIZE = 4 * 1024 * 1024;
+    static const size_t MAX_BLOCK_CODE = 4096; /* upper bound for one translated block */
+
+    m6800_jit(m6800_cpu_device* cpu, m6800_block_cache* block_cache);
+    ~m6800_jit();
+
+    // translates the block and sets block->native, returns false if it can't be translated
+    bool compile(m6800_block* block);
+    // drops all translated code, along with every cached block
+    void flush();
+    // writes a symbol for every translated block to /tmp/perf-<pid>.map
+    void enable_perf_map();
+
+private:
+    struct exit_stub {
+        uint8_t* patch; /* rel32 field of the jump into the stub */
+        uint16_t ppc;
+        uint16_t cycles; /* cycles run up to and including the instruction */
+        uint16_t count; /* instructions run, the same way */
+    };
+
+    m6800_cpu_device* cpu;
+    m6800_block_cache* block_cache;
+    uint8_t* code;
+    uint8_t* code_top;
+    uint8_t* p; /* emit pointer */
+    FILE* perf_map;
+    uint8_t nz_flags[256];
+
+    /* offsets of the CPU state from the cpu pointer */
+    int32_t off_pc, off_ppc, off_s, off_x, off_a, off_b, off_cc, off_icount, off_abort, off_retired;
+#if defined(M6800_LAZY_FLAGS)
+    int32_t off_flag_op;
+
+    static void update_cc(m6800_cpu_device* cpu);
+#endif
+    bool cc_pending; /* while compiling: m_cc may be missing the flags of a handler */
+
+    bool compile_inline(const m6800_uop& op);
+    void emit_branch(m6800_block* block, const m6800_uop& op, int cycles, int count, uint8_t* top);
+    void emit_epilogue();
+    void emit_call(const m6800_uop& op);
+    void emit_update_cc();
+    void emit_nz8(int32_t reg);
+
+    void emit8(uint8_t value);
+    void emit16(uint16_t value);
+    void emit32(uint32_t value);
+    void emit64(uint64_t value);
+    void emit_modrm_rbx(uint8_t opcode, uint8_t reg, int32_t offset);
+    uint8_t* emit_jump(uint8_t opcode);
+    uint8_t* emit_jcc(uint8_t condition);
+    void patch(uint8_t* rel, uint8_t* target);
+    void store32(int32_t offset, uint32_t value);
+    void sub_icount(uint32_t cycles);
+    void add_retired(uint32_t count);
+};
+
+#endif // M6800_JIT_X64
+
+#endif // M6800_JIT_X64_H
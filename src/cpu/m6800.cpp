@@ -17,6 +17,19 @@
 */
 
 #include "m6800.h"
+#include "block_cache.h"
+#include "jit_x64.h"
+#include "call_profiler.h"
+#include "profiler.h"
+#include "trace.h"
+#include <string.h>
+
+/* predecoded blocks are run when built with -DM6800_BLOCK_CACHE, or with the JIT that translates them */
+#if defined(M6800_BLOCK_CACHE) || M6800_JIT_X64
+#define BLOCK_CACHE_DEFAULT true
+#else
+#define BLOCK_CACHE_DEFAULT false
+#endif
 
 #define VERBOSE 0
 
@@ -40,7 +53,11 @@
 #define D m_d.w.l
 #define A m_d.b.h
 #define B m_d.b.l
+#if defined(M6800_LAZY_FLAGS)
+#define CC cc_ref()
+#else
 #define CC m_cc
+#endif
 
 #define EAD m_ea.d
 #define EA m_ea.w.l
@@ -97,14 +114,25 @@
     w.d |= RM(SD)
 
 /* operate one instruction for */
-#define ONE_MORE_INSN()                    \
-    {                                      \
-        uint8_t ireg;                      \
-        pPPC = pPC;                        \
-        ireg = M_RDOP(PCD);                \
-        PC++;                              \
-        (this->*m_insn[ireg])();           \
-        increment_counter(m_cycles[ireg]); \
+/* it is an instruction of its own, so the instrumented loop's trace and profilers see it too; */
+/* TAP, CLI and SEI run it and haven't taken their own 2 cycles yet */
+#define ONE_MORE_INSN()                               \
+    {                                                 \
+        uint8_t ireg;                                 \
+        pPPC = pPC;                                   \
+        ireg = M_RDOP(PCD);                           \
+        if (trace != nullptr)                         \
+            trace_instruction(ireg, m_icount - 2);    \
+        if (profile != nullptr)                       \
+            profile->record(PC, m_cycles[ireg]);      \
+        if (calls != nullptr)                         \
+            calls->charge(m_cycles[ireg]);            \
+        PC++;                                         \
+        (this->*m_insn[ireg])();                      \
+        increment_counter(m_cycles[ireg]);            \
+        instructions_retired++;                       \
+        if (calls != nullptr)                         \
+            track_calls(ireg);                        \
     }
 
 /* CC masks                       HI NZVC
@@ -206,6 +234,75 @@ const uint8_t m6800_cpu_device::flags8d[256] = /* decrement */
         SET_C16(r);          \
     }
 
+/* flag updates of the common ALU operations. With M6800_LAZY_FLAGS they only record the
+   operation, its operands and result; m_cc is brought up to date the next time CC is used */
+#if defined(M6800_LAZY_FLAGS)
+/* the flags each kind of operation sets, a pending operation can be dropped when the next one sets them all again */
+static const uint8_t lazy_owned[] = { 0x00, 0x0e, 0x0f, 0x0e, 0x0f, 0x2f, 0x0f, 0x0e, 0x0e };
+
+#define LAZY_FLAGS(op, a, b, r)                              \
+    {                                                        \
+        if (lazy_owned[m_flag_op] & ~lazy_owned[op]) {       \
+            update_cc();                                     \
+        }                                                    \
+        m_flag_op = op;                                      \
+        m_flag_a = a;                                        \
+        m_flag_b = b;                                        \
+        m_flag_r = r;                                        \
+    }
+
+#define FLAGS_NZ8(r) LAZY_FLAGS(LAZY_NZ8, 0, 0, r)
+#define FLAGS_TST8(r) LAZY_FLAGS(LAZY_TST8, 0, 0, r)
+#define FLAGS_NZ16(r) LAZY_FLAGS(LAZY_NZ16, 0, 0, r)
+#define FLAGS_NZVC8(a, b, r) LAZY_FLAGS(LAZY_NZVC8, a, b, r)
+#define FLAGS_HNZVC8(a, b, r) LAZY_FLAGS(LAZY_HNZVC8, a, b, r)
+#define FLAGS_NZVC16(a, b, r) LAZY_FLAGS(LAZY_NZVC16, a, b, r)
+#define FLAGS_INC8(r) LAZY_FLAGS(LAZY_INC8, 0, 0, r)
+#define FLAGS_DEC8(r) LAZY_FLAGS(LAZY_DEC8, 0, 0, r)
+#else
+#define FLAGS_NZ8(r) \
+    {                \
+        CLR_NZV;     \
+        SET_NZ8(r);  \
+    }
+#define FLAGS_TST8(r) \
+    {                 \
+        CLR_NZVC;     \
+        SET_NZ8(r);   \
+    }
+#define FLAGS_NZ16(r) \
+    {                 \
+        CLR_NZV;      \
+        SET_NZ16(r);  \
+    }
+#define FLAGS_NZVC8(a, b, r)   \
+    {                          \
+        CLR_NZVC;              \
+        SET_FLAGS8(a, b, r);   \
+    }
+#define FLAGS_HNZVC8(a, b, r)  \
+    {                          \
+        CLR_HNZVC;             \
+        SET_FLAGS8(a, b, r);   \
+        SET_H(a, b, r);        \
+    }
+#define FLAGS_NZVC16(a, b, r)  \
+    {                          \
+        CLR_NZVC;              \
+        SET_FLAGS16(a, b, r);  \
+    }
+#define FLAGS_INC8(r)       \
+    {                       \
+        CLR_NZV;            \
+        SET_FLAGS8I(r);     \
+    }
+#define FLAGS_DEC8(r)       \
+    {                       \
+        CLR_NZV;            \
+        SET_FLAGS8D(r);     \
+    }
+#endif
+
 /* for treating an uint8_t as a signed int16_t */
 #define SIGNED(b) ((int16_t)(b & 0x80 ? b | 0xff00 : b))
 
@@ -285,15 +382,21 @@ const uint8_t m6800_cpu_device::flags8d[256] = /* decrement */
 #define NXORV ((CC & 0x08) ^ ((CC & 0x02) << 2))
 #define NXORC ((CC & 0x08) ^ ((CC & 0x01) << 3))
 
+/* the bitmap is only looked at when a breakpoint is set, and the full check only for marked addresses */
+#define BREAKPOINTS_ARMED (breakpoint_map != nullptr && breakpoint_map->isArmed())
+#define BREAKPOINT_HIT (breakpoint_map->test(PCD) && check_breakpoint(m_pc.d))
+#define RUN_ABORTED (abort_run.load(std::memory_order_relaxed))
+
 /* include the opcode functions */
 #include "6800ops.hxx"
+#include "6800dispatch.hxx"
 
 uint8_t m6800_cpu_device::read_byte(offs_t address) {
     return memory_map->read(address & 0xFFFF);
 }
 
 void m6800_cpu_device::write_byte(offs_t address, uint8_t data) {
-    // TODO: Better memory mapping to protect ROM / simulate unmapped memory
+    // ROM pages have no write pointer in the page table, so writes to them are dropped by the device
     this->memory_map->write(address & 0xFFFF, data & 0xFF);
 }
 
@@ -417,11 +520,54 @@ const m6800_cpu_device::op_func m6800_cpu_device::nsc8105_insn[0x100] = {
     &m6800_cpu_device::eorb_ex, &m6800_cpu_device::orb_ex, &m6800_cpu_device::adcb_ex, &m6800_cpu_device::addb_ex, &m6800_cpu_device::addx_ex, &m6800_cpu_device::ldx_ex, &m6800_cpu_device::illegl1, &m6800_cpu_device::stx_ex
 };
 
+/* plain function entry points for the handlers of m6800_insn, called from translated code */
+#define OP_THUNK(_code, _name, _cycles) [](m6800_cpu_device* cpu) { cpu->_name(); },
+
+const m6800_cpu_device::op_thunk m6800_cpu_device::m6800_thunks[0x100] = { M6800_OPCODES(OP_THUNK) };
+
+#undef OP_THUNK
+
 m6800_cpu_device::m6800_cpu_device(MemoryMapManager* memory_map) {
     this->memory_map = memory_map;
     verbose = false;
     m_insn = m6800_insn;
     m_cycles = cycles_6800;
+    breakpoint_map = nullptr;
+    abort_run = 0;
+    m_irq_input = CLEAR_LINE;
+    m_nmi_input = CLEAR_LINE;
+    m_nmi_edge = false;
+    trace = nullptr;
+    profile = nullptr;
+    calls = nullptr;
+#if defined(M6800_LAZY_FLAGS)
+    m_flag_op = LAZY_NONE;
+#endif
+    m_block_cache = new m6800_block_cache(memory_map);
+    block_cache_enabled = BLOCK_CACHE_DEFAULT;
+    jit_enabled = M6800_JIT_X64;
+    instructions_retired = 0;
+    delay_loop_enabled = true;
+    delay_loop_hits = 0;
+    delay_loop_cycles = 0;
+#if M6800_JIT_X64
+    m_jit = new m6800_jit(this, m_block_cache);
+#else
+    m_jit = nullptr;
+#endif
+}
+
+m6800_cpu_device::~m6800_cpu_device() {
+#if M6800_JIT_X64
+    delete m_jit;
+#endif
+    delete m_block_cache;
+}
+
+void m6800_cpu_device::enable_jit_perf_map() {
+#if M6800_JIT_X64
+    m_jit->enable_perf_map();
+#endif
 }
 
 uint32_t m6800_cpu_device::RM16(uint32_t Addr) {
@@ -451,6 +597,10 @@ void m6800_cpu_device::enter_interrupt(const char* message, uint16_t irq_vector)
     }
     SEI;
     PCD = RM16(irq_vector);
+
+    if (calls != nullptr) {
+        calls->call(PC, S + 7);
+    }
 }
 
 /* check the IRQ lines for pending interrupts */
@@ -490,7 +640,7 @@ void m6800_cpu_device::device_start() {
     m_s.d = 0;
     m_x.d = 0;
     m_d.d = 0;
-    m_cc = 0;
+    CC = 0;
     m_wai_state = 0;
     m_irq_state[0] = m_irq_state[1] = m_irq_state[2] = 0;
 
@@ -517,7 +667,7 @@ void m6800_cpu_device::device_start() {
 // }
 
 void m6800_cpu_device::device_reset() {
-    m_cc = 0xc0;
+    CC = 0xc0;
     SEI; /* IRQ disabled */
     PCD = RM16(0xfffe);
     reset_line = 1;
@@ -525,24 +675,46 @@ void m6800_cpu_device::device_reset() {
     m_nmi_state = 0;
     m_nmi_pending = 0;
     m_irq_state[M6800_IRQ_LINE] = 0;
+    // a level still held on a line is read again before the next instruction
+    m_nmi_edge = false;
+
+    if (calls != nullptr) {
+        calls->reset_stack();
+    }
 }
 
-// void m6800_cpu_device::execute_set_input(int irqline, int state)
-// {
-// 	switch (irqline)
-// 	{
-// 	case INPUT_LINE_NMI:
-// 		if (!m_nmi_state && state != CLEAR_LINE)
-// 			m_nmi_pending = true;
-// 		m_nmi_state = state;
-// 		break;
-
-// 	default:
-// 		LOG(("set_irq_line %d,%d\n", irqline, state));
-// 		m_irq_state[irqline] = state;
-// 		break;
-// 	}
-// }
+void m6800_cpu_device::execute_set_input(int irqline, int state) {
+    switch (irqline) {
+    case INPUT_LINE_NMI:
+        if (m_nmi_input.exchange(state) == state) {
+            return;
+        }
+        // latched here, so a pulse shorter than an instruction isn't lost
+        if (state != CLEAR_LINE) {
+            m_nmi_edge = true;
+        }
+        break;
+
+    case M6800_IRQ_LINE:
+        if (m_irq_input.exchange(state) == state) {
+            return;
+        }
+        break;
+
+    default:
+        return;
+    }
+    abort_run.fetch_or(ABORT_INPUT);
+}
+
+/* copy the lines set by execute_set_input, only on the thread running the CPU */
+void m6800_cpu_device::read_input_lines() {
+    if (m_nmi_edge.exchange(false)) {
+        m_nmi_pending = true;
+    }
+    m_nmi_state = m_nmi_input.load();
+    m_irq_state[M6800_IRQ_LINE] = m_irq_input.load();
+}
 
 void m6800_cpu_device::pre_execute_run() {
     if (reset_line == 0) {
@@ -575,22 +747,111 @@ void m6800_cpu_device::pre_execute_run() {
     // return 0;
 }
 
+#if defined(M6800_LAZY_FLAGS)
+/* works out the flags of the pending operation into m_cc */
+void m6800_cpu_device::update_cc() {
+    uint32_t a = m_flag_a;
+    uint32_t b = m_flag_b;
+    uint32_t r = m_flag_r;
+    uint8_t op = m_flag_op;
+
+    m_flag_op = LAZY_NONE;
+
+    switch (op) {
+    case LAZY_NZ8:
+        CLR_NZV;
+        SET_NZ8(r);
+        break;
+    case LAZY_TST8:
+        CLR_NZVC;
+        SET_NZ8(r);
+        break;
+    case LAZY_NZ16:
+        CLR_NZV;
+        SET_NZ16(r);
+        break;
+    case LAZY_NZVC8:
+        CLR_NZVC;
+        SET_FLAGS8(a, b, r);
+        break;
+    case LAZY_HNZVC8:
+        CLR_HNZVC;
+        SET_FLAGS8(a, b, r);
+        SET_H(a, b, r);
+        break;
+    case LAZY_NZVC16:
+        CLR_NZVC;
+        SET_FLAGS16(a, b, r);
+        break;
+    case LAZY_INC8:
+        CLR_NZV;
+        SET_FLAGS8I(r);
+        break;
+    case LAZY_DEC8:
+        CLR_NZV;
+        SET_FLAGS8D(r);
+        break;
+    }
+}
+#endif
+
 /****************************************************************************
  * Execute cycles CPU cycles. Return number of cycles really executed
+ *
+ * The loops below only look at the interrupt lines on entry and after
+ * CLI, SEI, TAP and RTI. execute_set_input() stops them after the current
+ * instruction when a line changes, and they start over from here with the
+ * new state, so nothing is polled per instruction.
  ****************************************************************************/
 void m6800_cpu_device::execute_run() {
+    do {
+        // cleared before the lines are read, so a change after that stops the loop again
+        abort_run.fetch_and(~ABORT_INPUT);
+        read_input_lines();
+        execute_run_loop();
+    } while (m_icount > 0 && abort_run.load(std::memory_order_relaxed) == ABORT_INPUT);
+}
+
+void m6800_cpu_device::execute_run_loop() {
+    if (trace != nullptr || profile != nullptr || calls != nullptr) {
+        execute_run_instrumented();
+        return;
+    }
+    if (block_cache_enabled && m_insn == m6800_insn) {
+        // translated code doesn't stop for breakpoints
+        if (jit_enabled && m_jit != nullptr && !BREAKPOINTS_ARMED) {
+            execute_run_jit();
+        } else {
+            execute_run_blocks();
+        }
+        return;
+    }
+#if defined(M6800_DISPATCH_GOTO) && defined(__GNUC__)
+    execute_run_goto();
+#elif defined(M6800_DISPATCH_SWITCH) || defined(M6800_DISPATCH_GOTO)
+    execute_run_switch();
+#else
+    execute_run_table();
+#endif
+}
+
+/****************************************************************************
+ * Dispatch through the opcode function pointer table
+ ****************************************************************************/
+void m6800_cpu_device::execute_run_table() {
     uint8_t ireg;
 
     CHECK_IRQ_LINES(); /* HJB 990417 */
 
     CLEANUP_COUNTERS();
+    bool armed = BREAKPOINTS_ARMED;
 
     do {
         if (m_wai_state & (M6800_WAI | M6800_SLP)) {
             EAT_CYCLES();
         } else {
             pPPC = pPC;
-            if (check_breakpoint(m_pc.d)) {
+            if (armed && BREAKPOINT_HIT) {
                 break;
             }
             // debugger_instruction_hook(PCD);
@@ -598,13 +859,446 @@ void m6800_cpu_device::execute_run() {
             PC++;
             (this->*m_insn[ireg])();
             increment_counter(m_cycles[ireg]);
+            instructions_retired++;
+        }
+    } while (m_icount > 0 && !RUN_ABORTED);
+}
+
+/****************************************************************************
+ * Dispatch through a dense switch. The handlers are visible in this
+ * translation unit so they can be inlined, and the cycle count of each
+ * opcode is folded into its case. Only the 6800 opcode table is covered.
+ ****************************************************************************/
+#define OP_CASE(_code, _name, _cycles) \
+    case _code:                        \
+        _name();                       \
+        m_icount -= _cycles;           \
+        break;
+
+void m6800_cpu_device::execute_run_switch() {
+    uint8_t ireg;
+
+    if (m_insn != m6800_insn) {
+        execute_run_table();
+        return;
+    }
+
+    CHECK_IRQ_LINES(); /* HJB 990417 */
+
+    CLEANUP_COUNTERS();
+    bool armed = BREAKPOINTS_ARMED;
+
+    do {
+        if (m_wai_state & (M6800_WAI | M6800_SLP)) {
+            EAT_CYCLES();
+        } else {
+            pPPC = pPC;
+            if (armed && BREAKPOINT_HIT) {
+                break;
+            }
+            ireg = M_RDOP(PCD);
+            PC++;
+            switch (ireg) {
+                M6800_OPCODES(OP_CASE)
+            }
+            instructions_retired++;
+        }
+    } while (m_icount > 0 && !RUN_ABORTED);
+}
+
+#undef OP_CASE
+
+/****************************************************************************
+ * Run predecoded blocks from the block cache. Addresses that can't be cached
+ * (I/O pages, instructions straddling a page) are interpreted one at a time.
+ * When a switch dispatch is selected, micro-ops are dispatched on their
+ * opcode so the handlers can be inlined.
+ ****************************************************************************/
+#if defined(M6800_DISPATCH_SWITCH) || defined(M6800_DISPATCH_GOTO)
+#define OP_CALL(_code, _name, _cycles) \
+    case _code:                        \
+        _name();                       \
+        break;
+#define EXECUTE_UOP(op)                \
+    switch (op->opcode) {              \
+        M6800_OPCODES(OP_CALL)         \
+    }
+#else
+#define EXECUTE_UOP(op) (this->*op->handler)()
+#endif
+
+void m6800_cpu_device::execute_run_blocks() {
+    uint8_t ireg;
+
+    CHECK_IRQ_LINES(); /* HJB 990417 */
+
+    CLEANUP_COUNTERS();
+    bool armed = BREAKPOINTS_ARMED;
+
+    do {
+        if (m_wai_state & (M6800_WAI | M6800_SLP)) {
+            EAT_CYCLES();
+            continue;
+        }
+
+        m6800_block* block = m_block_cache->lookup(PCD, m_insn, m_cycles);
+
+        if (block == nullptr) {
+            pPPC = pPC;
+            if (armed && BREAKPOINT_HIT) {
+                break;
+            }
+            ireg = M_RDOP(PCD);
+            PC++;
+            (this->*m_insn[ireg])();
+            increment_counter(m_cycles[ireg]);
+            instructions_retired++;
+            continue;
+        }
+
+        m_block_cache->invalidated = false;
+
+        if (block->loop != LOOP_NONE && delay_loop_enabled && !(armed && has_breakpoint(block))) {
+            skip_delay_loop(block);
+        }
+
+        const m6800_uop* op = block->ops;
+        const m6800_uop* end = op + block->count;
+
+        for (; op != end; op++) {
+            pPPC = pPC;
+            if (armed && BREAKPOINT_HIT) {
+                return;
+            }
+            PC++;
+            EXECUTE_UOP(op);
+            m_icount -= op->cycles;
+            instructions_retired++;
+
+            // a store may have rewritten the rest of this block
+            if (m_icount <= 0 || m_block_cache->invalidated || RUN_ABORTED) {
+                break;
+            }
+        }
+    } while (m_icount > 0 && !RUN_ABORTED);
+}
+
+/****************************************************************************
+ * Run blocks from the block cache, translating the ones that run often to
+ * native code. Only used while no breakpoints are set, so unlike
+ * execute_run_blocks() it never calls check_breakpoint.
+ ****************************************************************************/
+void m6800_cpu_device::execute_run_jit() {
+#if M6800_JIT_X64
+    uint8_t ireg;
+
+    CHECK_IRQ_LINES(); /* HJB 990417 */
+
+    CLEANUP_COUNTERS();
+
+    do {
+        if (m_wai_state & (M6800_WAI | M6800_SLP)) {
+            EAT_CYCLES();
+            continue;
+        }
+
+        m6800_block* block = m_block_cache->lookup(PCD, m_insn, m_cycles);
+
+        if (block == nullptr) {
+            pPPC = pPC;
+            ireg = M_RDOP(PCD);
+            PC++;
+            (this->*m_insn[ireg])();
+            increment_counter(m_cycles[ireg]);
+            instructions_retired++;
+            continue;
         }
-    } while (m_icount > 0);
+
+        m_block_cache->invalidated = false;
+
+        if (block->native == nullptr && ++block->hits == m6800_jit::HOT_THRESHOLD) {
+            m_jit->compile(block);
+        }
+
+        if (block->loop != LOOP_NONE && delay_loop_enabled) {
+            skip_delay_loop(block);
+        }
+
+        // translated code only checks m_icount at the end of the block
+        if (block->native != nullptr && m_icount > block->cycles) {
+            block->native(this);
+            continue;
+        }
+
+        const m6800_uop* op = block->ops;
+        const m6800_uop* end = op + block->count;
+
+        for (; op != end; op++) {
+            pPPC = pPC;
+            PC++;
+            EXECUTE_UOP(op);
+            m_icount -= op->cycles;
+            instructions_retired++;
+
+            if (m_icount <= 0 || m_block_cache->invalidated || RUN_ABORTED) {
+                break;
+            }
+        }
+    } while (m_icount > 0 && !RUN_ABORTED);
+#else
+    execute_run_blocks();
+#endif
 }
 
+#undef EXECUTE_UOP
+#undef OP_CALL
+
+void m6800_cpu_device::trace_instruction(uint8_t ireg, int icount) {
+    uint8_t bytes[3] = { ireg, 0, 0 };
+    int length = m6800_block_cache::instruction_length(ireg);
+    for (int i = 1; i < length; i++) {
+        bytes[i] = M_RDOP_ARG((PCD + i) & 0xffff);
+    }
+    trace->record(icount, PC, bytes, length, A, B, X, S, CC);
+}
+
+void m6800_cpu_device::track_calls(uint8_t ireg) {
+    calls->unwind(S);
+    // JSR and BSR leave the return address on the stack, SWI all the registers
+    if (ireg == 0x8d || ireg == 0xad || ireg == 0xbd) {
+        calls->call(PC, S + 2);
+    } else if (ireg == 0x3f) {
+        calls->call(PC, S + 7);
+    }
+}
+
+bool m6800_cpu_device::has_breakpoint(const m6800_block* block) {
+    for (int i = 0; i < block->count; i++) {
+        if (breakpoint_map->test(block->ops[i].pc)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/****************************************************************************
+ * Runs all turns but the last of a counted delay loop, see m6800_block_cache,
+ * by moving its counter on and taking the cycles. The last turn is left to
+ * the caller, so the flags and PC come out of the instructions themselves.
+ * No more turns are skipped than fit in m_icount, so a run still ends on the
+ * instruction it would have ended on. The loop reads no memory and can't
+ * change the input lines, so nothing it would have seen is skipped.
+ ****************************************************************************/
+void m6800_cpu_device::skip_delay_loop(const m6800_block* block) {
+    uint32_t range = 0x100;
+    uint32_t counter;
+    bool down = block->loop == LOOP_DEX || block->loop == LOOP_DECA || block->loop == LOOP_DECB;
+
+    if (block->loop == LOOP_DEX || block->loop == LOOP_INX) {
+        range = 0x10000;
+        counter = X;
+    } else if (block->loop == LOOP_DECA || block->loop == LOOP_INCA) {
+        counter = A;
+    } else {
+        counter = B;
+    }
+
+    // turns until the counter reaches zero, a counter that starts at zero wraps around first
+    uint32_t turns = down ? counter : range - counter;
+    if (turns == 0) {
+        turns = range;
+    }
+    uint32_t skip = turns - 1;
+    uint32_t fit = m_icount > 0 ? (uint32_t)(m_icount - 1) / block->cycles : 0;
+    if (skip > fit) {
+        skip = fit;
+    }
+    if (skip == 0) {
+        return;
+    }
+
+    counter = (down ? counter - skip : counter + skip) & (range - 1);
+    if (range == 0x10000) {
+        X = counter;
+    } else if (block->loop == LOOP_DECA || block->loop == LOOP_INCA) {
+        A = counter;
+    } else {
+        B = counter;
+    }
+    m_icount -= skip * block->cycles;
+    instructions_retired += skip * block->count;
+    delay_loop_hits++;
+    delay_loop_cycles += skip * block->cycles;
+}
+
+/****************************************************************************
+ * Run like execute_run_blocks(), logging each instruction to the trace before
+ * it runs and counting it in the profiles. Replaces the other loops while
+ * any of them is attached, so they don't pay for instrumentation when it's
+ * off.
+ ****************************************************************************/
+void m6800_cpu_device::execute_run_instrumented() {
+    uint8_t ireg;
+    uint8_t bytes[3];
+
+    if (trace != nullptr) {
+        trace->begin_run(m_icount);
+    }
+
+    CHECK_IRQ_LINES(); /* HJB 990417 */
+
+    CLEANUP_COUNTERS();
+    bool armed = BREAKPOINTS_ARMED;
+    bool blocks = block_cache_enabled && m_insn == m6800_insn;
+
+    do {
+        if (m_wai_state & (M6800_WAI | M6800_SLP)) {
+            EAT_CYCLES();
+            continue;
+        }
+
+        m6800_block* block = blocks ? m_block_cache->lookup(PCD, m_insn, m_cycles) : nullptr;
+
+        if (block == nullptr) {
+            pPPC = pPC;
+            if (armed && BREAKPOINT_HIT) {
+                break;
+            }
+            ireg = M_RDOP(PCD);
+            if (trace != nullptr) {
+                trace_instruction(ireg, m_icount);
+            }
+            if (profile != nullptr) {
+                profile->record(PC, m_cycles[ireg]);
+            }
+            if (calls != nullptr) {
+                calls->charge(m_cycles[ireg]);
+            }
+            PC++;
+            (this->*m_insn[ireg])();
+            increment_counter(m_cycles[ireg]);
+            instructions_retired++;
+            if (calls != nullptr) {
+                track_calls(ireg);
+            }
+            continue;
+        }
+
+        m_block_cache->invalidated = false;
+
+        const m6800_uop* op = block->ops;
+        const m6800_uop* end = op + block->count;
+
+        for (; op != end; op++) {
+            pPPC = pPC;
+            if (armed && BREAKPOINT_HIT) {
+                if (trace != nullptr) {
+                    trace->end_run(m_icount);
+                }
+                return;
+            }
+            if (trace != nullptr) {
+                // the block already holds the operand, no need to read it again
+                bytes[0] = op->opcode;
+                if (op->length == 3) {
+                    bytes[1] = op->operand >> 8;
+                    bytes[2] = op->operand & 0xff;
+                } else {
+                    bytes[1] = op->operand & 0xff;
+                }
+                trace->record(m_icount, PC, bytes, op->length, A, B, X, S, CC);
+            }
+            if (profile != nullptr) {
+                profile->record(PC, op->cycles);
+            }
+            if (calls != nullptr) {
+                calls->charge(op->cycles);
+            }
+            PC++;
+            (this->*op->handler)();
+            m_icount -= op->cycles;
+            instructions_retired++;
+            if (calls != nullptr) {
+                track_calls(op->opcode);
+            }
+
+            if (m_icount <= 0 || m_block_cache->invalidated || RUN_ABORTED) {
+                break;
+            }
+        }
+    } while (m_icount > 0 && !RUN_ABORTED);
+
+    if (trace != nullptr) {
+        trace->end_run(m_icount);
+    }
+}
+
+#if defined(__GNUC__)
+/****************************************************************************
+ * Threaded dispatch using GCC computed goto labels. Each handler ends with
+ * its own copy of the fetch, so every opcode has its own indirect branch.
+ ****************************************************************************/
+#define OP_LABEL(_code, _name, _cycles) &&op_##_code,
+
+#define OP_BODY(_code, _name, _cycles) \
+    op_##_code : _name();              \
+    m_icount -= _cycles;               \
+    instructions_retired++;            \
+    if (m_icount <= 0 || RUN_ABORTED)  \
+        return;                        \
+    FETCH_NEXT;
+
+#define FETCH_NEXT                                     \
+    if (m_wai_state & (M6800_WAI | M6800_SLP)) {       \
+        goto wait;                                     \
+    }                                                  \
+    pPPC = pPC;                                        \
+    if (armed && BREAKPOINT_HIT) {                     \
+        return;                                        \
+    }                                                  \
+    ireg = M_RDOP(PCD);                                \
+    PC++;                                              \
+    goto* dispatch[ireg];
+
+void m6800_cpu_device::execute_run_goto() {
+    static const void* const dispatch[0x100] = { M6800_OPCODES(OP_LABEL) };
+    uint8_t ireg;
+
+    if (m_insn != m6800_insn) {
+        execute_run_table();
+        return;
+    }
+
+    CHECK_IRQ_LINES(); /* HJB 990417 */
+
+    CLEANUP_COUNTERS();
+    bool armed = BREAKPOINTS_ARMED;
+
+    FETCH_NEXT;
+
+wait:
+    EAT_CYCLES();
+    if (m_icount <= 0)
+        return;
+    FETCH_NEXT;
+
+    M6800_OPCODES(OP_BODY)
+}
+
+#undef FETCH_NEXT
+#undef OP_BODY
+#undef OP_LABEL
+#endif // __GNUC__
+
 void m6800_cpu_device::execute_step() {
     uint8_t ireg;
 
+    if (trace != nullptr) {
+        trace->begin_run(m_icount);
+    }
+
+    abort_run.fetch_and(~ABORT_INPUT);
+    read_input_lines();
     CHECK_IRQ_LINES(); /* HJB 990417 */
 
     CLEANUP_COUNTERS();
@@ -615,12 +1309,69 @@ void m6800_cpu_device::execute_step() {
         pPPC = pPC;
         // debugger_instruction_hook(PCD);
         ireg = M_RDOP(PCD);
+        if (trace != nullptr) {
+            trace_instruction(ireg, m_icount);
+        }
+        if (profile != nullptr) {
+            profile->record(PC, m_cycles[ireg]);
+        }
+        if (calls != nullptr) {
+            calls->charge(m_cycles[ireg]);
+        }
         PC++;
         (this->*m_insn[ireg])();
         increment_counter(m_cycles[ireg]);
+        instructions_retired++;
+        if (calls != nullptr) {
+            track_calls(ireg);
+        }
+    }
+
+    if (trace != nullptr) {
+        trace->end_run(m_icount);
     }
 }
 
 CpuStatus m6800_cpu_device::get_status() {
-    return CpuStatus { m_pc.d, m_s.d, m_x.d, m_d.b.h, m_d.b.l, m_cc };
+    return CpuStatus { m_pc.d, m_s.d, m_x.d, m_d.b.h, m_d.b.l, CC };
+}
+
+void m6800_cpu_device::save_state(m6800_state& state) {
+    state.ppc = m_ppc.w.l;
+    state.pc = m_pc.w.l;
+    state.s = m_s.w.l;
+    state.x = m_x.w.l;
+    state.a = m_d.b.h;
+    state.b = m_d.b.l;
+    state.cc = CC;
+    state.wai_state = m_wai_state;
+    state.nmi_state = m_nmi_state;
+    state.nmi_pending = m_nmi_pending;
+    memcpy(state.irq_state, m_irq_state, sizeof(m_irq_state));
+    state.icount = m_icount;
+    state.reset_line = reset_line;
+}
+
+void m6800_cpu_device::load_state(const m6800_state& state) {
+    m_ppc.d = state.ppc;
+    m_pc.d = state.pc;
+    m_s.d = state.s;
+    m_x.d = state.x;
+    m_d.d = 0;
+    m_d.b.h = state.a;
+    m_d.b.l = state.b;
+#if defined(M6800_LAZY_FLAGS)
+    m_flag_op = LAZY_NONE;
+#endif
+    m_cc = state.cc;
+    m_wai_state = state.wai_state;
+    m_nmi_state = state.nmi_state;
+    m_nmi_pending = state.nmi_pending;
+    memcpy(m_irq_state, state.irq_state, sizeof(m_irq_state));
+    // the devices driving the lines set them again as their own state is loaded
+    m_irq_input = m_irq_state[M6800_IRQ_LINE];
+    m_nmi_input = m_nmi_state;
+    m_nmi_edge = false;
+    m_icount = state.icount;
+    reset_line = state.reset_line;
 }
@@ -5,6 +5,7 @@
 #ifndef MAME_CPU_M6800_M6800_H
 #define MAME_CPU_M6800_M6800_H
 
+#include <atomic>
 #include <functional>
 #include <stdint.h>
 #include <stdio.h>
@@ -29,13 +30,41 @@
 // 	virtual void execute_set_input(int inputnum, int state);
 // };
 
+struct m6800_block;
+class m6800_block_cache;
+class m6800_jit;
+class m6800_call_profiler;
+class m6800_profiler;
+class m6800_trace;
+
+// everything needed to carry on from where the CPU stopped, for save states
+struct m6800_state {
+    uint16_t ppc;
+    uint16_t pc;
+    uint16_t s;
+    uint16_t x;
+    uint8_t a;
+    uint8_t b;
+    uint8_t cc;
+    uint8_t wai_state;
+    uint8_t nmi_state;
+    uint8_t nmi_pending;
+    uint8_t irq_state[3];
+    int32_t icount;
+    int32_t reset_line;
+};
+
 class m6800_cpu_device {
+    friend class m6800_jit;
+
 public:
     typedef void (m6800_cpu_device::*op_func)();
+    typedef void (*op_thunk)(m6800_cpu_device* cpu);
 
     // construction/destruction
     // m6800_cpu_device(const machine_config &mconfig, const char *tag, device_t *owner, uint32_t clock);
     m6800_cpu_device(MemoryMapManager* memory_map);
+    ~m6800_cpu_device();
 
     enum {
         M6800_WAI = 8, /* set when WAI is waiting for an interrupt */
@@ -62,11 +91,33 @@ public:
         return inputnum == INPUT_LINE_NMI;
     }
     void execute_run();
+    void execute_run_table();
+    void execute_run_switch();
+    void execute_run_blocks();
+    void execute_run_jit();
+    void execute_run_instrumented();
+#if defined(__GNUC__)
+    void execute_run_goto();
+#endif
     void execute_step();
+    // sets the IRQ line (level triggered) or INPUT_LINE_NMI (edge triggered) to CLEAR_LINE or
+    // ASSERT_LINE; may be called from any thread, and a change ends the current instruction's
+    // slice of execute_run() so the interrupt is taken before the next one
     void execute_set_input(int inputnum, int state);
     void pre_execute_run();
-    std::function<bool(uint32_t)> check_breakpoint;
+    std::function<bool(uint32_t)> check_breakpoint; /* only called for addresses set in breakpoint_map */
+    const BreakpointBitmap* breakpoint_map;
+    enum {
+        ABORT_REQUEST = 1, /* leave execute_run() */
+        ABORT_INPUT = 2 /* an input line changed, execute_run() picks it up and carries on */
+    };
+    std::atomic<uint8_t> abort_run; /* ABORT_ bits, set from any thread to stop the CPU loop after the current instruction */
+    m6800_trace* trace; /* logs every instruction while set, only changed between runs */
+    m6800_profiler* profile; /* counts every instruction while set, only changed between runs */
+    m6800_call_profiler* calls; /* follows calls and returns while set, only changed between runs */
     CpuStatus get_status();
+    void save_state(m6800_state& state);
+    void load_state(const m6800_state& state);
     // device_memory_interface overrides
     // virtual space_config_vector memory_space_config() const override;
 
@@ -90,6 +141,9 @@ public:
     uint8_t m_nmi_state; /* NMI line state */
     uint8_t m_nmi_pending; /* NMI pending */
     uint8_t m_irq_state[3]; /* IRQ line state [IRQ1,TIN,SC1] */
+    std::atomic<uint8_t> m_irq_input; /* IRQ line as last set by execute_set_input */
+    std::atomic<uint8_t> m_nmi_input; /* NMI line as last set by execute_set_input */
+    std::atomic<bool> m_nmi_edge; /* NMI was asserted since the lines were last read */
 
     /* Memory spaces */
     // memory_access<16, 0, 0, ENDIANNESS_BIG>::cache m_cprogram, m_copcodes;
@@ -103,8 +157,15 @@ public:
     const op_func* m_insn;
     const uint8_t* m_cycles; /* clock cycle of instruction table */
     int m_icount;
+    unsigned long long instructions_retired; /* only touched by the thread running the CPU */
     int reset_line;
     bool verbose;
+    bool block_cache_enabled; /* run predecoded blocks from the block cache, defaults to the build options */
+    bool jit_enabled; /* translate hot blocks to native code, needs block_cache_enabled and a build with the JIT */
+    bool delay_loop_enabled; /* run counted delay loops at once, needs block_cache_enabled, see m6800_block_cache */
+    std::atomic<unsigned long long> delay_loop_hits; /* delay loops run at once */
+    std::atomic<unsigned long long> delay_loop_cycles; /* cycles they took */
+    void enable_jit_perf_map();
 
 protected:
     PAIR m_ea; /* effective address */
@@ -115,6 +176,34 @@ protected:
     static const uint8_t cycles_nsc8105[256];
     static const op_func m6800_insn[256];
     static const op_func nsc8105_insn[256];
+    static const op_thunk m6800_thunks[256];
+
+#if defined(M6800_LAZY_FLAGS)
+    enum {
+        LAZY_NONE,
+        LAZY_NZ8, /* loads, stores, logic: N Z, V cleared */
+        LAZY_TST8, /* N Z, V and C cleared */
+        LAZY_NZ16, /* 16-bit loads and stores */
+        LAZY_NZVC8, /* subtract, compare, negate, shift left */
+        LAZY_HNZVC8, /* add */
+        LAZY_NZVC16, /* 16-bit subtract, compare, shift left */
+        LAZY_INC8,
+        LAZY_DEC8
+    };
+
+    uint8_t m_flag_op; /* operation whose flags haven't been written to m_cc yet */
+    uint32_t m_flag_a; /* its operands and result */
+    uint32_t m_flag_b;
+    uint32_t m_flag_r;
+
+    void update_cc();
+    uint8_t& cc_ref() {
+        if (m_flag_op != LAZY_NONE) {
+            update_cc();
+        }
+        return m_cc;
+    }
+#endif
 
     uint32_t RM16(uint32_t Addr);
     void WM16(uint32_t Addr, PAIR* p);
@@ -124,6 +213,12 @@ protected:
     void CHECK_IRQ_LINES();
     virtual void increment_counter(int amount);
     virtual void EAT_CYCLES();
+    void trace_instruction(uint8_t ireg, int icount);
+    void track_calls(uint8_t ireg);
+    bool has_breakpoint(const m6800_block* block);
+    void skip_delay_loop(const m6800_block* block);
+    void read_input_lines();
+    void execute_run_loop();
     virtual void CLEANUP_COUNTERS() {
     }
     virtual void TAKE_TRAP() {
@@ -382,6 +477,8 @@ protected:
 private:
     MemoryMapManager* memory_map;
     BreakpointManager* breakpoint_manager;
+    m6800_block_cache* m_block_cache;
+    m6800_jit* m_jit;
 };
 
 #endif // MAME_CPU_M6800_M6800_H
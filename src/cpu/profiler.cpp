@@ -0,0 +1,30 @@
+#include "profiler.h"
+
+#include <string.h>
+
+m6800_profiler::m6800_profiler() {
+    clear();
+}
+
+void m6800_profiler::clear() {
+    memset(counts, 0, sizeof(counts));
+    memset(cycles, 0, sizeof(cycles));
+}
+
+unsigned long long m6800_profiler::get_total_cycles() const {
+    unsigned long long total = 0;
+    for (int i = 0; i < ADDRESSES; i++) {
+        total += cycles[i];
+    }
+    return total;
+}
+
+uint32_t m6800_profiler::get_max_cycles() const {
+    uint32_t max = 0;
+    for (int i = 0; i < ADDRESSES; i++) {
+        if (cycles[i] > max) {
+            max = cycles[i];
+        }
+    }
+    return max;
+}
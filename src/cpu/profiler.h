@@ -0,0 +1,47 @@
+#ifndef M6800_PROFILER_H
+#define M6800_PROFILER_H
+
+#include <stdint.h>
+
+/*
+    Execution profiler
+
+    While a profiler is attached to the CPU, every instruction adds one to the count of the
+    address it started at and its cycles (from the opcode's cycle table) to that address's
+    cycle total. Both are flat arrays indexed by PC, so recording is two increments with no
+    lookups. Cycles spent waiting in WAI and entering interrupts aren't tied to an instruction
+    and aren't counted.
+
+    The counters are 32 bit: at 1 MHz a loop at a single address wraps its cycle total after
+    a bit over an hour of emulated time.
+*/
+class m6800_profiler {
+public:
+    static const int ADDRESSES = 0x10000;
+
+    m6800_profiler();
+
+    void clear();
+
+    void record(uint16_t pc, uint8_t cycles) {
+        counts[pc]++;
+        this->cycles[pc] += cycles;
+    }
+
+    uint32_t get_count(uint16_t address) const {
+        return counts[address];
+    }
+
+    uint32_t get_cycles(uint16_t address) const {
+        return cycles[address];
+    }
+
+    unsigned long long get_total_cycles() const;
+    uint32_t get_max_cycles() const;
+
+private:
+    uint32_t counts[ADDRESSES];
+    uint32_t cycles[ADDRESSES];
+};
+
+#endif // M6800_PROFILER_H
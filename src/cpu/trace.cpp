@@ -0,0 +1,243 @@
+#include "trace.h"
+
+#include <chrono>
+#include <string.h>
+
+static const char TRACE_MAGIC[8] = { 'E', 'T', '3', '4', '0', '0', 'T', 'R' };
+static const uint32_t TRACE_VERSION = 1;
+
+m6800_trace::m6800_trace() {
+    ring = new uint8_t[RING_SIZE];
+    head = 0;
+    tail = 0;
+    running = false;
+    file = nullptr;
+    local_head = 0;
+    published = 0;
+    cached_tail = 0;
+    cycle = 0;
+    last_cycle = 0;
+    last_icount = 0;
+    records = 0;
+}
+
+m6800_trace::~m6800_trace() {
+    close();
+    delete[] ring;
+}
+
+bool m6800_trace::open(const char* path, unsigned long long cycle) {
+    close();
+
+    file = fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+    uint8_t header[20];
+    memcpy(header, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    for (int i = 0; i < 4; i++) {
+        header[8 + i] = (TRACE_VERSION >> (i * 8)) & 0xFF;
+    }
+    for (int i = 0; i < 8; i++) {
+        header[12 + i] = (cycle >> (i * 8)) & 0xFF;
+    }
+    fwrite(header, 1, sizeof(header), file);
+
+    head = 0;
+    tail = 0;
+    local_head = 0;
+    published = 0;
+    cached_tail = 0;
+    this->cycle = cycle;
+    last_cycle = cycle;
+    last_icount = 0;
+    records = 0;
+    // out of range, so the first record carries every field
+    next_pc = 0x10000;
+    last_a = last_b = last_cc = 0x100;
+    last_x = last_s = 0x10000;
+
+    running = true;
+    drain_thread = std::thread(&m6800_trace::drain, this);
+    return true;
+}
+
+void m6800_trace::close() {
+    if (file == nullptr) {
+        return;
+    }
+    publish();
+    running = false;
+    drain_thread.join();
+    fclose(file);
+    file = nullptr;
+}
+
+bool m6800_trace::is_open() {
+    return file != nullptr;
+}
+
+unsigned long long m6800_trace::get_records() {
+    return records;
+}
+
+unsigned long long m6800_trace::get_bytes() {
+    return local_head;
+}
+
+void m6800_trace::wait_for_space() {
+    publish();
+    while (true) {
+        cached_tail = tail.load(std::memory_order_acquire);
+        if (RING_SIZE - (local_head - cached_tail) >= MAX_RECORD) {
+            break;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void m6800_trace::drain() {
+    while (true) {
+        // read before head, so everything published before close() is written out
+        bool stopping = !running.load(std::memory_order_acquire);
+        size_t end = head.load(std::memory_order_acquire);
+        size_t start = tail.load(std::memory_order_relaxed);
+
+        if (end != start) {
+            size_t offset = start & (RING_SIZE - 1);
+            size_t count = end - start;
+            size_t first = count < RING_SIZE - offset ? count : RING_SIZE - offset;
+            fwrite(&ring[offset], 1, first, file);
+            if (count > first) {
+                fwrite(ring, 1, count - first, file);
+            }
+            tail.store(end, std::memory_order_release);
+        } else if (stopping) {
+            break;
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    fflush(file);
+}
+
+m6800_trace_reader::m6800_trace_reader() {
+    file = nullptr;
+    memset(&last, 0, sizeof(last));
+    next_pc = 0;
+}
+
+m6800_trace_reader::~m6800_trace_reader() {
+    close();
+}
+
+bool m6800_trace_reader::open(const char* path) {
+    close();
+
+    file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    uint8_t header[20];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0) {
+        close();
+        return false;
+    }
+    uint32_t version = 0;
+    for (int i = 0; i < 4; i++) {
+        version |= (uint32_t)header[8 + i] << (i * 8);
+    }
+    if (version == 0 || version > TRACE_VERSION) {
+        close();
+        return false;
+    }
+
+    memset(&last, 0, sizeof(last));
+    for (int i = 0; i < 8; i++) {
+        last.cycle |= (unsigned long long)header[12 + i] << (i * 8);
+    }
+    next_pc = 0;
+    return true;
+}
+
+bool m6800_trace_reader::next(m6800_trace_record& record) {
+    if (file == nullptr) {
+        return false;
+    }
+
+    uint8_t header;
+    if (!read(header) || (header & 0x03) == 0) {
+        return false;
+    }
+
+    unsigned long long delta = 0;
+    int shift = 0;
+    uint8_t part;
+    do {
+        if (!read(part) || shift > 63) {
+            return false;
+        }
+        delta |= (unsigned long long)(part & 0x7F) << shift;
+        shift += 7;
+    } while (part & 0x80);
+
+    record = last;
+    record.cycle += delta;
+    record.pc = next_pc;
+    record.length = header & 0x03;
+
+    if ((header & 0x04) && !read16(record.pc)) {
+        return false;
+    }
+    if ((header & 0x08) && !read(record.a)) {
+        return false;
+    }
+    if ((header & 0x10) && !read(record.b)) {
+        return false;
+    }
+    if ((header & 0x20) && !read16(record.x)) {
+        return false;
+    }
+    if ((header & 0x40) && !read16(record.s)) {
+        return false;
+    }
+    if ((header & 0x80) && !read(record.cc)) {
+        return false;
+    }
+    memset(record.bytes, 0, sizeof(record.bytes));
+    if (fread(record.bytes, 1, record.length, file) != record.length) {
+        return false;
+    }
+
+    last = record;
+    next_pc = record.pc + record.length;
+    return true;
+}
+
+void m6800_trace_reader::close() {
+    if (file != nullptr) {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+bool m6800_trace_reader::read(uint8_t& value) {
+    int c = fgetc(file);
+    if (c == EOF) {
+        return false;
+    }
+    value = c;
+    return true;
+}
+
+bool m6800_trace_reader::read16(uint16_t& value) {
+    uint8_t low, high;
+    if (!read(low) || !read(high)) {
+        return false;
+    }
+    value = low | (high << 8);
+    return true;
+}
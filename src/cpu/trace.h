@@ -0,0 +1,199 @@
+#ifndef M6800_TRACE_H
+#define M6800_TRACE_H
+
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+#include <thread>
+
+/*
+    Instruction trace
+
+    While a trace is attached to the CPU, execute_run() interprets one instruction at a time
+    and logs each one before it runs: the PC, the opcode bytes, the registers and the cycle
+    count. Records go into a preallocated byte ring that the emulation thread fills and a
+    background thread drains to the trace file, with no locks between the two; when the ring
+    is full the emulation thread waits for the drain rather than drop records. With no trace
+    attached the CPU's other loops run untouched.
+
+    The file starts with an 8 byte magic, a version number and the cycle count of the first
+    record. Each record is delta-encoded against the one before it:
+
+        header    bits 0-1 instruction length (1-3), bit 2 PC, bit 3 A, bit 4 B, bit 5 X,
+                  bit 6 S, bit 7 CC - a set bit means the field follows
+        cycles    since the previous record, LEB128
+        PC        16 bit, only when it isn't the previous PC plus the previous length
+        A, B, X, S, CC  only the ones that changed, 16 bit values little-endian
+        opcode    the instruction's bytes
+
+    so a straight-line instruction that changes one register takes four to six bytes.
+*/
+
+struct m6800_trace_record {
+    unsigned long long cycle;
+    uint16_t pc;
+    uint8_t a;
+    uint8_t b;
+    uint16_t x;
+    uint16_t s;
+    uint8_t cc;
+    uint8_t length;
+    uint8_t bytes[3];
+};
+
+class m6800_trace {
+public:
+    static const size_t RING_SIZE = 1 << 22; /* power of two */
+    static const size_t MAX_RECORD = 20;
+    static const size_t PUBLISH_BYTES = 1 << 16; /* records handed to the drain thread at a time */
+
+    m6800_trace();
+    ~m6800_trace();
+
+    // creates the file and starts the drain thread, cycle is the count of the first record
+    bool open(const char* path, unsigned long long cycle);
+    // writes out what is left and closes the file, once the CPU no longer uses the trace
+    void close();
+    bool is_open();
+    unsigned long long get_records();
+    unsigned long long get_bytes();
+
+    // called by the CPU around each execute_run() and for every instruction in between,
+    // icount is the CPU's m_icount at that point
+    void begin_run(int icount) {
+        last_icount = icount;
+    }
+
+    void end_run(int icount) {
+        cycle += last_icount - icount;
+        last_icount = icount;
+        publish();
+    }
+
+    void record(int icount, uint16_t pc, const uint8_t* bytes, int length, uint8_t a, uint8_t b, uint16_t x, uint16_t s, uint8_t cc) {
+        cycle += last_icount - icount;
+        last_icount = icount;
+
+        if (RING_SIZE - (local_head - cached_tail) < MAX_RECORD) {
+            wait_for_space();
+        }
+
+        size_t start = local_head;
+        uint8_t header = length;
+        local_head++;
+
+        unsigned long long delta = cycle - last_cycle;
+        last_cycle = cycle;
+        do {
+            uint8_t part = delta & 0x7F;
+            delta >>= 7;
+            put(delta != 0 ? part | 0x80 : part);
+        } while (delta != 0);
+
+        if (pc != next_pc) {
+            header |= 0x04;
+            put16(pc);
+        }
+        if (a != last_a) {
+            header |= 0x08;
+            put(a);
+        }
+        if (b != last_b) {
+            header |= 0x10;
+            put(b);
+        }
+        if (x != last_x) {
+            header |= 0x20;
+            put16(x);
+        }
+        if (s != last_s) {
+            header |= 0x40;
+            put16(s);
+        }
+        if (cc != last_cc) {
+            header |= 0x80;
+            put(cc);
+        }
+        for (int i = 0; i < length; i++) {
+            put(bytes[i]);
+        }
+        ring[start & (RING_SIZE - 1)] = header;
+
+        next_pc = (pc + length) & 0xFFFF;
+        last_a = a;
+        last_b = b;
+        last_x = x;
+        last_s = s;
+        last_cc = cc;
+        records++;
+
+        if (local_head - published >= PUBLISH_BYTES) {
+            publish();
+        }
+    }
+
+private:
+    uint8_t* ring;
+    std::atomic<size_t> head; /* bytes published by the CPU, only grows */
+    std::atomic<size_t> tail; /* bytes written to the file, only grows */
+    std::atomic<bool> running;
+    std::thread drain_thread;
+    FILE* file;
+
+    // owned by the CPU thread
+    size_t local_head;
+    size_t published;
+    size_t cached_tail;
+    unsigned long long cycle;
+    unsigned long long last_cycle;
+    int last_icount;
+    unsigned long long records;
+    // the previous record, every field of the first record differs from these
+    uint32_t next_pc;
+    uint32_t last_a;
+    uint32_t last_b;
+    uint32_t last_x;
+    uint32_t last_s;
+    uint32_t last_cc;
+
+    void put(uint8_t value) {
+        ring[local_head & (RING_SIZE - 1)] = value;
+        local_head++;
+    }
+
+    void put16(uint16_t value) {
+        put(value & 0xFF);
+        put(value >> 8);
+    }
+
+    void publish() {
+        published = local_head;
+        head.store(local_head, std::memory_order_release);
+    }
+
+    void wait_for_space();
+    void drain();
+};
+
+// reads a trace file back one record at a time
+class m6800_trace_reader {
+public:
+    m6800_trace_reader();
+    ~m6800_trace_reader();
+
+    // false if the file can't be read or isn't a trace
+    bool open(const char* path);
+    // false at the end of the file or on a record that is cut short
+    bool next(m6800_trace_record& record);
+    void close();
+
+private:
+    FILE* file;
+    m6800_trace_record last;
+    uint16_t next_pc;
+
+    bool read(uint8_t& value);
+    bool read16(uint16_t& value);
+};
+
+#endif // M6800_TRACE_H
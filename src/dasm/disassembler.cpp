@@ -1,5 +1,7 @@
 #include "disassembler.h"
 
+#include <string.h>
+
 const char Disassembler::op_name_str_orig[128][8] = {
     "aba", "abx", "adca", "adcb", "adda", "addb", "addd", "aim",
     "anda", "andb", "asl", "asla", "aslb", "asld", "asr", "asra",
@@ -339,10 +341,45 @@ bool Disassembler::IsReturn(int opcode) {
     return opcode == rti || opcode == rts;
 }
 
-DasmResult Disassembler::disassemble(uint8_t* memory, int address) {
-    static char* instruction = (char*)malloc(8);
-    static char* operand = (char*)malloc(8);
+namespace {
+
+// the two hex digits of every byte, so formatting an operand is a few loads and stores; built
+// at compile time, so there is no static initializer to run before another one may use it
+struct HexTable {
+    char digits[256][2];
+
+    constexpr HexTable()
+        : digits {} {
+        const char* hex = "0123456789ABCDEF";
+        for (int i = 0; i < 256; i++) {
+            digits[i][0] = hex[i >> 4];
+            digits[i][1] = hex[i & 15];
+        }
+    }
+};
+
+constexpr HexTable hex_table;
+
+inline char* put_hex8(char* out, int value) {
+    out[0] = hex_table.digits[value & 0xff][0];
+    out[1] = hex_table.digits[value & 0xff][1];
+    return out + 2;
+}
+
+inline char* put_hex16(char* out, int value) {
+    return put_hex8(put_hex8(out, value >> 8), value);
+}
+
+inline char* put_text(char* out, const char* text) {
+    while (*text != 0) {
+        *out++ = *text++;
+    }
+    return out;
+}
+
+}
 
+int Disassembler::disassemble(const uint8_t* memory, int address, DasmLine& line) {
     int flags = 0;
     int invalid_mask;
     int code = memory[0] & 0xff;
@@ -359,75 +396,105 @@ DasmResult Disassembler::disassemble(uint8_t* memory, int address) {
     else if (IsReturn(opcode))
         flags = DASMFLAG_STEP_OUT;
 
-    bool is_illegal = false;
-    // char *operand = nullptr;
-    // char *instruction = nullptr;
-    int byteLength = 0;
+    line.address = address;
+    line.flags = flags | DASMFLAG_SUPPORTED;
 
     if ((invalid & invalid_mask) == invalid_mask) /* invalid for this cpu type ? */
     {
-        return DasmResult { true, nullptr, nullptr, flags | DASMFLAG_SUPPORTED, 1 };
+        line.is_illegal = true;
+        line.length = 1;
+        line.instruction[0] = 0;
+        line.operand[0] = 0;
+        return 1;
     }
+    line.is_illegal = false;
 
-    sprintf(instruction, "%-4s", op_name_str[opcode]);
+    // the names are at least three characters and zero filled, so "%-4s" is one space at most
+    memcpy(line.instruction, op_name_str[opcode], DasmLine::INSTRUCTION_SIZE);
+    if (line.instruction[3] == 0) {
+        line.instruction[3] = ' ';
+    }
 
-    // int byteLength = 0;
-    sprintf(operand, "");
+    char* operand = line.operand;
+    int byteLength;
 
     switch (args) {
     case rel: /* relative */
-        sprintf(operand, "$%04X", address + SIGNED(memory[1]) + 2);
+        *operand++ = '$';
+        operand = put_hex16(operand, address + SIGNED(memory[1]) + 2);
         byteLength = 2;
         break;
     case imb: /* immediate (byte) */
-        sprintf(operand, "#$%02X", memory[1]);
+        operand = put_hex8(put_text(operand, "#$"), memory[1]);
         byteLength = 2;
         break;
     case imw: /* immediate (word) */
-        sprintf(operand, "#$%04X", (memory[1] << 8) + memory[2]);
+        operand = put_hex16(put_text(operand, "#$"), (memory[1] << 8) + memory[2]);
         byteLength = 3;
         break;
     case idx: /* indexed + byte offset */
-        sprintf(operand, "$%02X,x", memory[1]);
+        *operand++ = '$';
+        operand = put_text(put_hex8(operand, memory[1]), ",x");
         byteLength = 2;
         break;
     case imx: /* immediate, indexed + byte offset */
-        sprintf(operand, "#$%02X,(x+$%02X)", memory[1], memory[2]);
+        operand = put_hex8(put_text(operand, "#$"), memory[1]);
+        operand = put_text(put_hex8(put_text(operand, ",(x+$"), memory[2]), ")");
         byteLength = 3;
         break;
     case dir: /* direct address */
-        sprintf(operand, "$%02X", memory[1]);
+        *operand++ = '$';
+        operand = put_hex8(operand, memory[1]);
         byteLength = 2;
         break;
     case imd: /* immediate, direct address */
-        sprintf(operand, "#$%02X,$%02X", memory[1], memory[2]);
+        operand = put_hex8(put_text(operand, "#$"), memory[1]);
+        operand = put_hex8(put_text(operand, ",$"), memory[2]);
         byteLength = 3;
         break;
     case ext: /* extended address */
-        sprintf(operand, "$%04X", (memory[1] << 8) + memory[2]);
+        *operand++ = '$';
+        operand = put_hex16(operand, (memory[1] << 8) + memory[2]);
         byteLength = 3;
         break;
     case sx1: /* byte from address (s + 1) */
-        sprintf(operand, "(s+1)");
+        operand = put_text(operand, "(s+1)");
         byteLength = 1;
         break;
     default:
         byteLength = 1;
         break;
     }
+    *operand = 0;
 
-    return DasmResult {
-        is_illegal,
-        operand,
-        instruction,
-        flags | DASMFLAG_SUPPORTED,
-        byteLength
-    };
-    // return new DasmResult(){
-    //     Instruction = instruction,
-    //     Operand = operand,
-    //     ByteLength = byteLength,
-    //     Flags = flags | DASMFLAG_SUPPORTED};
+    line.length = byteLength;
+    return byteLength;
+}
+
+size_t Disassembler::disassembleRange(const uint8_t* memory, int start, int end, std::vector<DasmLine>& out) {
+    size_t first = out.size();
+    if (end < start) {
+        return 0;
+    }
+    // every byte an instruction at most
+    out.reserve(first + (end - start + 1));
+
+    int address = start;
+    // the last two bytes may hold an instruction whose operands lie past end
+    int safe_end = end - 2;
+    while (address <= safe_end) {
+        out.emplace_back();
+        address += disassemble(&memory[address - start], address, out.back());
+    }
+    while (address <= end) {
+        uint8_t bytes[3] = { 0, 0, 0 };
+        for (int i = 0; i < 3 && address + i <= end; i++) {
+            bytes[i] = memory[address - start + i];
+        }
+        out.emplace_back();
+        address += disassemble(bytes, address, out.back());
+    }
+    return out.size() - first;
 }
 
 //     static int Disassemble(int[] memory, int pc, ref string buf)
@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <vector>
 
 struct Disassembly {
     char* operand;
@@ -11,12 +12,22 @@ struct Disassembly {
     uint8_t* bytes;
 };
 
-struct DasmResult {
+/*
+    One decoded instruction. The text is held in the line itself, so decoding neither
+    allocates nor shares a buffer between callers, and any number of threads can disassemble
+    at once. The mnemonic is padded to four characters; an illegal opcode leaves both strings
+    empty and is one byte long.
+*/
+struct DasmLine {
+    static const int INSTRUCTION_SIZE = 8;
+    static const int OPERAND_SIZE = 16; /* the longest operand is "#$12,(x+$34)" */
+
+    int address;
+    uint8_t length; /* in bytes */
+    uint8_t flags;
     bool is_illegal;
-    char* operand;
-    char* instruction;
-    int flags;
-    int byteLength;
+    char instruction[INSTRUCTION_SIZE];
+    char operand[OPERAND_SIZE];
 };
 
 class Disassembler {
@@ -196,7 +207,13 @@ class Disassembler {
     static bool IsReturn(int opcode);
 
 public:
-    static DasmResult disassemble(uint8_t* memory, int address);
+    // decodes the instruction whose bytes are at memory, which must hold three bytes,
+    // into line and returns its length
+    static int disassemble(const uint8_t* memory, int address, DasmLine& line);
+    // decodes every instruction from start up to end, memory being the bytes at start, and
+    // appends them to out; an instruction running past end reads the missing bytes as 0.
+    // Returns the number of lines added. Nothing is allocated once out has the capacity
+    static size_t disassembleRange(const uint8_t* memory, int start, int end, std::vector<DasmLine>& out);
     //     static int Disassemble(int[] memory, int pc, ref string buf);
     //     static void SelfTest();
 
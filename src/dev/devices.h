@@ -2,4 +2,5 @@
 #include "../dev/keypad_dev.h"
 #include "../dev/mc6820.h"
 #include "../dev/memory_dev.h"
-#include "../dev/memory_map.h"
\ No newline at end of file
+#include "../dev/memory_map.h"
+#include "../dev/rom_dev.h"
\ No newline at end of file
@@ -1,7 +1,11 @@
 #include "display_dev.h"
 
+#include <string.h>
+
 display_io::display_io() {
     next = nullptr;
+    memset(displaymem, 0, sizeof(displaymem));
+    sequence = 0;
 }
 
 uint8_t display_io::read(offs_t addr) {
@@ -9,9 +13,47 @@ uint8_t display_io::read(offs_t addr) {
 };
 
 void display_io::write(offs_t addr, uint8_t data) {
-    displaymem[addr - 0xC110] = data;
+    uint8_t* cell = &displaymem[addr - 0xC110];
+    if (*cell == data) {
+        return;
+    }
+    begin_change();
+    *cell = data;
+    end_change();
 };
 
+void display_io::load(const uint8_t* memory) {
+    if (memcmp(displaymem, memory, sizeof(displaymem)) == 0) {
+        return;
+    }
+    begin_change();
+    memcpy(displaymem, memory, sizeof(displaymem));
+    end_change();
+}
+
+void display_io::begin_change() {
+    // only the emulator thread changes the memory, so the counter needs no read-modify-write
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void display_io::end_change() {
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+unsigned display_io::snapshot(uint8_t* memory) {
+    while (true) {
+        unsigned before = sequence.load(std::memory_order_acquire);
+        if ((before & 1) == 0) {
+            memcpy(memory, displaymem, sizeof(displaymem));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                return before;
+            }
+        }
+    }
+}
+
 bool display_io::is_mapped(offs_t addr) {
     return addr >= 0xC110 && addr <= 0xC16F;
 }
@@ -27,3 +69,42 @@ offs_t display_io::get_start() {
 offs_t display_io::get_end() {
     return 0xC16F;
 }
+
+/*
+    Bit 0 of each of the eight bytes of a digit drives one segment:
+    0 = g (middle), 1 = f, 2 = e, 3 = d, 4 = c, 5 = b, 6 = a (top), 7 = decimal point.
+    The patterns below use the same bit order, abcdefg from bit 6 down.
+*/
+static char segment_char(uint8_t pattern) {
+    static const uint8_t patterns[] = {
+        0x00, 0x7E, 0x30, 0x6D, 0x79, 0x33, 0x5B, 0x5F, 0x70, 0x7F, 0x7B, 0x77, 0x1F, 0x4E, 0x3D,
+        0x4F, 0x47, 0x37, 0x67, 0x3E, 0x0E, 0x05, 0x1D, 0x15, 0x0F, 0x1C, 0x01
+    };
+    static const char chars[] = " 0123456789AbCdEFHPULrontu-";
+
+    for (size_t i = 0; i < sizeof(patterns); i++) {
+        if (patterns[i] == pattern) {
+            return chars[i];
+        }
+    }
+    return '?';
+}
+
+std::string display_io::get_text() {
+    std::string text;
+
+    // the leftmost digit is at 0xC160, the rightmost at 0xC110
+    for (int digit = 5; digit >= 0; digit--) {
+        uint8_t* segments = &displaymem[digit * 0x10];
+        uint8_t pattern = 0;
+        for (int segment = 0; segment < 7; segment++) {
+            pattern |= (segments[segment] & 1) << segment;
+        }
+        text += segment_char(pattern);
+        if (segments[7] & 1) {
+            text += '.';
+        }
+    }
+
+    return text;
+}
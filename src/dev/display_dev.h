@@ -2,7 +2,17 @@
 #define DISPLAY_DEV_H
 
 #include "memory_mapped_device.h"
+#include <atomic>
+#include <string>
 
+/*
+    The display latches are written by the emulator thread and drawn by the GUI thread, so
+    every change is bracketed by a sequence counter, like a seqlock: it is odd while the memory
+    is being changed and moves on by two with each change. The GUI polls get_generation() and
+    only copies the memory out with snapshot() when it moved, however many writes happened in
+    between. Writes that store the value already there don't count as a change, so a program
+    that keeps rewriting the same digits doesn't cause repaints.
+*/
 class display_io : public memory_mapped_device {
 public:
     display_io();
@@ -14,8 +24,29 @@ public:
     offs_t get_start() override;
     offs_t get_end() override;
 
+    // the six digits as text, left to right, with '.' after a digit whose decimal point is lit
+    // and '?' for segment patterns that aren't a letter or digit
+    std::string get_text();
+
+    // replaces the whole display memory, for loading a state
+    void load(const uint8_t* memory);
+
+    // can be called from any thread: changes whenever the display memory does
+    unsigned get_generation() {
+        return sequence.load(std::memory_order_acquire) & ~1u;
+    }
+    // can be called from any thread: copies out a consistent display memory and returns its
+    // generation
+    unsigned snapshot(uint8_t* memory);
+
+    static const int SIZE = 96;
+
 private:
-    uint8_t displaymem[96];
+    uint8_t displaymem[SIZE];
+    std::atomic<unsigned> sequence;
+
+    void begin_change();
+    void end_change();
 };
 
 #endif // DISPLAY_DEV_H
\ No newline at end of file
@@ -1,7 +1,11 @@
 #include "keypad_dev.h"
 
+#include <string.h>
+
 keypad_io::keypad_io() {
     next = NULL;
+    // $C004 isn't a key row, but it is inside the device and reads like an idle row
+    memset(memory, 0xFF, sizeof(memory));
 }
 
 void keypad_io::init() {
@@ -2,6 +2,7 @@
 
 MC6820::MC6820(RS232Adapter* rs232adapter) {
     _rs232adapter = rs232adapter;
+    next = NULL;
 }
 
 uint8_t MC6820::read(offs_t addr) {
@@ -28,6 +29,65 @@ offs_t MC6820::get_end() {
     return 0x1006;
 }
 
+void MC6820::save_state(MC6820State& state) {
+    state.cra = CRA;
+    state.crb = CRB;
+    state.ddra = DDRA;
+    state.ddrb = DDRB;
+    state.pra = PRA;
+    state.prb = PRB;
+    state.ca1 = CA1;
+    state.cb1 = CB1;
+    _rs232adapter->saveState(state.serial);
+}
+
+void MC6820::load_state(const MC6820State& state) {
+    CRA = state.cra;
+    CRB = state.crb;
+    DDRA = state.ddra;
+    DDRB = state.ddrb;
+    PRA = state.pra;
+    PRB = state.prb;
+    CA1 = state.ca1;
+    CB1 = state.cb1;
+    _rs232adapter->loadState(state.serial);
+
+    // the CPU's copy of the line was loaded from the same moment, but tell it anyway
+    irq = (CRA & 0x81) == 0x81 || (CRB & 0x81) == 0x81;
+    if (on_irq) {
+        on_irq(irq);
+    }
+}
+
+void MC6820::set_ca1(int state) {
+    state = state != 0;
+    // CRA bit 1 picks the rising edge, otherwise the falling one
+    if (state != CA1 && state == ((CRA >> 1) & 1)) {
+        CRA |= 0x80;
+        update_irq();
+    }
+    CA1 = state;
+}
+
+void MC6820::set_cb1(int state) {
+    state = state != 0;
+    if (state != CB1 && state == ((CRB >> 1) & 1)) {
+        CRB |= 0x80;
+        update_irq();
+    }
+    CB1 = state;
+}
+
+void MC6820::update_irq() {
+    bool asserted = (CRA & 0x81) == 0x81 || (CRB & 0x81) == 0x81;
+    if (asserted != irq) {
+        irq = asserted;
+        if (on_irq) {
+            on_irq(irq);
+        }
+    }
+}
+
 void MC6820::set(int registerSelect, uint8_t value) {
     switch (registerSelect) {
     // RS1 = 0, RS0 = 0
@@ -47,7 +107,9 @@ void MC6820::set(int registerSelect, uint8_t value) {
         break;
     // RS1 = 0, RS0 = 1
     case 1:
-        CRA = value;
+        // the interrupt flags are read only
+        CRA = (CRA & 0xC0) | (value & 0x3F);
+        update_irq();
         return;
     // RS1 = 1, RS0 = 0
     case 2:
@@ -66,7 +128,8 @@ void MC6820::set(int registerSelect, uint8_t value) {
         break;
     // RS1 = 1, RS0 = 1
     case 3:
-        CRB = value;
+        CRB = (CRB & 0xC0) | (value & 0x3F);
+        update_irq();
         return;
     }
     // throw new Exception("Invalid state");
@@ -81,6 +144,8 @@ uint8_t MC6820::get(int registerSelect) {
         case 4:
             // var eventArgs = new PeripheralEventArgs(Peripheral.PRA);
             // OnPeripheralRead.Invoke(this, eventArgs);
+            CRA &= 0x3F;
+            update_irq();
             return _rs232adapter->receive(); // eventArgs.Value;
         // CRA-B4 = 0
         case 0:
@@ -97,6 +162,8 @@ uint8_t MC6820::get(int registerSelect) {
         case 4:
             // var eventArgs = new PeripheralEventArgs(Peripheral.PRB);
             // OnPeripheralRead.Invoke(this, eventArgs);
+            CRB &= 0x3F;
+            update_irq();
             return _rs232adapter->receive(); // eventArgs.Value;
         // CRB-B4 = 0
         case 0:
@@ -5,6 +5,7 @@
 #include "memory_mapped_device.h"
 #include "rs232.h"
 #include <QDebug>
+#include <functional>
 
 // enum Peripheral
 // {
@@ -21,12 +22,29 @@ enum Register {
     CRB,
 };
 
+// the PIA registers and the state of the serial adapter on port A
+struct MC6820State {
+    uint8_t cra;
+    uint8_t crb;
+    uint8_t ddra;
+    uint8_t ddrb;
+    uint8_t pra;
+    uint8_t prb;
+    uint8_t ca1;
+    uint8_t cb1;
+    RS232State serial;
+};
+
 class MC6820 : public memory_mapped_device {
     /**
      * RS0/1 = Register Select 0/1
      * CRA/B = Control Register A/B
      * DDRA/B = Data Direction Register A/B
      * PRA/B = Peripheral Register A/B
+     *
+     * A transition on CA1 (CB1) in the direction chosen by CRA (CRB) bit 1 sets the IRQA1
+     * (IRQB1) flag in bit 7, which reading the peripheral register clears. With bit 0 set the
+     * flag also pulls the IRQ output low; IRQA and IRQB share the CPU's IRQ line.
      */
 
 private:
@@ -36,6 +54,9 @@ private:
     int DDRB = 0;
     int PRA = 0;
     int PRB = 0;
+    int CA1 = 0;
+    int CB1 = 0;
+    bool irq = false;
     // Register register = Register::DDRA;
 
 public:
@@ -48,9 +69,19 @@ public:
     offs_t get_start() override;
     offs_t get_end() override;
 
+    void save_state(MC6820State& state);
+    void load_state(const MC6820State& state);
+
+    // interrupt inputs, set by the emulation thread
+    void set_ca1(int state);
+    void set_cb1(int state);
+    // called with the IRQ output whenever it changes
+    std::function<void(bool asserted)> on_irq;
+
 private:
     RS232Adapter* _rs232adapter;
     void set(int registerSelect, uint8_t value);
+    void update_irq();
     uint8_t get(int registerSelect);
 };
 
@@ -40,6 +40,10 @@ offs_t memory_device::get_end() {
     return end;
 };
 
+bool memory_device::is_readonly() {
+    return readonly;
+};
+
 void memory_device::load(offs_t addr, uint8_t* data, int size) {
     memcpy(&memory[addr - start], data, size);
 }
@@ -13,6 +13,7 @@ public:
     uint8_t* get_mapped_memory() override;
     offs_t get_start() override;
     offs_t get_end() override;
+    bool is_readonly() override;
 
     void load(offs_t addr, uint8_t* data, int size);
 
@@ -1,9 +1,21 @@
 #include "memory_map.h"
+#include <string.h>
+
+static const uint8_t ALL_DIRTY = (1 << MemoryMapManager::TRACK_STATE) | (1 << MemoryMapManager::TRACK_REWIND) | (1 << MemoryMapManager::TRACK_DISASSEMBLY);
 
 MemoryMapManager::MemoryMapManager() {
     for (int i = 0; i < 64; i++) {
         blocks[i].device = NULL;
     }
+    for (int i = 0; i < PAGE_COUNT; i++) {
+        pages[i].read = nullptr;
+        pages[i].write = nullptr;
+        writable[i] = nullptr;
+        watch_count[i] = 0;
+        dirty[i] = ALL_DIRTY;
+    }
+    memset(watched, 0, sizeof(watched));
+    io_accesses = 0;
 }
 
 MemoryMapManager::~MemoryMapManager() {
@@ -24,22 +36,125 @@ void MemoryMapManager::map(memory_mapped_device* device) {
             current_device->next = device;
         }
     }
+
+    devices.push_back(device);
+    update_pages();
 }
 
-uint8_t MemoryMapManager::read(offs_t addr) {
+void MemoryMapManager::update_pages() {
+    for (int page = 0; page < PAGE_COUNT; page++) {
+        offs_t page_start = page << PAGE_SHIFT;
+        offs_t page_end = page_start + PAGE_MASK;
+        memory_mapped_device* owner = NULL;
+        int count = 0;
+
+        std::vector<memory_mapped_device*>::iterator it = devices.begin();
+        while (it != devices.end()) {
+            if ((*it)->get_start() <= page_end && (*it)->get_end() >= page_start) {
+                owner = *it;
+                count++;
+            }
+            it++;
+        }
+
+        pages[page].read = nullptr;
+        pages[page].write = nullptr;
+        writable[page] = nullptr;
+
+        // only pages fully backed by a single memory device get a direct pointer
+        if (count == 1 && owner->get_mapped_memory() != nullptr && owner->get_start() <= page_start && owner->get_end() >= page_end) {
+            uint8_t* memory = owner->get_mapped_memory() + (page_start - owner->get_start());
+            pages[page].read = memory;
+            if (!owner->is_readonly()) {
+                writable[page] = memory;
+                update_write_pointer(page);
+            }
+        }
+    }
+}
+
+void MemoryMapManager::update_write_pointer(int page) {
+    // writes to watched and clean pages have to go through write_device()
+    if (watch_count[page] == 0 && dirty[page] == ALL_DIRTY) {
+        pages[page].write = writable[page];
+    } else {
+        pages[page].write = nullptr;
+    }
+}
+
+uint8_t MemoryMapManager::read_device(offs_t addr) {
     memory_mapped_device* device = get_block_device(addr);
     if (device == NULL)
         return 0;
+    if (device->get_mapped_memory() == nullptr) {
+        io_accesses++;
+    }
     return device->read(addr);
 };
 
-void MemoryMapManager::write(offs_t addr, uint8_t data) {
+void MemoryMapManager::write_device(offs_t addr, uint8_t data) {
+    int page = addr >> PAGE_SHIFT;
+    if (writable[page] != nullptr) {
+        // a watched or clean RAM page
+        writable[page][addr & PAGE_MASK] = data;
+        if (dirty[page] != ALL_DIRTY) {
+            dirty[page] = ALL_DIRTY;
+            update_write_pointer(page);
+        }
+        if (watched[addr >> 3] & (1 << (addr & 7))) {
+            on_watched_write(addr);
+        }
+        return;
+    }
+
     memory_mapped_device* device = get_block_device(addr);
     if (device != NULL) {
+        if (device->get_mapped_memory() == nullptr) {
+            io_accesses++;
+        }
         device->write(addr, data);
     }
 };
 
+void MemoryMapManager::watch(offs_t start, offs_t end) {
+    for (offs_t addr = start; addr <= end; addr++) {
+        int page = addr >> PAGE_SHIFT;
+        if (!(watched[addr >> 3] & (1 << (addr & 7)))) {
+            watched[addr >> 3] |= 1 << (addr & 7);
+            watch_count[page]++;
+            pages[page].write = nullptr;
+        }
+    }
+}
+
+void MemoryMapManager::unwatch_page(int page) {
+    memset(&watched[(page << PAGE_SHIFT) >> 3], 0, PAGE_SIZE / 8);
+    watch_count[page] = 0;
+    update_write_pointer(page);
+}
+
+void MemoryMapManager::notify_write(offs_t start, size_t size) {
+    for (offs_t addr = start; addr < start + size && addr <= 0xFFFF; addr++) {
+        int page = addr >> PAGE_SHIFT;
+        if (dirty[page] != ALL_DIRTY) {
+            dirty[page] = ALL_DIRTY;
+            update_write_pointer(page);
+        }
+        if (watched[addr >> 3] & (1 << (addr & 7))) {
+            on_watched_write(addr);
+        }
+    }
+}
+
+void MemoryMapManager::clear_dirty(DirtyTracker tracker) {
+    for (int page = 0; page < PAGE_COUNT; page++) {
+        if (writable[page] != nullptr) {
+            dirty[page] &= ~(1 << tracker);
+            pages[page].write = nullptr;
+        }
+    }
+}
+
 memory_mapped_device* MemoryMapManager::get_block_device(off_t address) {
     int block = address / BLOCK_SIZE;
     memory_mapped_device* device = blocks[block].device;
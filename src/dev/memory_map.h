@@ -2,22 +2,127 @@
 #define MEMORY_MAP_H
 
 #include "memory_mapped_device.h"
+#include <functional>
 #include <map>
+#include <vector>
+
+/*
+    Page table
+
+    On top of the 1KB device blocks, the address space is split into 256 pages of 256 bytes.
+    A page that is entirely backed by a single device with mapped memory (RAM or ROM) holds a
+    direct host pointer to that memory, so a CPU access is a single indexed load or store.
+
+    Pages that are shared between devices, or that contain I/O registers (keypad, display, PIA),
+    have no host pointer and fall back to the device read / write handlers.
+
+    Write watches
+
+    Addresses can be watched so that a write to them is reported through on_watched_write. A RAM
+    page with at least one watched address loses its direct write pointer, so only writes to
+    those pages pay for the check.
+
+    Dirty pages
+
+    Every RAM page starts out dirty. clear_dirty() marks them clean and takes away their direct
+    write pointer, so the first write to a clean page goes through write_device(), which marks
+    it dirty and hands the pointer back. Save states use this to restore only the pages written
+    since the state was taken, the rewind buffer to record only the pages written since the
+    last frame, and the debugger to disassemble again only the code that changed, each at the
+    cost of one slow write per page.
+
+    Each user has its own tracker bit, so clearing the pages for one doesn't hide writes from
+    the other. A page gets its write pointer back once it is dirty for every tracker.
+
+    I/O accesses
+
+    Reads and writes that reach a device with no mapped memory (the PIA) are counted, since
+    they can change the device or the outside world: reading the PIA takes a serial bit.
+    Accesses to the keypad and display only touch their memory, so they aren't counted.
+*/
+struct memory_page {
+    uint8_t* read;
+    uint8_t* write;
+};
 
 class MemoryMapManager {
 public:
+    static const int PAGE_SHIFT = 8;
+    static const int PAGE_SIZE = 1 << PAGE_SHIFT;
+    static const int PAGE_MASK = PAGE_SIZE - 1;
+    static const int PAGE_COUNT = 0x10000 >> PAGE_SHIFT;
+
     MemoryMapManager();
     ~MemoryMapManager();
 
     void map(memory_mapped_device* device);
     memory_mapped_device* get_block_device(off_t address);
 
-    uint8_t read(offs_t addr);
-    void write(offs_t addr, uint8_t data);
+    inline uint8_t read(offs_t addr) {
+        uint8_t* page = pages[addr >> PAGE_SHIFT].read;
+        if (page != nullptr) {
+            return page[addr & PAGE_MASK];
+        }
+        return read_device(addr);
+    }
+
+    inline void write(offs_t addr, uint8_t data) {
+        uint8_t* page = pages[addr >> PAGE_SHIFT].write;
+        if (page != nullptr) {
+            page[addr & PAGE_MASK] = data;
+            return;
+        }
+        write_device(addr, data);
+    }
+
+    // host pointer to the page containing addr, or nullptr if the page is handled by a device
+    inline uint8_t* get_page(offs_t addr) {
+        return pages[addr >> PAGE_SHIFT].read;
+    }
+
+    // true if the page containing addr is RAM that is accessed directly
+    inline bool is_writable(offs_t addr) {
+        return writable[addr >> PAGE_SHIFT] != nullptr;
+    }
+
+    void watch(offs_t start, offs_t end);
+    void unwatch_page(int page);
+    // report a change to memory that did not go through write(), such as loading a file into RAM
+    void notify_write(offs_t start, size_t size);
+
+    enum DirtyTracker {
+        TRACK_STATE, /* save states */
+        TRACK_REWIND, /* rewind buffer */
+        TRACK_DISASSEMBLY /* debugger disassembly */
+    };
+
+    void clear_dirty(DirtyTracker tracker);
+    // true if the RAM page has been written since the last clear_dirty() for the tracker
+    inline bool is_dirty(int page, DirtyTracker tracker) {
+        return (dirty[page] & (1 << tracker)) != 0;
+    }
+    std::function<void(offs_t)> on_watched_write;
+
+    // number of I/O accesses so far, wraps around
+    inline unsigned get_io_accesses() {
+        return io_accesses;
+    }
 
 private:
     const int BLOCK_SIZE = 1024;
     mapped_memory_block blocks[64];
+    memory_page pages[PAGE_COUNT];
+    uint8_t* writable[PAGE_COUNT];
+    int watch_count[PAGE_COUNT];
+    uint8_t watched[0x10000 / 8];
+    uint8_t dirty[PAGE_COUNT]; /* one bit per DirtyTracker */
+    unsigned io_accesses;
+    std::vector<memory_mapped_device*> devices;
+
+    void update_pages();
+    void update_write_pointer(int page);
+    uint8_t read_device(offs_t addr);
+    void write_device(offs_t addr, uint8_t data);
 };
 
-#endif // MEMORY_MAP_H
\ No newline at end of file
+#endif // MEMORY_MAP_H
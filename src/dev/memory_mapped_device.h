@@ -23,6 +23,8 @@
 */
 class memory_mapped_device {
 public:
+    virtual ~memory_mapped_device() {
+    }
     virtual uint8_t read(offs_t addr) {
         return 0;
     }
@@ -40,6 +42,9 @@ public:
     virtual offs_t get_end() {
         return 0;
     }
+    virtual bool is_readonly() {
+        return false;
+    }
 
     memory_mapped_device* next;
 };
@@ -0,0 +1,163 @@
+#include "rom_dev.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif // _WIN32
+
+std::mutex rom_registry::lock;
+std::map<std::string, std::weak_ptr<const rom_image>> rom_registry::images;
+
+rom_image::rom_image(const std::string& key, size_t size) {
+    this->key = key;
+    this->size = size;
+    hash = 0;
+#ifdef _WIN32
+    allocated = size;
+    data = (uint8_t*)malloc(size);
+#else
+    size_t page = sysconf(_SC_PAGESIZE);
+    allocated = (size + page - 1) / page * page;
+    void* memory = mmap(nullptr, allocated, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    data = memory == MAP_FAILED ? nullptr : (uint8_t*)memory;
+#endif // _WIN32
+    if (data != nullptr) {
+        memset(data, 0xFF, size);
+    }
+}
+
+rom_image::~rom_image() {
+#ifdef _WIN32
+    free(data);
+#else
+    if (data != nullptr) {
+        munmap(data, allocated);
+    }
+#endif // _WIN32
+}
+
+const std::string& rom_image::get_key() const {
+    return key;
+}
+
+const uint8_t* rom_image::get_data() const {
+    return data;
+}
+
+size_t rom_image::get_size() const {
+    return size;
+}
+
+uint64_t rom_image::get_hash() const {
+    return hash;
+}
+
+void rom_image::seal() {
+    hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 0x100000001b3ULL;
+    }
+#ifndef _WIN32
+    mprotect(data, allocated, PROT_READ);
+#endif // _WIN32
+}
+
+std::shared_ptr<const rom_image> rom_registry::acquire(const std::string& key, size_t size, const loader& load) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    std::map<std::string, std::weak_ptr<const rom_image>>::iterator it = images.find(key);
+    if (it != images.end()) {
+        std::shared_ptr<const rom_image> image = (*it).second.lock();
+        if (image && image->get_size() == size) {
+            return image;
+        }
+    }
+
+    // loaded under the lock so two machines starting together don't both read the file
+    std::shared_ptr<rom_image> image = std::make_shared<rom_image>(key, size);
+    if (image->data == nullptr || load(image->data, size) == 0) {
+        return nullptr;
+    }
+    image->seal();
+
+    images[key] = image;
+    return image;
+}
+
+std::shared_ptr<const rom_image> rom_registry::acquire_file(const std::string& path, size_t size) {
+    return acquire(path, size, [&path](uint8_t* buffer, size_t size) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file == NULL) {
+            return (size_t)0;
+        }
+        size_t read = fread(buffer, 1, size, file);
+        fclose(file);
+        return read;
+    });
+}
+
+size_t rom_registry::get_count() {
+    std::lock_guard<std::mutex> guard(lock);
+    size_t count = 0;
+    std::map<std::string, std::weak_ptr<const rom_image>>::iterator it = images.begin();
+    while (it != images.end()) {
+        if (!(*it).second.expired()) {
+            count++;
+        }
+        it++;
+    }
+    return count;
+}
+
+size_t rom_registry::get_bytes() {
+    std::lock_guard<std::mutex> guard(lock);
+    size_t bytes = 0;
+    std::map<std::string, std::weak_ptr<const rom_image>>::iterator it = images.begin();
+    while (it != images.end()) {
+        std::shared_ptr<const rom_image> image = (*it).second.lock();
+        if (image) {
+            bytes += image->get_size();
+        }
+        it++;
+    }
+    return bytes;
+}
+
+rom_device::rom_device(offs_t start, std::shared_ptr<const rom_image> image) {
+    this->start = start;
+    this->image = image;
+    end = start + image->get_size() - 1;
+    next = NULL;
+}
+
+uint8_t rom_device::read(offs_t addr) {
+    return image->get_data()[addr - start];
+}
+
+bool rom_device::is_mapped(offs_t addr) {
+    return addr >= start && addr <= end;
+}
+
+uint8_t* rom_device::get_mapped_memory() {
+    // the page table only reads through this, is_readonly keeps writes off it
+    return (uint8_t*)image->get_data();
+}
+
+offs_t rom_device::get_start() {
+    return start;
+}
+
+offs_t rom_device::get_end() {
+    return end;
+}
+
+bool rom_device::is_readonly() {
+    return true;
+}
+
+std::shared_ptr<const rom_image> rom_device::get_image() {
+    return image;
+}
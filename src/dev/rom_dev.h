@@ -0,0 +1,89 @@
+#ifndef ROM_DEV_H
+#define ROM_DEV_H
+
+#include "memory_mapped_device.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/*
+    Shared ROM images
+
+    The monitor, Fantom II and Tiny BASIC images never change, so every emulator instance in the
+    process maps the same copy. rom_registry interns images by key (normally the file path):
+    the first instance to ask for a key loads it, later ones get the same image back, and the
+    image is freed when the last rom_device using it goes away.
+
+    The bytes live in their own pages which are made read-only once loaded, so a stray write
+    through a pointer faults instead of quietly changing the ROM of every machine. A machine
+    then costs its RAM, CPU and device registers, not another copy of 3KB of ROM.
+*/
+
+class rom_image {
+public:
+    rom_image(const std::string& key, size_t size);
+    ~rom_image();
+
+    const std::string& get_key() const;
+    const uint8_t* get_data() const;
+    size_t get_size() const;
+    // FNV-1a of the bytes, so save states can check they're restored over the same ROMs
+    uint64_t get_hash() const;
+
+private:
+    friend class rom_registry;
+
+    std::string key;
+    size_t size;
+    size_t allocated; /* size rounded up to whole host pages */
+    uint8_t* data;
+    uint64_t hash;
+
+    void seal();
+};
+
+class rom_registry {
+public:
+    // fills buffer (size bytes, preset to 0xFF) and returns the number of bytes read, 0 on failure
+    typedef std::function<size_t(uint8_t* buffer, size_t size)> loader;
+
+    // the image for key, loaded on first use; nullptr if the loader fails
+    static std::shared_ptr<const rom_image> acquire(const std::string& key, size_t size, const loader& load);
+    // reads the image from a file on first use
+    static std::shared_ptr<const rom_image> acquire_file(const std::string& path, size_t size);
+
+    // images currently alive and the bytes they hold
+    static size_t get_count();
+    static size_t get_bytes();
+
+private:
+    static std::mutex lock;
+    static std::map<std::string, std::weak_ptr<const rom_image>> images;
+};
+
+/*
+  A read-only device backed by a shared image. Reads go straight through the page table, writes
+  are ignored like on the real ROMs.
+*/
+class rom_device : public memory_mapped_device {
+public:
+    rom_device(offs_t start, std::shared_ptr<const rom_image> image);
+    uint8_t read(offs_t addr) override;
+    bool is_mapped(offs_t addr) override;
+    uint8_t* get_mapped_memory() override;
+    offs_t get_start() override;
+    offs_t get_end() override;
+    bool is_readonly() override;
+
+    std::shared_ptr<const rom_image> get_image();
+
+private:
+    offs_t start;
+    offs_t end;
+    std::shared_ptr<const rom_image> image;
+};
+
+#endif // ROM_DEV_H
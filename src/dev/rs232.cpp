@@ -5,6 +5,14 @@ void DebugConsoleAdapter::receiveByte(uint8_t value) {
     printf("%c", value);
 }
 
+RS232Adapter::RS232Adapter() {
+    inputBuffer = new std::queue<uint8_t>;
+}
+
+RS232Adapter::~RS232Adapter() {
+    delete inputBuffer;
+}
+
 void RS232Adapter::receiveByte(uint8_t value) {
     // foreach (var chr in value)
     // {
@@ -19,6 +27,10 @@ void RS232Adapter::receiveString(char* value) {
     // }
 };
 
+void RS232Adapter::queue(uint8_t data) {
+    inputBuffer->push(data);
+}
+
 uint8_t RS232Adapter::receive() {
     // The PIA is wired like so for Peripheral A
     // PA0 - Output bit (pulled high)
@@ -134,3 +146,34 @@ void RS232Adapter::send(uint8_t value) {
         sendState++;
     }
 }
+
+void RS232Adapter::saveState(RS232State& state) {
+    state.sendState = sendState;
+    state.sendBuffer = sendBuffer;
+    state.rcvState = rcvState;
+    state.rcvBuffer = rcvBuffer;
+    state.tempBuffer = tempBuffer;
+
+    // std::queue can't be walked, so go through a copy
+    std::queue<uint8_t> pending = *inputBuffer;
+    state.input.clear();
+    while (!pending.empty()) {
+        state.input.push_back(pending.front());
+        pending.pop();
+    }
+}
+
+void RS232Adapter::loadState(const RS232State& state) {
+    sendState = state.sendState;
+    sendBuffer = state.sendBuffer;
+    rcvState = state.rcvState;
+    rcvBuffer = state.rcvBuffer;
+    tempBuffer = state.tempBuffer;
+
+    *inputBuffer = std::queue<uint8_t>();
+    std::vector<uint8_t>::const_iterator it = state.input.begin();
+    while (it != state.input.end()) {
+        inputBuffer->push(*it);
+        it++;
+    }
+}
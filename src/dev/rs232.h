@@ -4,14 +4,29 @@
 #include "rs232.h"
 #include <QDebug>
 #include <queue>
+#include <vector>
+
+// the bit-banging state of both directions and the bytes waiting to be received
+struct RS232State {
+    int sendState;
+    int sendBuffer;
+    int rcvState;
+    uint8_t rcvBuffer;
+    uint8_t tempBuffer = 0;
+    std::vector<uint8_t> input;
+};
 
 class RS232Adapter {
 public:
+    RS232Adapter();
+    virtual ~RS232Adapter();
     virtual void receiveByte(uint8_t value);
     void receiveString(char* value);
     uint8_t receive();
     void send(uint8_t value);
     void queue(uint8_t data);
+    void saveState(RS232State& state);
+    void loadState(const RS232State& state);
 
 private:
     int sendState = 0;
@@ -19,7 +34,7 @@ private:
     int rcvState = 0;
     uint8_t rcvBuffer = 0x7F;
     std::queue<uint8_t>* inputBuffer;
-    uint8_t tempBuffer;
+    uint8_t tempBuffer = 0;
 };
 
 class DebugConsoleAdapter : public RS232Adapter {
@@ -0,0 +1,392 @@
+#include "emulator_farm.h"
+#include "../util/srec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string.h>
+#include <thread>
+
+// collects the bytes a program sends through the PIA serial port
+class FarmSerialAdapter : public RS232Adapter {
+public:
+    std::string text;
+
+    void receiveByte(uint8_t value) override {
+        text += (char)value;
+    }
+};
+
+// one ET-3400, wired up like et3400emu but without the worker thread
+struct FarmMachine {
+    MemoryMapManager memory_map;
+    memory_device ram { 0x0000, EmulatorFarm::RAM_SIZE, false };
+    keypad_io keypad;
+    display_io display;
+    FarmSerialAdapter serial;
+    MC6820 pia { &serial };
+    BreakpointBitmap stops;
+    std::vector<rom_device*> roms;
+    m6800_cpu_device* cpu;
+    bool stopped;
+
+    FarmMachine() {
+        memset(ram.get_mapped_memory(), 0, EmulatorFarm::RAM_SIZE);
+        memset(display.get_mapped_memory(), 0, 96);
+        memory_map.map(&ram);
+        memory_map.map(&keypad);
+        memory_map.map(&display);
+        memory_map.map(&pia);
+        keypad.init();
+
+        cpu = new m6800_cpu_device(&memory_map);
+        cpu->breakpoint_map = &stops;
+        cpu->check_breakpoint = [this](uint32_t) {
+            stopped = true;
+            return true;
+        };
+        keypad.on_reset_press = [this] { cpu->reset_line = 0; };
+        pia.on_irq = [this](bool asserted) { cpu->execute_set_input(M6800_IRQ_LINE, asserted ? ASSERT_LINE : CLEAR_LINE); };
+        stopped = false;
+    }
+
+    ~FarmMachine() {
+        delete cpu;
+        std::vector<rom_device*>::iterator it = roms.begin();
+        while (it != roms.end()) {
+            delete *it;
+            it++;
+        }
+    }
+
+    void add_rom(offs_t address, std::shared_ptr<const rom_image> image) {
+        rom_device* rom = new rom_device(address, image);
+        memory_map.map(rom);
+        roms.push_back(rom);
+    }
+
+    MachineParts get_parts() {
+        return MachineParts { cpu, &memory_map, &ram, &display, &keypad, &pia, &roms };
+    }
+};
+
+struct FarmKeyEvent {
+    unsigned long long cycle;
+    keypad_io::Keys key;
+    bool press;
+
+    bool operator<(const FarmKeyEvent& other) const {
+        return cycle < other.cycle;
+    }
+};
+
+// jobs waiting for one pool thread, the owner takes from the back and thieves from the front
+struct FarmQueue {
+    std::mutex lock;
+    std::deque<size_t> jobs;
+};
+
+EmulatorFarm::EmulatorFarm(int threads) {
+    if (threads <= 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    this->threads = threads > 0 ? threads : 1;
+    seconds = 0;
+    cycles = 0;
+}
+
+std::vector<FarmRom> EmulatorFarm::standard_roms(const std::string& directory) {
+    std::vector<FarmRom> roms;
+    roms.push_back(FarmRom { directory + "/monitor.bin", 0xFC00, 0x0400 });
+    roms.push_back(FarmRom { directory + "/fantomii.bin", 0x1400, 0x0800 });
+    roms.push_back(FarmRom { directory + "/tinybasic.bin", 0x1C00, 0x0800 });
+    return roms;
+}
+
+FarmJob EmulatorFarm::make_job(const std::string& name, unsigned long long cycle_budget) {
+    FarmJob job;
+    job.name = name;
+    job.start_pc = -1;
+    job.cycle_budget = cycle_budget;
+    job.stop_pc = -1;
+    job.save_state = false;
+    return job;
+}
+
+int EmulatorFarm::get_threads() {
+    return threads;
+}
+
+double EmulatorFarm::get_seconds() {
+    return seconds;
+}
+
+unsigned long long EmulatorFarm::get_cycles() {
+    return cycles;
+}
+
+std::vector<FarmResult> EmulatorFarm::run(const std::vector<FarmJob>& jobs) {
+    std::vector<FarmResult> results(jobs.size());
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // every ROM file is read once and its pages are mapped by all jobs, a missing one is
+    // kept as nullptr and fails the jobs that use it
+    rom_images.clear();
+    std::vector<FarmJob>::const_iterator job = jobs.begin();
+    while (job != jobs.end()) {
+        std::vector<FarmRom>::const_iterator rom = (*job).roms.begin();
+        while (rom != (*job).roms.end()) {
+            if (rom_images.find((*rom).path) == rom_images.end()) {
+                rom_images[(*rom).path] = rom_registry::acquire_file((*rom).path, (*rom).size);
+            }
+            rom++;
+        }
+        job++;
+    }
+
+    // hand out the jobs in contiguous runs, one queue per thread
+    int count = std::min(threads, std::max((int)jobs.size(), 1));
+    std::vector<FarmQueue> queues(count);
+    for (size_t i = 0; i < jobs.size(); i++) {
+        queues[i * count / jobs.size()].jobs.push_back(i);
+    }
+
+    std::vector<std::thread> pool;
+    for (int id = 0; id < count; id++) {
+        pool.push_back(std::thread([this, id, count, &queues, &jobs, &results] {
+            while (true) {
+                size_t index = 0;
+                bool found = false;
+
+                for (int k = 0; k < count && !found; k++) {
+                    FarmQueue& queue = queues[(id + k) % count];
+                    std::lock_guard<std::mutex> guard(queue.lock);
+                    if (!queue.jobs.empty()) {
+                        if (k == 0) {
+                            index = queue.jobs.back();
+                            queue.jobs.pop_back();
+                        } else {
+                            index = queue.jobs.front();
+                            queue.jobs.pop_front();
+                        }
+                        found = true;
+                    }
+                }
+
+                // no job is added once the pool has started, so empty queues mean done
+                if (!found) {
+                    return;
+                }
+                run_job(jobs[index], results[index]);
+            }
+        }));
+    }
+
+    std::vector<std::thread>::iterator it = pool.begin();
+    while (it != pool.end()) {
+        (*it).join();
+        it++;
+    }
+
+    rom_images.clear();
+
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cycles = 0;
+    std::vector<FarmResult>::iterator result = results.begin();
+    while (result != results.end()) {
+        cycles += (*result).cycles;
+        result++;
+    }
+
+    return results;
+}
+
+void EmulatorFarm::run_job(const FarmJob& job, FarmResult& result) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    result.name = job.name;
+    result.ok = true;
+    result.cycles = 0;
+    result.seconds = 0;
+    result.status = CpuStatus {};
+
+    FarmMachine machine;
+
+    std::vector<FarmRom>::const_iterator rom = job.roms.begin();
+    while (rom != job.roms.end()) {
+        std::map<std::string, std::shared_ptr<const rom_image>>::const_iterator image = rom_images.find((*rom).path);
+        if (image == rom_images.end() || !(*image).second) {
+            result.ok = false;
+            result.error = "can't read ROM " + (*rom).path;
+            return;
+        }
+        machine.add_rom((*rom).address, (*image).second);
+        rom++;
+    }
+
+    m6800_cpu_device* cpu = machine.cpu;
+    if (job.start_state) {
+        if (!job.start_state->fits(machine.get_parts())) {
+            result.ok = false;
+            result.error = "start state doesn't fit the job's ROMs";
+            return;
+        }
+        job.start_state->restore(machine.get_parts(), false);
+    } else {
+        cpu->device_start();
+        cpu->device_reset();
+    }
+
+    std::vector<std::string>::const_iterator path = job.srecords.begin();
+    while (path != job.srecords.end()) {
+        std::vector<srec_block> blocks;
+        bool loaded = SrecReader::Read(QString::fromStdString(*path), &blocks);
+
+        // a block that doesn't fit in RAM would leave the program incomplete, so it fails the
+        // job rather than being dropped
+        int outside = -1;
+        std::vector<srec_block>::iterator block = blocks.begin();
+        while (block != blocks.end()) {
+            // the byte count includes the two address bytes and the checksum
+            int size = (*block).bytecount - 3;
+            if ((*block).address + size <= RAM_SIZE) {
+                machine.ram.load((*block).address, (*block).data, size);
+            } else if (outside < 0) {
+                outside = (*block).address;
+            }
+            free((*block).data);
+            block++;
+        }
+
+        if (!loaded) {
+            result.ok = false;
+            result.error = "can't read " + *path;
+            return;
+        }
+        if (outside >= 0) {
+            char address[8];
+            snprintf(address, sizeof(address), "$%04X", outside);
+            result.ok = false;
+            result.error = *path + " has a block at " + address + " outside RAM";
+            return;
+        }
+        path++;
+    }
+
+    if (job.start_pc >= 0) {
+        cpu->m_pc.d = job.start_pc;
+    }
+    if (job.stop_pc >= 0) {
+        machine.stops.set(job.stop_pc);
+    }
+
+    std::vector<FarmKeyEvent> events;
+    std::vector<FarmKey>::const_iterator key = job.keys.begin();
+    while (key != job.keys.end()) {
+        events.push_back(FarmKeyEvent { (*key).cycle, (*key).key, true });
+        events.push_back(FarmKeyEvent { (*key).cycle + (*key).hold, (*key).key, false });
+        key++;
+    }
+    std::stable_sort(events.begin(), events.end());
+
+    unsigned long long now = 0;
+    size_t next_event = 0;
+    result.stop_reason = "budget";
+
+    while (now < job.cycle_budget) {
+        while (next_event < events.size() && events[next_event].cycle <= now) {
+            if (events[next_event].press) {
+                machine.keypad.press_key(events[next_event].key);
+            } else {
+                machine.keypad.release_key(events[next_event].key);
+            }
+            next_event++;
+        }
+
+        // slices end at the next key event, so key timing doesn't depend on the slice length
+        unsigned long long slice = std::min((unsigned long long)SLICE_CYCLES, job.cycle_budget - now);
+        if (next_event < events.size()) {
+            slice = std::min(slice, events[next_event].cycle - now);
+        }
+
+        cpu->m_icount = (int)slice;
+        cpu->pre_execute_run();
+        cpu->execute_run();
+        now += (long long)slice - cpu->m_icount;
+
+        if (machine.stopped) {
+            result.stop_reason = "pc";
+            break;
+        }
+        if (job.stop_condition && job.stop_condition(cpu->get_status(), machine.ram.get_mapped_memory())) {
+            result.stop_reason = "condition";
+            break;
+        }
+    }
+
+    result.cycles = now;
+    result.status = cpu->get_status();
+    result.ram.assign(machine.ram.get_mapped_memory(), machine.ram.get_mapped_memory() + RAM_SIZE);
+    result.display = machine.display.get_text();
+    result.serial = machine.serial.text;
+    if (job.save_state) {
+        result.state = std::make_shared<MachineState>();
+        result.state->capture(machine.get_parts(), now);
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void write_json_string(FILE* out, const std::string& text) {
+    fputc('"', out);
+    std::string::const_iterator it = text.begin();
+    while (it != text.end()) {
+        unsigned char c = *it;
+        if (c == '"' || c == '\\') {
+            fprintf(out, "\\%c", c);
+        } else if (c < 0x20 || c >= 0x7F) {
+            fprintf(out, "\\u%04x", c);
+        } else {
+            fputc(c, out);
+        }
+        it++;
+    }
+    fputc('"', out);
+}
+
+void EmulatorFarm::write_report(FILE* out, const std::vector<FarmResult>& results) {
+    fprintf(out, "{\n  \"threads\": %d,\n  \"seconds\": %.6f,\n  \"cycles\": %llu,\n  \"emulated_mhz\": %.3f,\n  \"jobs\": [\n",
+        threads, seconds, cycles, seconds > 0 ? cycles / seconds / 1e6 : 0.0);
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const FarmResult& result = results[i];
+
+        fprintf(out, "    {\n      \"name\": ");
+        write_json_string(out, result.name);
+        fprintf(out, ",\n      \"ok\": %s,\n", result.ok ? "true" : "false");
+        if (!result.ok) {
+            fprintf(out, "      \"error\": ");
+            write_json_string(out, result.error);
+            fprintf(out, "\n    }%s\n", i + 1 < results.size() ? "," : "");
+            continue;
+        }
+
+        fprintf(out, "      \"stop_reason\": \"%s\",\n", result.stop_reason.c_str());
+        fprintf(out, "      \"cycles\": %llu,\n      \"seconds\": %.6f,\n", result.cycles, result.seconds);
+        fprintf(out, "      \"registers\": { \"pc\": %u, \"sp\": %u, \"ix\": %u, \"a\": %u, \"b\": %u, \"cc\": %u },\n",
+            result.status.pc, result.status.sp, result.status.ix, result.status.acca, result.status.accb, result.status.cc);
+        fprintf(out, "      \"display\": ");
+        write_json_string(out, result.display);
+        fprintf(out, ",\n      \"serial\": ");
+        write_json_string(out, result.serial);
+        fprintf(out, ",\n      \"ram\": \"");
+        std::vector<uint8_t>::const_iterator byte = result.ram.begin();
+        while (byte != result.ram.end()) {
+            fprintf(out, "%02X", *byte);
+            byte++;
+        }
+        fprintf(out, "\"\n    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+
+    fprintf(out, "  ]\n}\n");
+}
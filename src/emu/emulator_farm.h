@@ -0,0 +1,105 @@
+#ifndef EMULATOR_FARM_H
+#define EMULATOR_FARM_H
+
+#include "../cpu/m6800.h"
+#include "../dev/devices.h"
+#include "machine_state.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/*
+    Headless batch runner
+
+    Runs many independent ET-3400 machines across a pool of threads, for regression runs and
+    grading of student programs. Each job builds its own machine (RAM, keypad, display, PIA
+    and the ROMs it lists), loads S-record files into RAM, plays a script of key presses and
+    runs until a cycle budget is used up, the CPU reaches a stop address, or a stop condition
+    returns true. The result holds the registers, RAM, the text on the display and anything
+    sent through the PIA serial port.
+
+    A job can start from a saved state instead of the reset vector, so many scenarios can be
+    forked from one machine that has already booted; S-records and start_pc are applied on top
+    of the state. A job that sets save_state returns the machine's final state in its result.
+
+    Machines are built on m6800_cpu_device directly rather than et3400emu, so a job doesn't
+    need a worker thread or a Qt event loop and runs start to finish on one pool thread. Each
+    pool thread owns a queue of jobs and steals from the other queues when its own runs out.
+*/
+
+struct FarmRom {
+    std::string path;
+    offs_t address;
+    size_t size;
+};
+
+struct FarmKey {
+    unsigned long long cycle; /* machine cycle count at which the key goes down */
+    keypad_io::Keys key;
+    unsigned long long hold; /* cycles the key is held */
+};
+
+struct FarmJob {
+    std::string name;
+    std::vector<FarmRom> roms;
+    std::vector<std::string> srecords;
+    std::shared_ptr<const MachineState> start_state; /* taken on a machine with the same ROMs */
+    int start_pc; /* -1 to start from the reset vector or the state's PC */
+    std::vector<FarmKey> keys;
+    unsigned long long cycle_budget;
+    int stop_pc; /* -1 for none */
+    // checked between time slices, with the machine's registers and RAM
+    std::function<bool(const CpuStatus& status, const uint8_t* ram)> stop_condition;
+    bool save_state;
+};
+
+struct FarmResult {
+    std::string name;
+    bool ok;
+    std::string error;
+    std::string stop_reason; /* "budget", "pc" or "condition" */
+    unsigned long long cycles;
+    double seconds;
+    CpuStatus status;
+    std::vector<uint8_t> ram;
+    std::string display;
+    std::string serial;
+    std::shared_ptr<MachineState> state; /* if the job asked for it */
+};
+
+class EmulatorFarm {
+public:
+    static const int RAM_SIZE = 0x0800;
+    static const int SLICE_CYCLES = 16667; /* cycles between checks of keys and stop condition */
+
+    // threads = 0 uses one thread per core
+    EmulatorFarm(int threads = 0);
+
+    // the ROM set of the ET-3400 trainer (monitor, Fantom II, Tiny BASIC) from a directory
+    static std::vector<FarmRom> standard_roms(const std::string& directory);
+    static FarmJob make_job(const std::string& name, unsigned long long cycle_budget);
+
+    // runs every job and returns the results in job order
+    std::vector<FarmResult> run(const std::vector<FarmJob>& jobs);
+    int get_threads();
+    // wall time and total emulated cycles of the last run
+    double get_seconds();
+    unsigned long long get_cycles();
+
+    // JSON report with one entry per job
+    void write_report(FILE* out, const std::vector<FarmResult>& results);
+
+private:
+    int threads;
+    double seconds;
+    unsigned long long cycles;
+    std::map<std::string, std::shared_ptr<const rom_image>> rom_images; /* held for the length of a run */
+
+    void run_job(const FarmJob& job, FarmResult& result);
+};
+
+#endif // EMULATOR_FARM_H
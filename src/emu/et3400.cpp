@@ -1,7 +1,12 @@
 #include "et3400.h"
 
+#include <algorithm>
+#include <limits.h>
+#include <string.h>
+
 et3400emu::et3400emu(keypad_io* keypad_dev, display_io* display_dev) {
     clock_rate = 100;
+    turbo = false;
 
     memory_map = new MemoryMapManager;
     breakpoints = new BreakpointManager;
@@ -9,14 +14,38 @@ et3400emu::et3400emu(keypad_io* keypad_dev, display_io* display_dev) {
 
     device = new m6800_cpu_device(memory_map);
     device->check_breakpoint = [this](uint32_t address) { return check_breakpoint(address); };
+    device->breakpoint_map = breakpoints->getBitmap();
+    if (getenv("ET3400_PERF_MAP") != nullptr) {
+        device->enable_jit_perf_map();
+    }
 
-    DebugConsoleAdapter* consoleAdapter = new DebugConsoleAdapter;
-    mc6820 = new MC6820(consoleAdapter);
+    serial = new DebugConsoleAdapter;
+    mc6820 = new MC6820(serial);
+    mc6820->on_irq = [this](bool asserted) { set_input_line(M6800_IRQ_LINE, asserted ? ASSERT_LINE : CLEAR_LINE); };
 
-    running = false;
+    state = Paused;
+    commands_sent = 0;
+    commands_done = 0;
     cycles = 0;
     last_pc = 0xFFFF;
     total_cycles = 0;
+    state_base = 0;
+    rewind_enabled = true;
+    rewind_budget = RewindBuffer::DEFAULT_BUDGET;
+    rewind_oldest = 0;
+    replay_next = 0;
+    replaying = false;
+    tracer = nullptr;
+    profiler = nullptr;
+    call_profiler = nullptr;
+    profiling = false;
+    idle_period = 0;
+    idle_probe_wait = 0;
+    idle_probe_backoff = 0;
+    idle_io = 0;
+    idle_skip = true;
+    idle = false;
+    idle_cycles = 0;
 
     // ram = new memory_device(0x0000, 0x0400, false);
     ram = new memory_device(0x0000, 0x0800, false);
@@ -34,36 +63,58 @@ et3400emu::et3400emu(keypad_io* keypad_dev, display_io* display_dev) {
     memory_map->map(keypad);
     memory_map->map(display);
     memory_map->map(mc6820);
+
+    thread = std::thread(&et3400emu::worker, this);
 }
 
 et3400emu::~et3400emu() {
-    stop();
+    stop_trace();
+    send(CommandExit);
+    thread.join();
     delete ram;
+    std::vector<rom_device*>::iterator it = roms.begin();
+    while (it != roms.end()) {
+        delete *it;
+        it++;
+    }
     delete memory_map;
     delete breakpoints;
     delete device;
+    delete profiler;
+    delete call_profiler;
 }
 
 void et3400emu::loadROM(QString romPath, offs_t address, size_t size) {
-    QFile file(romPath);
-
-    char* buffer;
+    // every instance in the process maps the same copy of a ROM, the file is read once
+    std::shared_ptr<const rom_image> image = rom_registry::acquire(romPath.toStdString(), size, [&romPath](uint8_t* buffer, size_t size) {
+        QFile file(romPath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return (size_t)0;
+        }
+        qint64 read = file.read((char*)buffer, size);
+        return read > 0 ? (size_t)read : 0;
+    });
 
-    if (!file.open(QIODevice::ReadOnly)) {
+    if (!image) {
         throw -10010;
-    } else {
-        buffer = (char*)malloc(size);
-
-        file.read(buffer, size);
     }
 
-    memory_device* rom = new memory_device(address, size, true);
-    rom->load(address, (uint8_t*)buffer, size);
+    rom_device* rom = new rom_device(address, image);
     memory_map->map(rom);
+    roms.push_back(rom);
+}
+
+void et3400emu::set_input_line(int line, int state) {
+    device->execute_set_input(line, state);
+    // the flag is set before taking the lock, so a worker about to sleep sees it
+    std::lock_guard<std::mutex> guard(park_lock);
+    park_condition.notify_one();
 }
 
 void et3400emu::loadRAM(offs_t address, uint8_t* buffer, size_t size) {
     ram->load(address, buffer, size);
+    // bytes loaded behind the CPU's back may replace predecoded code
+    memory_map->notify_write(address, size);
 }
 
 void et3400emu::loadMap(QString mapPath) {
@@ -71,8 +122,309 @@ void et3400emu::loadMap(QString mapPath) {
     labels->loadLabels(mapPath, success);
 }
 
+void et3400emu::saveState(MachineState& state) {
+    send(CommandSaveState, 0, &state);
+}
+
+bool et3400emu::loadState(const MachineState& state) {
+    if (!state.fits(get_parts())) {
+        return false;
+    }
+    send(CommandLoadState, 0, (void*)&state);
+    return true;
+}
+
+bool et3400emu::saveState(QString path) {
+    MachineState state;
+    saveState(state);
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    std::vector<uint8_t> data = state.serialize();
+    return file.write((const char*)data.data(), data.size()) == (qint64)data.size();
+}
+
+bool et3400emu::loadState(QString path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray data = file.readAll();
+
+    MachineState state;
+    if (!state.deserialize((const uint8_t*)data.constData(), data.size())) {
+        return false;
+    }
+    return loadState(state);
+}
+
+void et3400emu::set_rewind(bool enabled) {
+    rewind_enabled = enabled;
+}
+
+bool et3400emu::get_rewind() {
+    return rewind_enabled;
+}
+
+void et3400emu::set_rewind_budget(size_t bytes) {
+    rewind_budget = bytes;
+}
+
+unsigned long long et3400emu::get_rewind_oldest() {
+    return rewind_oldest;
+}
+
+bool et3400emu::rewind_to(unsigned long long cycle) {
+    RewindRequest request = { cycle, false };
+    send(CommandRewind, 0, &request);
+    return request.done;
+}
+
+bool et3400emu::step_back() {
+    // total_cycles only changes on the worker, which is parked once the pause is done
+    halt();
+    if (total_cycles == 0) {
+        return false;
+    }
+    return rewind_to(total_cycles - 1);
+}
+
+void et3400emu::press_key(keypad_io::Keys key) {
+    if (key == keypad_io::KeyReset) {
+        send(CommandInput, InputEvent::Reset << 8);
+    } else {
+        send(CommandInput, InputEvent::KeyPress << 8 | key);
+    }
+}
+
+void et3400emu::release_key(keypad_io::Keys key) {
+    send(CommandInput, InputEvent::KeyRelease << 8 | key);
+}
+
+void et3400emu::send_serial(uint8_t value) {
+    send(CommandInput, InputEvent::Serial << 8 | value);
+}
+
+void et3400emu::start_recording() {
+    send(CommandRecord);
+}
+
+void et3400emu::get_recording(InputJournal& journal) {
+    send(CommandGetRecording, 0, &journal);
+}
+
+bool et3400emu::save_recording(QString path) {
+    InputJournal journal;
+    get_recording(journal);
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    std::vector<uint8_t> data = journal.serialize();
+    return file.write((const char*)data.data(), data.size()) == (qint64)data.size();
+}
+
+bool et3400emu::replay(const InputJournal& journal) {
+    if (!journal.has_start() || !journal.get_start().fits(get_parts())) {
+        return false;
+    }
+    send(CommandReplay, 0, (void*)&journal);
+    return true;
+}
+
+bool et3400emu::replay(QString path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray data = file.readAll();
+
+    InputJournal journal;
+    if (!journal.deserialize((const uint8_t*)data.constData(), data.size())) {
+        return false;
+    }
+    return replay(journal);
+}
+
+bool et3400emu::get_replaying() {
+    return replaying;
+}
+
+bool et3400emu::start_trace(QString path) {
+    stop_trace();
+
+    std::string name = path.toStdString();
+    TraceRequest request = { name.c_str(), false };
+    send(CommandTrace, 0, &request);
+    return request.done;
+}
+
+void et3400emu::stop_trace() {
+    if (tracer == nullptr) {
+        return;
+    }
+    send(CommandTrace, 0, nullptr);
+}
+
+bool et3400emu::get_tracing() {
+    return tracer != nullptr;
+}
+
+void et3400emu::set_profiling(bool enabled) {
+    send(CommandProfile, enabled ? ProfileStart : ProfileStop);
+}
+
+bool et3400emu::get_profiling() {
+    return profiling;
+}
+
+void et3400emu::clear_profile() {
+    send(CommandProfile, ProfileClear);
+}
+
+bool et3400emu::get_profile(m6800_profiler& profile) {
+    send(CommandProfile, ProfileCopy, &profile);
+    return profiler != nullptr;
+}
+
+bool et3400emu::save_profile(QString path) {
+    m6800_profiler* profile = new m6800_profiler;
+    if (!get_profile(*profile)) {
+        delete profile;
+        return false;
+    }
+
+    std::vector<uint16_t> addresses;
+    for (int address = 0; address < m6800_profiler::ADDRESSES; address++) {
+        if (profile->get_count(address) != 0) {
+            addresses.push_back(address);
+        }
+    }
+    std::stable_sort(addresses.begin(), addresses.end(),
+        [profile](uint16_t a, uint16_t b) { return profile->get_cycles(a) > profile->get_cycles(b); });
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        delete profile;
+        return false;
+    }
+
+    double total = profile->get_total_cycles();
+    QTextStream out(&file);
+    out << "Address,Count,Cycles,Percent\n";
+    std::vector<uint16_t>::iterator it = addresses.begin();
+    while (it != addresses.end()) {
+        out << QString("%1,%2,%3,%4\n")
+                   .arg(*it, 4, 16, QChar('0'))
+                   .arg(profile->get_count(*it))
+                   .arg(profile->get_cycles(*it))
+                   .arg(total > 0 ? profile->get_cycles(*it) * 100.0 / total : 0.0, 0, 'f', 3)
+                   .toUpper();
+        it++;
+    }
+
+    delete profile;
+    return out.status() == QTextStream::Ok;
+}
+
+bool et3400emu::get_call_profile(m6800_call_profiler& profile) {
+    send(CommandProfile, ProfileCopyCalls, &profile);
+    return call_profiler != nullptr;
+}
+
+QString et3400emu::function_name(uint32_t function) {
+    if (function == m6800_call_profiler::ROOT) {
+        return QString("(root)");
+    }
+
+    std::vector<Label>* list = labels->getLabels();
+    std::vector<Label>::iterator it = list->begin();
+    while (it != list->end()) {
+        if ((*it).type != LabelType::DATA && (*it).start <= function && function <= (*it).end) {
+            return (*it).comment;
+        }
+        it++;
+    }
+    return QString("$%1").arg(function, 4, 16, QChar('0')).toUpper();
+}
+
+bool et3400emu::save_function_profile(QString path) {
+    m6800_call_profiler profile;
+    if (!get_call_profile(profile)) {
+        return false;
+    }
+
+    std::vector<m6800_function_stats> stats = profile.summarize();
+    std::stable_sort(stats.begin(), stats.end(),
+        [](const m6800_function_stats& a, const m6800_function_stats& b) { return a.inclusive > b.inclusive; });
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    double total = profile.get_total_cycles();
+    QTextStream out(&file);
+    out << "Function,Address,Calls,Inclusive,Exclusive,Inclusive Percent\n";
+    std::vector<m6800_function_stats>::iterator it = stats.begin();
+    while (it != stats.end()) {
+        out << QString("\"%1\",%2,%3,%4,%5,%6\n")
+                   .arg(function_name((*it).function))
+                   .arg((*it).function == m6800_call_profiler::ROOT ? QString("") : QString("%1").arg((*it).function, 4, 16, QChar('0')).toUpper())
+                   .arg((*it).calls)
+                   .arg((*it).inclusive)
+                   .arg((*it).exclusive)
+                   .arg(total > 0 ? (*it).inclusive * 100.0 / total : 0.0, 0, 'f', 3);
+        it++;
+    }
+    return out.status() == QTextStream::Ok;
+}
+
+bool et3400emu::save_folded_stacks(QString path) {
+    m6800_call_profiler profile;
+    if (!get_call_profile(profile)) {
+        return false;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    // the format separates frames with ';' and the count with a space
+    std::vector<QString> names(m6800_call_profiler::ROOT + 1);
+    QTextStream out(&file);
+    profile.fold([this, &names, &out](const std::vector<uint32_t>& stack, unsigned long long cycles) {
+        QString line;
+        std::vector<uint32_t>::const_iterator it = stack.begin();
+        while (it != stack.end()) {
+            if (names[*it].isEmpty()) {
+                names[*it] = function_name(*it).replace(';', '_').replace(' ', '_');
+            }
+            if (it != stack.begin()) {
+                line += ';';
+            }
+            line += names[*it];
+            it++;
+        }
+        out << line << ' ' << cycles << '\n';
+    });
+    return out.status() == QTextStream::Ok;
+}
+
+void et3400emu::get_written_pages(std::vector<bool>& pages) {
+    send(CommandWrittenPages, 0, &pages);
+}
+
+MachineParts et3400emu::get_parts() {
+    return MachineParts { device, memory_map, ram, display, keypad, mc6820, &roms };
+}
+
 bool et3400emu::get_running() {
-    return running;
+    return state == Running;
 }
 
 CpuStatus et3400emu::get_status() {
@@ -80,32 +432,23 @@ CpuStatus et3400emu::get_status() {
 }
 
 void et3400emu::stop() {
-    if (running) {
-        running = false;
-        thread.join();
-    }
+    send(CommandPause);
 }
 
 void et3400emu::halt() {
-    running = false;
-    thread.join();
+    send(CommandPause);
 }
 
-void et3400emu::step() {
-    if (!running) {
-        if (device->reset_line == 0) {
-            device->pre_execute_run();
-        } else {
-            device->execute_step();
-        }
-    }
+void et3400emu::step(int count) {
+    send(CommandStep, count);
 }
 
 void et3400emu::resume() {
-    if (!running) {
-        running = true;
-        thread = std::thread(&et3400emu::worker, this);
-    }
+    send(CommandRun);
+}
+
+void et3400emu::run_to(offs_t address) {
+    send(CommandRunTo, address);
 }
 
 void et3400emu::init() {
@@ -116,15 +459,17 @@ void et3400emu::init() {
 
     device->device_start();
     device->device_reset();
+
+    // the journal covers the session from power on
+    start_recording();
 }
 
 void et3400emu::start() {
-    running = true;
-    thread = std::thread(&et3400emu::worker, this);
+    send(CommandRun);
 }
 
 void et3400emu::reset() {
-    device->reset_line = 0;
+    send(CommandReset);
 }
 
 int et3400emu::get_cycles() {
@@ -139,41 +484,693 @@ int et3400emu::get_clock_rate() {
     return clock_rate;
 }
 
+void et3400emu::set_turbo(bool enabled) {
+    turbo = enabled;
+}
+
+bool et3400emu::get_turbo() {
+    return turbo;
+}
+
+double et3400emu::get_emulated_mhz() {
+    TelemetrySnapshot snapshot;
+    telemetry.get(snapshot);
+    return snapshot.emulated_mhz;
+}
+
+void et3400emu::get_telemetry(TelemetrySnapshot& snapshot) {
+    telemetry.get(snapshot);
+    snapshot.idle_cycles = idle_cycles;
+    snapshot.delay_loop_hits = device->delay_loop_hits;
+    snapshot.delay_loop_cycles = device->delay_loop_cycles;
+    snapshot.drift_us = pacer.getDrift();
+    snapshot.jitter_us = pacer.getJitter();
+    snapshot.resyncs = pacer.getResyncs();
+}
+
+void et3400emu::reset_telemetry() {
+    telemetry.reset();
+}
+
+void et3400emu::count_repaint() {
+    telemetry.add_repaint();
+}
+
+double et3400emu::get_pacing_drift() {
+    return pacer.getDrift();
+}
+
+double et3400emu::get_pacing_jitter() {
+    return pacer.getJitter();
+}
+
+void et3400emu::set_idle_skip(bool enabled) {
+    idle_skip = enabled;
+}
+
+bool et3400emu::get_idle_skip() {
+    return idle_skip;
+}
+
+bool et3400emu::get_idle() {
+    return idle;
+}
+
+unsigned long long et3400emu::get_idle_cycles() {
+    return idle_cycles;
+}
+
+unsigned long long et3400emu::get_delay_loop_hits() {
+    return device->delay_loop_hits;
+}
+
+unsigned long long et3400emu::get_delay_loop_cycles() {
+    return device->delay_loop_cycles;
+}
+
+void et3400emu::send(CommandType type, uint32_t arg, void* data) {
+    Command command = { type, arg, data };
+
+    if (std::this_thread::get_id() == thread.get_id()) {
+        execute(command);
+        return;
+    }
+
+    while (!commands.push(command)) {
+        std::this_thread::yield();
+    }
+    unsigned sequence = ++commands_sent;
+
+    // get the worker out of the CPU loop, the frame wait or its parking spot
+    device->abort_run.fetch_or(m6800_cpu_device::ABORT_REQUEST);
+    pacer.interrupt();
+
+    std::unique_lock<std::mutex> guard(park_lock);
+    park_condition.notify_one();
+    done_condition.wait(guard, [this, sequence] { return commands_done >= sequence; });
+}
+
+void et3400emu::execute(const Command& command) {
+    switch (command.type) {
+    case CommandRun:
+        state = Running;
+        break;
+    case CommandPause:
+        breakpoints->clearTemporaryBreakpoint();
+        state = Paused;
+        break;
+    case CommandStep:
+        if (state != Paused) {
+            break;
+        }
+        last_pc = 0xFFFF;
+        for (uint32_t i = 0; i < command.arg; i++) {
+            apply_replay_input();
+            step_instruction();
+        }
+        break;
+    case CommandRunTo:
+        breakpoints->setTemporaryBreakpoint(command.arg);
+        state = Running;
+        break;
+    case CommandReset:
+    case CommandInput: {
+        if (replaying) {
+            break;
+        }
+        InputEvent event = { total_cycles, InputEvent::Reset, 0 };
+        if (command.type == CommandInput) {
+            event.type = command.arg >> 8;
+            event.value = command.arg & 0xFF;
+        }
+        journal.add(event.cycle, (InputEvent::Type)event.type, event.value);
+        apply_input(event);
+        break;
+    }
+    case CommandSaveState: {
+        MachineState* saved = (MachineState*)command.data;
+        saved->capture(get_parts(), total_cycles);
+        state_base = saved->get_id();
+        break;
+    }
+    case CommandLoadState: {
+        replaying = false;
+        load_machine_state(*(const MachineState*)command.data);
+        render_frame();
+        break;
+    }
+    case CommandRewind: {
+        RewindRequest* request = (RewindRequest*)command.data;
+        breakpoints->clearTemporaryBreakpoint();
+        state = Paused;
+        request->done = rewind_to_cycle(request->cycle);
+        if (journal.has_start() && journal.get_start().get_total_cycles() > total_cycles) {
+            // the recording started in the part of the timeline that was just dropped
+            MachineState now;
+            now.capture(get_parts(), total_cycles);
+            state_base = now.get_id();
+            journal.start(now);
+        }
+        last_pc = 0xFFFF;
+        render_frame();
+        break;
+    }
+    case CommandRecord: {
+        MachineState now;
+        now.capture(get_parts(), total_cycles);
+        state_base = now.get_id();
+        journal.start(now);
+        break;
+    }
+    case CommandGetRecording: {
+        InputJournal* recording = (InputJournal*)command.data;
+        *recording = journal;
+        recording->set_end_cycle(total_cycles);
+        break;
+    }
+    case CommandReplay: {
+        const InputJournal* recording = (const InputJournal*)command.data;
+        load_machine_state(recording->get_start());
+        replay_journal = *recording;
+        replay_next = 0;
+        replaying = true;
+        breakpoints->clearTemporaryBreakpoint();
+        state = Running;
+        break;
+    }
+    case CommandTrace: {
+        TraceRequest* request = (TraceRequest*)command.data;
+        if (request == nullptr) {
+            // the CPU only looks at the trace inside execute_run, which isn't running now
+            device->trace = nullptr;
+            delete tracer;
+            tracer = nullptr;
+            break;
+        }
+        tracer = new m6800_trace;
+        request->done = tracer->open(request->path, total_cycles);
+        if (!request->done) {
+            delete tracer;
+            tracer = nullptr;
+        }
+        device->trace = tracer;
+        break;
+    }
+    case CommandProfile:
+        // like the trace, the CPU only looks at the profile inside execute_run
+        switch (command.arg) {
+        case ProfileStart:
+            if (profiler == nullptr) {
+                profiler = new m6800_profiler;
+                call_profiler = new m6800_call_profiler;
+            }
+            device->profile = profiler;
+            device->calls = call_profiler;
+            profiling = true;
+            break;
+        case ProfileStop:
+            device->profile = nullptr;
+            device->calls = nullptr;
+            profiling = false;
+            break;
+        case ProfileClear:
+            if (profiler != nullptr) {
+                profiler->clear();
+                call_profiler->clear();
+            }
+            break;
+        case ProfileCopy:
+            if (profiler != nullptr) {
+                *(m6800_profiler*)command.data = *profiler;
+            }
+            break;
+        case ProfileCopyCalls:
+            if (call_profiler != nullptr) {
+                *(m6800_call_profiler*)command.data = *call_profiler;
+            }
+            break;
+        }
+        break;
+    case CommandWrittenPages: {
+        std::vector<bool>* pages = (std::vector<bool>*)command.data;
+        pages->assign(MemoryMapManager::PAGE_COUNT, false);
+        for (int page = 0; page < MemoryMapManager::PAGE_COUNT; page++) {
+            (*pages)[page] = memory_map->is_writable(page << MemoryMapManager::PAGE_SHIFT) && memory_map->is_dirty(page, MemoryMapManager::TRACK_DISASSEMBLY);
+        }
+        memory_map->clear_dirty(MemoryMapManager::TRACK_DISASSEMBLY);
+        break;
+    }
+    case CommandExit:
+        state = Exiting;
+        break;
+    }
+}
+
 void et3400emu::worker() {
-    const int sleep_ns = 13667;
-    const int base_cycles = 16667;
-    const float hundred_percent = 100;
-    int ctr = 60;
-
-    while (this->running) {
-        int cycles_per_frame = (int)(base_cycles * (float)clock_rate / hundred_percent);
-        device->m_icount = cycles_per_frame;
+    typedef std::chrono::steady_clock clock;
+    const long hz_per_percent = 10000; /* clock_rate 100 is 1 MHz */
+    const clock::duration render_interval = std::chrono::microseconds(1000000 / TURBO_RENDER_HZ);
+
+    clock::time_point last_render;
+    bool was_running = false;
+    bool was_turbo = false;
+    int carry = 0; /* cycles owed to the next frame: left over when a command cut the last one short, or minus those its last instruction ran past the end */
+    bool new_frame = true; /* the last wait reached its deadline, so the next frame's cycles are due */
+    bool was_idle = false;
+    clock::time_point idle_start;
+    unsigned long long idle_start_cycles = 0;
+    long idle_hz = 0; /* clock the idle time is counted at, 0 in turbo mode */
+
+    while (true) {
+        // cleared before looking at the queue, so a command sent after this ends the next frame;
+        // an input line changed from another thread may end the idle loop
+        if (device->abort_run.exchange(0) & m6800_cpu_device::ABORT_INPUT) {
+            idle_period = 0;
+        }
+
+        Command command;
+        while (commands.pop(command)) {
+            execute(command);
+            // input, a state load, a step... anything a command does can end the idle loop
+            idle_period = 0;
+            idle_probe_wait = 0;
+            idle_probe_backoff = 0;
+            std::lock_guard<std::mutex> guard(park_lock);
+            commands_done++;
+            done_condition.notify_all();
+        }
+
+        if (state == Exiting) {
+            break;
+        }
+
+        if (state == Paused) {
+            if (was_running) {
+                // the last partial frame may have changed the display
+                render_frame();
+                telemetry.pause();
+                idle = false;
+                was_running = false;
+            }
+            std::unique_lock<std::mutex> guard(park_lock);
+            park_condition.wait(guard, [this] { return !commands.empty(); });
+            continue;
+        }
+
+        if (!was_running) {
+            pacer.start();
+            last_render = clock::now();
+            carry = 0;
+            new_frame = true;
+            was_idle = false;
+            was_running = true;
+        }
+
+        if (replaying) {
+            apply_replay_input();
+            if (total_cycles >= replay_journal.get_end_cycle()) {
+                replaying = false;
+                state = Paused;
+                continue;
+            }
+        }
+
+        bool turbo_frame = turbo || replaying;
+        long hz = hz_per_percent * clock_rate;
+
+        if (idle_period != 0 && !replaying) {
+            // nothing changes until a command arrives, so sleep until then and catch up after
+            if (!was_idle || idle_hz != (turbo_frame ? 0 : hz)) {
+                idle_start = clock::now();
+                idle_start_cycles = total_cycles;
+                idle_hz = turbo_frame ? 0 : hz;
+                was_idle = true;
+            }
+            {
+                std::unique_lock<std::mutex> guard(park_lock);
+                park_condition.wait_for(guard, std::chrono::milliseconds((int)IDLE_WAKE_MS), [this] { return !commands.empty() || (device->abort_run & m6800_cpu_device::ABORT_INPUT); });
+            }
+            unsigned long long skipped = 0;
+            if (idle_hz != 0) {
+                int64_t slept = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - idle_start).count();
+                unsigned long long due = idle_start_cycles + (unsigned long long)(slept * (double)idle_hz / 1e9);
+                if (due > total_cycles) {
+                    skipped = skip_idle(due - total_cycles);
+                }
+            }
+            // in turbo mode too, where the clock stands still, so the telemetry window still closes
+            telemetry.add_idle(skipped);
+        } else {
+            if (was_idle) {
+                // the schedule was left behind while sleeping
+                pacer.start();
+                carry = 0;
+                new_frame = true;
+                was_idle = false;
+            }
+
+            int cycles_per_frame = 0;
+            if (turbo_frame) {
+                cycles_per_frame = TURBO_BATCH_CYCLES;
+            } else {
+                if (was_turbo) {
+                    pacer.start();
+                    new_frame = true;
+                }
+                // after a command cut the wait short, only what is left of the frame is run
+                if (new_frame) {
+                    cycles_per_frame = pacer.nextFrameCycles(hz);
+                    new_frame = false;
+                }
+            }
+            was_turbo = turbo_frame;
+
+            int64_t slice_start = FramePacer::now();
+            unsigned long long slice_cycles = total_cycles;
+            unsigned long long slice_instructions = device->instructions_retired;
+            int frame_cycles = cycles_per_frame + carry;
+            if (replaying) {
+                // the frame ends where the next event was applied live, which is always between
+                // two instructions, so the CPU stops exactly there
+                unsigned long long next = replay_journal.get_end_cycle();
+                if (replay_next < replay_journal.get_events().size()) {
+                    next = std::min(next, replay_journal.get_events()[replay_next].cycle);
+                }
+                if (next - total_cycles < (unsigned long long)frame_cycles) {
+                    frame_cycles = (int)(next - total_cycles);
+                }
+            }
+
+            if (idle_period == 0 && frame_cycles > 0 && can_skip_idle()) {
+                if (idle_probe_wait > 0) {
+                    idle_probe_wait--;
+                } else {
+                    // the instructions stepped through are part of the frame
+                    unsigned long long probe_start = total_cycles;
+                    idle_period = find_idle_period(frame_cycles);
+                    frame_cycles -= (int)(total_cycles - probe_start);
+                    // a program that just got input often goes back to waiting soon, one that
+                    // keeps busy is looked at less and less often
+                    idle_probe_wait = idle_probe_backoff;
+                    idle_probe_backoff = std::min(idle_probe_backoff * 2 + 1, (int)IDLE_PROBE_FRAMES);
+                }
+            }
+            if (idle_period != 0 && frame_cycles > 0) {
+                // whole turns of the loop are skipped, the rest runs so the frame ends on time
+                frame_cycles -= (int)skip_idle(frame_cycles);
+            }
+
+            if (frame_cycles > 0) {
+                device->m_icount = frame_cycles;
+                device->pre_execute_run();
+                device->execute_run();
+                total_cycles += frame_cycles - device->m_icount;
+                frame_cycles = device->m_icount;
+            }
+            // a command ends the frame early, the cycles it didn't get to run are run once the
+            // command is done
+            carry = frame_cycles;
+
+            if (idle_period != 0) {
+                // the next skip starts from here
+                if (memory_map->get_io_accesses() == idle_io) {
+                    save_idle_state();
+                } else {
+                    idle_period = 0;
+                }
+            }
+            telemetry.add_slice(device->instructions_retired - slice_instructions, total_cycles - slice_cycles, FramePacer::now() - slice_start);
+        }
+        idle = idle_period != 0;
+
+        if (rewind_enabled) {
+            if (rewind.get_budget() != rewind_budget) {
+                rewind.set_budget(rewind_budget);
+            }
+            rewind.record(get_parts(), total_cycles);
+            rewind_oldest = rewind.get_oldest_cycle();
+        } else if (!rewind.empty()) {
+            rewind.clear();
+            rewind_oldest = total_cycles.load();
+        }
+
+        if (!was_idle && !turbo_frame && state == Running) {
+            int64_t late = pacer.waitForFrame();
+            if (late >= 0) {
+                telemetry.add_wait(late);
+            }
+            new_frame = late >= 0;
+        }
+
+        // in turbo mode many frames pass between two screen refreshes, and an idle machine
+        // doesn't change the display
+        clock::time_point now = clock::now();
+        if (!was_idle && (!turbo_frame || now - last_render >= render_interval)) {
+            render_frame();
+            last_render = now;
+        }
+    }
+}
+
+void et3400emu::step_instruction() {
+    if (device->reset_line == 0) {
         device->pre_execute_run();
-        device->execute_run();
-        sleep(sleep_ns);
-        total_cycles += cycles_per_frame - device->m_icount;
-        render_frame();
+    } else {
+        device->m_icount = 0;
+        device->execute_step();
+        total_cycles -= device->m_icount;
+    }
+}
+
+bool et3400emu::rewind_to_cycle(unsigned long long cycle) {
+    if (cycle > total_cycles) {
+        return false;
+    }
+
+    unsigned long long restored;
+    if (!rewind.restore(get_parts(), cycle, restored)) {
+        return false;
+    }
+    total_cycles = restored;
+
+    int count = replay_from_frame(cycle, INT_MAX);
+    if (total_cycles > cycle) {
+        // the last instruction started before the target and ended after it, stop in front of it
+        rewind.restore(get_parts(), cycle, restored);
+        total_cycles = restored;
+        replay_from_frame(cycle, count - 1);
+    }
+
+    // input from here on belongs to the timeline that was dropped
+    journal.truncate(total_cycles);
+    return true;
+}
+
+int et3400emu::replay_from_frame(unsigned long long cycle, int max_instructions) {
+    const std::vector<InputEvent>& events = journal.get_events();
+    size_t next = journal.find(total_cycles);
+
+    int count = 0;
+    while (total_cycles < cycle && count < max_instructions) {
+        while (next < events.size() && events[next].cycle <= total_cycles) {
+            apply_input(events[next]);
+            next++;
+        }
+        if (device->m_wai_state & m6800_cpu_device::M6800_WAI) {
+            // only input wakes the CPU up, until then WAI just burns the cycles
+            unsigned long long wake = cycle;
+            if (next < events.size() && events[next].cycle < wake) {
+                wake = events[next].cycle;
+            }
+            total_cycles = wake;
+            continue;
+        }
+        step_instruction();
+        count++;
+    }
+    return count;
+}
+
+void et3400emu::load_machine_state(const MachineState& saved) {
+    // RAM still holds state_base apart from the pages written since, so only those differ
+    saved.restore(get_parts(), saved.get_id() == state_base);
+    state_base = saved.get_id();
+    total_cycles = saved.get_total_cycles();
+    last_pc = 0xFFFF;
+    // the recorded frames and input belong to another timeline
+    rewind.clear();
+    rewind_oldest = total_cycles.load();
+    journal.start(saved);
+}
+
+void et3400emu::apply_input(const InputEvent& event) {
+    switch (event.type) {
+    case InputEvent::KeyPress:
+        keypad->press_key((keypad_io::Keys)event.value);
+        break;
+    case InputEvent::KeyRelease:
+        keypad->release_key((keypad_io::Keys)event.value);
+        break;
+    case InputEvent::Reset:
+        last_pc = 0xFFFF;
+        device->reset_line = 0;
+        break;
+    case InputEvent::Serial:
+        serial->queue(event.value);
+        break;
+    }
+}
+
+void et3400emu::apply_replay_input() {
+    if (!replaying) {
+        return;
+    }
+    const std::vector<InputEvent>& events = replay_journal.get_events();
+    while (replay_next < events.size() && events[replay_next].cycle <= total_cycles) {
+        const InputEvent& event = events[replay_next];
+        journal.add(total_cycles, (InputEvent::Type)event.type, event.value);
+        apply_input(event);
+        replay_next++;
+        idle_probe_wait = 0;
+        idle_probe_backoff = 0;
+    }
+}
+
+bool et3400emu::can_skip_idle() {
+    // skipped instructions aren't traced or profiled, and a reset has to run first
+    return idle_skip && tracer == nullptr && !profiling && device->reset_line != 0;
+}
+
+int et3400emu::find_idle_period(int max_cycles) {
+    const BreakpointBitmap* bitmap = device->breakpoint_map;
+    idle_pcs.clear();
+
+    if (device->m_wai_state & m6800_cpu_device::M6800_WAI) {
+        // takes the interrupt if one is pending, otherwise WAI stays put however long it waits
+        step_instruction();
+        if (device->m_wai_state & m6800_cpu_device::M6800_WAI) {
+            save_idle_state();
+            return 1;
+        }
+    }
+
+    save_idle_state();
+    unsigned long long start = total_cycles;
+    for (int i = 0; i < IDLE_PROBE_INSTRUCTIONS && total_cycles - start < (unsigned long long)max_cycles; i++) {
+        uint16_t pc = device->get_status().pc;
+        if (bitmap->isArmed() && bitmap->test(pc)) {
+            // stepping doesn't stop for breakpoints, leave it to the frame
+            return 0;
+        }
+        idle_pcs.push_back(pc);
+        step_instruction();
+        if (memory_map->get_io_accesses() != idle_io || (device->m_wai_state & m6800_cpu_device::M6800_WAI)) {
+            return 0;
+        }
+        if (total_cycles > start && same_idle_state()) {
+            return (int)(total_cycles - start);
+        }
+    }
+    return 0;
+}
+
+void et3400emu::save_idle_state() {
+    memory_mapped_device* parts[] = { ram, display, keypad };
+
+    device->save_state(idle_cpu);
+    idle_memory.clear();
+    for (int i = 0; i < 3; i++) {
+        const uint8_t* memory = parts[i]->get_mapped_memory();
+        idle_memory.insert(idle_memory.end(), memory, memory + (parts[i]->get_end() - parts[i]->get_start() + 1));
+    }
+    idle_io = memory_map->get_io_accesses();
+}
+
+bool et3400emu::same_idle_state() {
+    memory_mapped_device* parts[] = { ram, display, keypad };
+
+    m6800_state now;
+    device->save_state(now);
+    // ppc and icount don't change what the CPU does next
+    if (now.pc != idle_cpu.pc || now.s != idle_cpu.s || now.x != idle_cpu.x || now.a != idle_cpu.a
+        || now.b != idle_cpu.b || now.cc != idle_cpu.cc || now.wai_state != idle_cpu.wai_state
+        || now.nmi_state != idle_cpu.nmi_state || now.nmi_pending != idle_cpu.nmi_pending
+        || memcmp(now.irq_state, idle_cpu.irq_state, sizeof(now.irq_state)) != 0
+        || now.reset_line != idle_cpu.reset_line) {
+        return false;
+    }
+    if (memory_map->get_io_accesses() != idle_io) {
+        return false;
+    }
+
+    size_t offset = 0;
+    for (int i = 0; i < 3; i++) {
+        size_t size = parts[i]->get_end() - parts[i]->get_start() + 1;
+        if (memcmp(parts[i]->get_mapped_memory(), &idle_memory[offset], size) != 0) {
+            return false;
+        }
+        offset += size;
     }
+    return true;
+}
+
+unsigned long long et3400emu::skip_idle(unsigned long long cycles) {
+    // breakpoints can be set at any time, and the UI can write to memory directly
+    bool stops = false;
+    const BreakpointBitmap* bitmap = device->breakpoint_map;
+    if (bitmap->isArmed()) {
+        std::vector<uint16_t>::iterator it = idle_pcs.begin();
+        while (it != idle_pcs.end() && !stops) {
+            stops = bitmap->test(*it);
+            it++;
+        }
+    }
+    if (stops || !can_skip_idle() || !same_idle_state()) {
+        idle_period = 0;
+        return 0;
+    }
+
+    unsigned long long skipped = cycles - cycles % idle_period;
+    total_cycles += skipped;
+    idle_cycles += skipped;
+    return skipped;
 }
 
 bool et3400emu::check_breakpoint(uint32_t address) {
-    if (breakpoints->hasBreakpoint(address) && last_pc != address) {
-        this->running = false;
-        on_breakpoint();
+    // the CPU only asks about marked addresses, so last_pc is cleared here rather than on every
+    // instruction: resuming skips the breakpoint it stopped on once
+    if (last_pc == address) {
+        last_pc = 0xFFFF;
+        return false;
+    }
+    bool temporary = breakpoints->isTemporaryBreakpoint(address);
+    if (temporary || breakpoints->hasBreakpoint(address)) {
+        if (temporary) {
+            breakpoints->clearTemporaryBreakpoint();
+        }
+        // runs on the worker, which parks once execute_run() returns
+        state = Paused;
+        if (on_breakpoint) {
+            on_breakpoint();
+        }
         last_pc = address;
         return true;
     }
-    last_pc = 0xFFFF;
     return false;
 }
 
 void et3400emu::handle_breakpoint() {
     stop();
-    on_breakpoint();
+    if (on_breakpoint) {
+        on_breakpoint();
+    }
 }
 
 void et3400emu::render_frame() {
-    on_render_frame();
+    // headless users don't set a callback
+    if (on_render_frame) {
+        on_render_frame();
+    }
 }
 
 memory_mapped_device* et3400emu::get_block_device(offs_t address) {
@@ -186,6 +1183,7 @@ void et3400emu::add_breakpoint(offs_t address) {
 
 void et3400emu::remove_breakpoint(offs_t address) {
     breakpoints->removeBreakpoint(address);
+    forget_stopped_breakpoint(address);
 }
 
 bool et3400emu::has_breakpoint(offs_t address) {
@@ -194,4 +1192,13 @@ bool et3400emu::has_breakpoint(offs_t address) {
 
 void et3400emu::add_or_remove_breakpoint(offs_t address) {
     breakpoints->addOrRemoveBreakpoint(address);
+    forget_stopped_breakpoint(address);
+}
+
+void et3400emu::forget_stopped_breakpoint(offs_t address) {
+    // once the breakpoint the CPU stopped on is removed, one set there later isn't skipped
+    uint32_t stopped = address;
+    if (!breakpoints->hasBreakpoint(address)) {
+        last_pc.compare_exchange_strong(stopped, 0xFFFF);
+    }
 }
\ No newline at end of file
@@ -2,20 +2,75 @@
 #define ET3400EMU_H
 
 #include "../cpu/m6800.h"
+#include "../cpu/call_profiler.h"
+#include "../cpu/profiler.h"
+#include "../cpu/trace.h"
 #include "../dev/devices.h"
 #include "../util/breakpoint_manager.h"
 #include "../util/disassembly_builder.h"
+#include "../util/frame_pacer.h"
 #include "../util/label_manager.h"
-#include "../util/sleep.h"
+#include "../util/spsc_queue.h"
+#include "input_journal.h"
+#include "machine_state.h"
+#include "rewind_buffer.h"
+#include "telemetry.h"
 
 #include <QFile>
 #include <QString>
+#include <QTextStream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <mutex>
+#include <thread>
+#include <vector>
 
+/*
+    The emulator runs on one worker thread that lives as long as the et3400emu object and
+    parks while the CPU is paused. The control functions (start, stop, halt, resume, step,
+    run_to, reset) queue a command for the worker and return once it has been carried out, so
+    the CPU state can be read straight afterwards. They are meant to be called from one thread,
+    the UI; called from the worker itself (a breakpoint callback) they run immediately.
+    A pause ends the CPU's time slice after the instruction in progress.
+
+    Key presses, resets and serial input go through the same queue. The worker applies them
+    between two instructions and logs them in an InputJournal, so a session can be saved and
+    replayed to the same end state.
+
+    Idle skipping
+
+    Waiting for a key, the Monitor spins in its keypad scan loop, and a program may sit in WAI.
+    Every so often the worker single steps the machine to look for such a loop: one that comes
+    back to the same CPU registers, RAM, display and keypad memory within IDLE_PROBE_INSTRUCTIONS
+    without touching the PIA. From then on nothing can change until input arrives, so the
+    machine is in the same state after any whole number of turns of the loop. The worker drops
+    those cycles instead of running them: in real time it sleeps until a command arrives, an
+    input line changes or IDLE_WAKE_MS pass and then moves total_cycles on by the time slept,
+    rounded down to whole turns; in turbo mode it sleeps without moving the clock; a replay
+    jumps straight to the next event. Since the dropped cycles are whole turns the machine ends
+    up where running them would have left it, so the journal and replays are unaffected.
+
+    Before skipping, the worker checks that the machine is still where it left it. Skipping
+    stays off while tracing or profiling, and the loop isn't skipped while a breakpoint is set
+    in it.
+*/
 class et3400emu {
 
 public:
+    enum State {
+        Paused,
+        Running,
+        Exiting
+    };
+
+    static const int TURBO_BATCH_CYCLES = 250000; /* cycles run between checks in turbo mode */
+    static const int TURBO_RENDER_HZ = 60; /* display refresh rate in turbo mode */
+    static const int IDLE_PROBE_INSTRUCTIONS = 1024; /* longest idle loop looked for */
+    static const int IDLE_PROBE_FRAMES = 30; /* most frames between two looks while not idle */
+    static const int IDLE_WAKE_MS = 250; /* longest sleep while idle */
+
     et3400emu(keypad_io* keypad, display_io* display);
     ~et3400emu();
 
@@ -25,13 +80,74 @@ public:
     void reset();
 
     void halt();
-    void step();
+    void step(int count = 1);
     void resume();
+    // runs until the CPU reaches the address or a breakpoint
+    void run_to(offs_t address);
+    // sets a CPU input line from any thread, waking the worker if it sleeps in an idle loop;
+    // the PIA's IRQ output goes through here too
+    void set_input_line(int line, int state);
 
     void loadROM(QString romPath, offs_t address, size_t size);
     // void loadROM(offs_t address, uint8_t *buffer, size_t size);
     void loadRAM(offs_t address, uint8_t* buffer, size_t size);
     void loadMap(QString mapPath);
+    // save states, taken and restored by the worker between two frames so the machine can
+    // keep running; loading returns false if the state is for other ROMs or another RAM size
+    void saveState(MachineState& state);
+    bool loadState(const MachineState& state);
+    bool saveState(QString path);
+    bool loadState(QString path);
+    // the rewind buffer records every frame while running, see RewindBuffer
+    void set_rewind(bool enabled);
+    bool get_rewind();
+    void set_rewind_budget(size_t bytes);
+    // oldest cycle the machine can go back to
+    unsigned long long get_rewind_oldest();
+    // pauses and goes back to the last instruction that started at or before the cycle,
+    // returns false if the cycle is older than the buffer or hasn't been reached yet
+    bool rewind_to(unsigned long long cycle);
+    // pauses and goes back to the start of the previous instruction
+    bool step_back();
+
+    // input is applied by the worker and journaled, see InputJournal
+    void press_key(keypad_io::Keys key);
+    void release_key(keypad_io::Keys key);
+    void send_serial(uint8_t value);
+    // the journal restarts from the current state, init() and loading a state restart it too
+    void start_recording();
+    void get_recording(InputJournal& journal);
+    bool save_recording(QString path);
+    // loads the journal's start state and plays it back in turbo mode, pausing at its end;
+    // input from the UI is ignored meanwhile
+    bool replay(const InputJournal& journal);
+    bool replay(QString path);
+    bool get_replaying();
+
+    // logs every instruction to a file until stopped, see m6800_trace; read it with trace_dump
+    bool start_trace(QString path);
+    void stop_trace();
+    bool get_tracing();
+    // counts instructions and cycles per address and per routine while on, see m6800_profiler
+    // and m6800_call_profiler; the counts are kept when profiling stops, until cleared
+    void set_profiling(bool enabled);
+    bool get_profiling();
+    void clear_profile();
+    // copies the counts so far, false if nothing was profiled yet
+    bool get_profile(m6800_profiler& profile);
+    // writes the addresses that ran as CSV, most cycles first
+    bool save_profile(QString path);
+    // copies the call tree so far, false if nothing was profiled yet
+    bool get_call_profile(m6800_call_profiler& profile);
+    // writes each routine's calls and inclusive and exclusive cycles as CSV, most inclusive
+    // cycles first; routines are named after the label at their entry address
+    bool save_function_profile(QString path);
+    // writes one line per call stack with the cycles spent on top of it, the folded format
+    // flame graph tools read
+    bool save_folded_stacks(QString path);
+    // sets pages[page] for each RAM page (see MemoryMapManager) written since the last call,
+    // including by loading a file or a state; the first call reports every RAM page
+    void get_written_pages(std::vector<bool>& pages);
     // uint8_t *get_memory();
     bool get_running();
     int get_cycles();
@@ -46,7 +162,32 @@ public:
 
     void set_clock_rate(int clock_rate);
     int get_clock_rate();
-    unsigned long long total_cycles;
+    // turbo mode runs the CPU as fast as the host allows, ignoring the clock rate
+    void set_turbo(bool enabled);
+    bool get_turbo();
+    // emulated clock speed measured over the last second while running
+    double get_emulated_mhz();
+    // can be called from any thread while the emulator runs, see Telemetry
+    void get_telemetry(TelemetrySnapshot& snapshot);
+    void reset_telemetry();
+    // called by the UI each time it repaints the display
+    void count_repaint();
+    // real time pacing error, see FramePacer
+    double get_pacing_drift();
+    double get_pacing_jitter();
+    // see Idle skipping above, on by default
+    void set_idle_skip(bool enabled);
+    bool get_idle_skip();
+    // true while the machine sits in an idle loop
+    bool get_idle();
+    // cycles skipped in idle loops since the emulator was created
+    unsigned long long get_idle_cycles();
+    // counted delay loops run at once since the emulator was created, and the cycles they
+    // took, see m6800_block_cache
+    unsigned long long get_delay_loop_hits();
+    unsigned long long get_delay_loop_cycles();
+    // only written by the worker, atomic so the UI can read it while running
+    std::atomic<unsigned long long> total_cycles;
     std::function<void()> on_render_frame;
     std::function<void()> on_breakpoint;
 
@@ -60,15 +201,116 @@ public:
 
 private:
     MC6820* mc6820;
+    RS232Adapter* serial;
+    std::vector<rom_device*> roms;
     m6800_cpu_device* device;
     std::thread thread;
     int cycles;
     int clock_rate;
-    bool running;
-    uint32_t last_pc;
+    std::atomic<bool> turbo;
+    Telemetry telemetry;
+    FramePacer pacer;
+    std::atomic<uint32_t> last_pc; /* breakpoint the CPU stopped on, skipped once when it resumes */
+
+    enum CommandType {
+        CommandRun,
+        CommandPause,
+        CommandStep,
+        CommandRunTo,
+        CommandReset,
+        CommandSaveState,
+        CommandLoadState,
+        CommandRewind,
+        CommandInput,
+        CommandRecord,
+        CommandGetRecording,
+        CommandReplay,
+        CommandTrace,
+        CommandProfile,
+        CommandWrittenPages,
+        CommandExit
+    };
+
+    struct Command {
+        CommandType type;
+        uint32_t arg;
+        void* data; /* owned by the sender, which waits for the command to finish */
+    };
+
+    std::atomic<int> state;
+    SpscQueue<Command, 16> commands;
+    unsigned commands_sent; /* only touched by the sending thread */
+    std::atomic<unsigned> commands_done;
+    std::mutex park_lock;
+    std::condition_variable park_condition; /* the worker waits here while paused or idle */
+    std::condition_variable done_condition; /* senders wait here for their command */
+
+    uint64_t state_base; /* id of the state RAM was last saved to or loaded from */
+
+    struct RewindRequest {
+        unsigned long long cycle;
+        bool done;
+    };
+
+    RewindBuffer rewind; /* only touched by the worker */
+    std::atomic<bool> rewind_enabled;
+    std::atomic<size_t> rewind_budget;
+    std::atomic<unsigned long long> rewind_oldest;
+
+    InputJournal journal; /* only touched by the worker */
+    InputJournal replay_journal;
+    size_t replay_next; /* next event of replay_journal */
+    std::atomic<bool> replaying;
+
+    struct TraceRequest {
+        const char* path;
+        bool done;
+    };
+
+    m6800_trace* tracer; /* while tracing */
+
+    enum ProfileAction {
+        ProfileStart,
+        ProfileStop,
+        ProfileClear,
+        ProfileCopy,
+        ProfileCopyCalls
+    };
+
+    m6800_profiler* profiler; /* allocated the first time profiling starts */
+    m6800_call_profiler* call_profiler; /* likewise */
+    std::atomic<bool> profiling;
+
+    int idle_period; /* cycles of one turn of the idle loop, 0 when not idle */
+    int idle_probe_wait; /* frames until the next look for an idle loop */
+    int idle_probe_backoff; /* frames to wait after the next look that finds none */
+    m6800_state idle_cpu; /* the machine as the worker last left it while idle */
+    std::vector<uint8_t> idle_memory;
+    unsigned idle_io; /* I/O access count at the same point */
+    std::vector<uint16_t> idle_pcs; /* addresses the idle loop runs through */
+    std::atomic<bool> idle_skip;
+    std::atomic<bool> idle;
+    std::atomic<unsigned long long> idle_cycles;
+
+    void send(CommandType type, uint32_t arg = 0, void* data = nullptr);
+    void execute(const Command& command);
     void worker();
     void render_frame();
     bool check_breakpoint(uint32_t address);
+    void forget_stopped_breakpoint(offs_t address);
+    MachineParts get_parts();
+    void step_instruction();
+    bool rewind_to_cycle(unsigned long long cycle);
+    int replay_from_frame(unsigned long long cycle, int max_instructions);
+    void load_machine_state(const MachineState& saved);
+    void apply_input(const InputEvent& event);
+    void apply_replay_input();
+    bool can_skip_idle();
+    int find_idle_period(int max_cycles);
+    void save_idle_state();
+    bool same_idle_state();
+    unsigned long long skip_idle(unsigned long long cycles);
+    QString function_name(uint32_t function);
 };
 
 #endif // ET3400EMU_H
\ No newline at end of file
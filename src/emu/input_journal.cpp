@@ -0,0 +1,150 @@
+#include "input_journal.h"
+#include "state_stream.h"
+
+#include <algorithm>
+#include <string.h>
+
+static const char JOURNAL_MAGIC[8] = { 'E', 'T', '3', '4', '0', '0', 'I', 'J' };
+
+static const size_t EVENT_SIZE = 10; /* u64 cycle, u8 type, u8 value */
+
+InputJournal::InputJournal() {
+    started = false;
+    end_cycle = 0;
+}
+
+void InputJournal::start(const MachineState& state) {
+    started = true;
+    start_state = state;
+    end_cycle = state.get_total_cycles();
+    events.clear();
+}
+
+void InputJournal::add(unsigned long long cycle, InputEvent::Type type, uint8_t value) {
+    events.push_back(InputEvent { cycle, (uint8_t)type, value });
+    end_cycle = std::max(end_cycle, cycle);
+}
+
+void InputJournal::truncate(unsigned long long cycle) {
+    events.erase(events.begin() + find(cycle), events.end());
+    end_cycle = std::min(end_cycle, cycle);
+}
+
+void InputJournal::set_end_cycle(unsigned long long cycle) {
+    end_cycle = cycle;
+}
+
+bool InputJournal::has_start() const {
+    return started;
+}
+
+const MachineState& InputJournal::get_start() const {
+    return start_state;
+}
+
+unsigned long long InputJournal::get_end_cycle() const {
+    return end_cycle;
+}
+
+const std::vector<InputEvent>& InputJournal::get_events() const {
+    return events;
+}
+
+size_t InputJournal::find(unsigned long long cycle) const {
+    // events are added in cycle order
+    std::vector<InputEvent>::const_iterator it = std::lower_bound(events.begin(), events.end(), cycle,
+        [](const InputEvent& event, unsigned long long cycle) { return event.cycle < cycle; });
+    return it - events.begin();
+}
+
+std::vector<uint8_t> InputJournal::serialize() const {
+    std::vector<uint8_t> out;
+    StateWriter writer(out);
+
+    writer.bytes((const uint8_t*)JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    writer.u32(VERSION);
+
+    std::vector<uint8_t> state = start_state.serialize();
+    writer.begin_chunk("STAT");
+    writer.bytes(state.data(), state.size());
+    writer.end_chunk();
+
+    writer.begin_chunk("END ");
+    writer.u64(end_cycle);
+    writer.end_chunk();
+
+    writer.begin_chunk("EVNT");
+    writer.u32(events.size());
+    std::vector<InputEvent>::const_iterator it = events.begin();
+    while (it != events.end()) {
+        writer.u64((*it).cycle);
+        writer.u8((*it).type);
+        writer.u8((*it).value);
+        it++;
+    }
+    writer.end_chunk();
+
+    return out;
+}
+
+bool InputJournal::deserialize(const uint8_t* data, size_t size) {
+    StateReader reader(data, size);
+
+    uint8_t magic[sizeof(JOURNAL_MAGIC)];
+    reader.bytes(magic, sizeof(magic));
+    uint32_t version = reader.u32();
+    if (!reader.ok || memcmp(magic, JOURNAL_MAGIC, sizeof(magic)) != 0 || version == 0 || version > VERSION) {
+        return false;
+    }
+
+    InputJournal journal;
+    bool has_events = false;
+
+    while (reader.ok && reader.remaining() > 0) {
+        char tag[4];
+        reader.bytes((uint8_t*)tag, 4);
+        uint32_t length = reader.u32();
+        StateReader chunk = reader.sub(length);
+        if (!reader.ok) {
+            return false;
+        }
+
+        if (memcmp(tag, "STAT", 4) == 0) {
+            std::vector<uint8_t> state(chunk.remaining());
+            chunk.bytes(state.data(), state.size());
+            if (!journal.start_state.deserialize(state.data(), state.size())) {
+                return false;
+            }
+            journal.started = true;
+        } else if (memcmp(tag, "END ", 4) == 0) {
+            journal.end_cycle = chunk.u64();
+        } else if (memcmp(tag, "EVNT", 4) == 0) {
+            uint32_t count = chunk.u32();
+            if (count > chunk.remaining() / EVENT_SIZE) {
+                return false;
+            }
+            journal.events.resize(count);
+            for (uint32_t i = 0; i < count; i++) {
+                journal.events[i].cycle = chunk.u64();
+                journal.events[i].type = chunk.u8();
+                journal.events[i].value = chunk.u8();
+                if (journal.events[i].type > InputEvent::Serial || (i > 0 && journal.events[i].cycle < journal.events[i - 1].cycle)) {
+                    return false;
+                }
+            }
+            has_events = true;
+        }
+        // unknown chunks are from a later version and are skipped
+
+        if (!chunk.ok) {
+            return false;
+        }
+    }
+
+    if (!reader.ok || !journal.started || !has_events) {
+        return false;
+    }
+
+    *this = journal;
+    return true;
+}
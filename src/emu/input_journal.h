@@ -0,0 +1,68 @@
+#ifndef INPUT_JOURNAL_H
+#define INPUT_JOURNAL_H
+
+#include "machine_state.h"
+
+#include <stdint.h>
+#include <vector>
+
+/*
+    Input journal
+
+    Everything that reaches the machine from outside (key presses and releases, resets and
+    bytes for the serial port) is applied by the emulation thread between two instructions
+    and logged here with the cycle count at that point. Together with the state the machine
+    was in when the journal started, that is enough to run the session again: replaying ends
+    each slice of emulation exactly at the next event's cycle, so every event lands between
+    the same two instructions as it did live and the replay ends in the same state, however
+    fast it runs.
+
+    serialize() writes the same chunked format as MachineState, with its own magic: the start
+    state ("STAT"), the cycle recording stopped at ("END ") and the events ("EVNT").
+*/
+
+struct InputEvent {
+    enum Type {
+        KeyPress,
+        KeyRelease,
+        Reset,
+        Serial
+    };
+
+    unsigned long long cycle;
+    uint8_t type;
+    uint8_t value; /* keypad_io::Keys or the serial byte */
+};
+
+class InputJournal {
+public:
+    static const uint32_t VERSION = 1;
+
+    InputJournal();
+
+    // drops the events and starts over from a state taken at its cycle count
+    void start(const MachineState& state);
+    void add(unsigned long long cycle, InputEvent::Type type, uint8_t value);
+    // drops the events at or after cycle, when the machine goes back in time
+    void truncate(unsigned long long cycle);
+    void set_end_cycle(unsigned long long cycle);
+
+    bool has_start() const;
+    const MachineState& get_start() const;
+    unsigned long long get_end_cycle() const;
+    const std::vector<InputEvent>& get_events() const;
+    // index of the first event at or after cycle
+    size_t find(unsigned long long cycle) const;
+
+    std::vector<uint8_t> serialize() const;
+    // false if the data isn't a journal, is from a newer version or is cut short
+    bool deserialize(const uint8_t* data, size_t size);
+
+private:
+    bool started;
+    MachineState start_state;
+    unsigned long long end_cycle;
+    std::vector<InputEvent> events;
+};
+
+#endif // INPUT_JOURNAL_H
@@ -0,0 +1,276 @@
+#include "machine_state.h"
+#include "state_stream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string.h>
+
+static const char STATE_MAGIC[8] = { 'E', 'T', '3', '4', '0', '0', 'S', 'S' };
+
+static std::atomic<uint64_t> next_id(1);
+
+MachineState::MachineState() {
+    id = 0;
+    total_cycles = 0;
+    memset(&cpu, 0, sizeof(cpu));
+    ram_start = 0;
+    memset(display, 0, sizeof(display));
+    memset(keypad, 0xFF, sizeof(keypad));
+    pia = MC6820State {};
+}
+
+void MachineState::capture(const MachineParts& machine, unsigned long long total_cycles) {
+    capture_devices(machine, total_cycles);
+
+    ram_start = machine.ram->get_start();
+    const uint8_t* memory = machine.ram->get_mapped_memory();
+    ram.assign(memory, memory + (machine.ram->get_end() - ram_start + 1));
+
+    roms.clear();
+    std::vector<rom_device*>::const_iterator it = machine.roms->begin();
+    while (it != machine.roms->end()) {
+        std::shared_ptr<const rom_image> image = (*it)->get_image();
+        roms.push_back(RomEntry { (*it)->get_start(), (uint32_t)image->get_size(), image->get_hash() });
+        it++;
+    }
+
+    // RAM now matches this state, the next restore of it only needs the pages written after here
+    machine.memory_map->clear_dirty(MemoryMapManager::TRACK_STATE);
+}
+
+bool MachineState::fits(const MachineParts& machine) const {
+    if (machine.ram->get_start() != ram_start || machine.ram->get_end() - ram_start + 1 != ram.size()) {
+        return false;
+    }
+    if (machine.roms->size() != roms.size()) {
+        return false;
+    }
+
+    // ROMs are mapped in the same order on every machine built the same way
+    for (size_t i = 0; i < roms.size(); i++) {
+        rom_device* rom = (*machine.roms)[i];
+        std::shared_ptr<const rom_image> image = rom->get_image();
+        if (rom->get_start() != roms[i].address || image->get_size() != roms[i].size || image->get_hash() != roms[i].hash) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MachineState::restore(const MachineParts& machine, bool dirty_only) const {
+    uint8_t* memory = machine.ram->get_mapped_memory();
+    offs_t ram_end = ram_start + ram.size() - 1;
+    int first = ram_start >> MemoryMapManager::PAGE_SHIFT;
+    int last = ram_end >> MemoryMapManager::PAGE_SHIFT;
+    for (int page = first; page <= last; page++) {
+        if (dirty_only && !machine.memory_map->is_dirty(page, MemoryMapManager::TRACK_STATE)) {
+            continue;
+        }
+        offs_t start = std::max<offs_t>(page << MemoryMapManager::PAGE_SHIFT, ram_start);
+        offs_t end = std::min<offs_t>((page << MemoryMapManager::PAGE_SHIFT) | MemoryMapManager::PAGE_MASK, ram_end);
+        memcpy(&memory[start - ram_start], &ram[start - ram_start], end - start + 1);
+        // drops predecoded and translated code built from the old bytes
+        machine.memory_map->notify_write(start, end - start + 1);
+    }
+    machine.memory_map->clear_dirty(MemoryMapManager::TRACK_STATE);
+
+    restore_devices(machine);
+}
+
+void MachineState::capture_devices(const MachineParts& machine, unsigned long long total_cycles) {
+    id = next_id++;
+    this->total_cycles = total_cycles;
+    machine.cpu->save_state(cpu);
+    memcpy(display, machine.display->get_mapped_memory(), sizeof(display));
+    memcpy(keypad, machine.keypad->get_mapped_memory(), sizeof(keypad));
+    machine.pia->save_state(pia);
+}
+
+void MachineState::restore_devices(const MachineParts& machine) const {
+    machine.cpu->load_state(cpu);
+    machine.display->load(display);
+    memcpy(machine.keypad->get_mapped_memory(), keypad, sizeof(keypad));
+    machine.pia->load_state(pia);
+}
+
+uint64_t MachineState::get_id() const {
+    return id;
+}
+
+unsigned long long MachineState::get_total_cycles() const {
+    return total_cycles;
+}
+
+const m6800_state& MachineState::get_cpu() const {
+    return cpu;
+}
+
+const std::vector<uint8_t>& MachineState::get_ram() const {
+    return ram;
+}
+
+std::vector<uint8_t> MachineState::serialize() const {
+    std::vector<uint8_t> out;
+    StateWriter writer(out);
+
+    writer.bytes((const uint8_t*)STATE_MAGIC, sizeof(STATE_MAGIC));
+    writer.u32(VERSION);
+
+    writer.begin_chunk("CPU ");
+    writer.u16(cpu.ppc);
+    writer.u16(cpu.pc);
+    writer.u16(cpu.s);
+    writer.u16(cpu.x);
+    writer.u8(cpu.a);
+    writer.u8(cpu.b);
+    writer.u8(cpu.cc);
+    writer.u8(cpu.wai_state);
+    writer.u8(cpu.nmi_state);
+    writer.u8(cpu.nmi_pending);
+    writer.bytes(cpu.irq_state, sizeof(cpu.irq_state));
+    writer.u32(cpu.icount);
+    writer.u32(cpu.reset_line);
+    writer.u64(total_cycles);
+    writer.end_chunk();
+
+    writer.begin_chunk("RAM ");
+    writer.u16(ram_start);
+    writer.bytes(ram.data(), ram.size());
+    writer.end_chunk();
+
+    writer.begin_chunk("DISP");
+    writer.bytes(display, sizeof(display));
+    writer.end_chunk();
+
+    writer.begin_chunk("KEYS");
+    writer.bytes(keypad, sizeof(keypad));
+    writer.end_chunk();
+
+    writer.begin_chunk("PIA ");
+    writer.u8(pia.cra);
+    writer.u8(pia.crb);
+    writer.u8(pia.ddra);
+    writer.u8(pia.ddrb);
+    writer.u8(pia.pra);
+    writer.u8(pia.prb);
+    writer.u32(pia.serial.sendState);
+    writer.u32(pia.serial.sendBuffer);
+    writer.u32(pia.serial.rcvState);
+    writer.u8(pia.serial.rcvBuffer);
+    writer.u8(pia.serial.tempBuffer);
+    writer.u32(pia.serial.input.size());
+    writer.bytes(pia.serial.input.data(), pia.serial.input.size());
+    writer.u8(pia.ca1);
+    writer.u8(pia.cb1);
+    writer.end_chunk();
+
+    writer.begin_chunk("ROMS");
+    writer.u32(roms.size());
+    std::vector<RomEntry>::const_iterator it = roms.begin();
+    while (it != roms.end()) {
+        writer.u16((*it).address);
+        writer.u32((*it).size);
+        writer.u64((*it).hash);
+        it++;
+    }
+    writer.end_chunk();
+
+    return out;
+}
+
+bool MachineState::deserialize(const uint8_t* data, size_t size) {
+    StateReader reader(data, size);
+
+    uint8_t magic[sizeof(STATE_MAGIC)];
+    reader.bytes(magic, sizeof(magic));
+    uint32_t version = reader.u32();
+    if (!reader.ok || memcmp(magic, STATE_MAGIC, sizeof(magic)) != 0 || version == 0 || version > VERSION) {
+        return false;
+    }
+
+    MachineState state;
+    bool has_cpu = false;
+    bool has_ram = false;
+
+    while (reader.ok && reader.remaining() > 0) {
+        char tag[4];
+        reader.bytes((uint8_t*)tag, 4);
+        uint32_t length = reader.u32();
+        StateReader chunk = reader.sub(length);
+        if (!reader.ok) {
+            return false;
+        }
+
+        if (memcmp(tag, "CPU ", 4) == 0) {
+            state.cpu.ppc = chunk.u16();
+            state.cpu.pc = chunk.u16();
+            state.cpu.s = chunk.u16();
+            state.cpu.x = chunk.u16();
+            state.cpu.a = chunk.u8();
+            state.cpu.b = chunk.u8();
+            state.cpu.cc = chunk.u8();
+            state.cpu.wai_state = chunk.u8();
+            state.cpu.nmi_state = chunk.u8();
+            state.cpu.nmi_pending = chunk.u8();
+            chunk.bytes(state.cpu.irq_state, sizeof(state.cpu.irq_state));
+            state.cpu.icount = (int32_t)chunk.u32();
+            state.cpu.reset_line = (int32_t)chunk.u32();
+            state.total_cycles = chunk.u64();
+            has_cpu = true;
+        } else if (memcmp(tag, "RAM ", 4) == 0) {
+            state.ram_start = chunk.u16();
+            state.ram.resize(chunk.remaining());
+            chunk.bytes(state.ram.data(), state.ram.size());
+            has_ram = !state.ram.empty() && state.ram_start + state.ram.size() <= 0x10000;
+        } else if (memcmp(tag, "DISP", 4) == 0) {
+            chunk.bytes(state.display, sizeof(state.display));
+        } else if (memcmp(tag, "KEYS", 4) == 0) {
+            chunk.bytes(state.keypad, sizeof(state.keypad));
+        } else if (memcmp(tag, "PIA ", 4) == 0) {
+            state.pia.cra = chunk.u8();
+            state.pia.crb = chunk.u8();
+            state.pia.ddra = chunk.u8();
+            state.pia.ddrb = chunk.u8();
+            state.pia.pra = chunk.u8();
+            state.pia.prb = chunk.u8();
+            state.pia.serial.sendState = (int32_t)chunk.u32();
+            state.pia.serial.sendBuffer = (int32_t)chunk.u32();
+            state.pia.serial.rcvState = (int32_t)chunk.u32();
+            state.pia.serial.rcvBuffer = chunk.u8();
+            state.pia.serial.tempBuffer = chunk.u8();
+            uint32_t count = chunk.u32();
+            if (count > chunk.remaining()) {
+                return false;
+            }
+            state.pia.serial.input.resize(count);
+            chunk.bytes(state.pia.serial.input.data(), count);
+            // the interrupt inputs were added later
+            if (chunk.remaining() >= 2) {
+                state.pia.ca1 = chunk.u8();
+                state.pia.cb1 = chunk.u8();
+            }
+        } else if (memcmp(tag, "ROMS", 4) == 0) {
+            uint32_t count = chunk.u32();
+            for (uint32_t i = 0; i < count && chunk.ok; i++) {
+                RomEntry entry;
+                entry.address = chunk.u16();
+                entry.size = chunk.u32();
+                entry.hash = chunk.u64();
+                state.roms.push_back(entry);
+            }
+        }
+        // unknown chunks are from a later version and are skipped
+
+        if (!chunk.ok) {
+            return false;
+        }
+    }
+
+    if (!reader.ok || !has_cpu || !has_ram) {
+        return false;
+    }
+
+    *this = state;
+    id = next_id++;
+    return true;
+}
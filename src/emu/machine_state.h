@@ -0,0 +1,81 @@
+#ifndef MACHINE_STATE_H
+#define MACHINE_STATE_H
+
+#include "../cpu/m6800.h"
+#include "../dev/devices.h"
+
+#include <stdint.h>
+#include <vector>
+
+/*
+    Save states
+
+    A MachineState holds everything that changes while an ET-3400 runs: the CPU registers and
+    interrupt lines, RAM, the display and keypad latches, the PIA registers and the serial
+    adapter. ROMs are not copied, the state only records where each one was mapped and a hash
+    of its contents, and refuses to restore over a different set.
+
+    Restoring is meant to be cheap enough to fork thousands of runs from one booted machine.
+    Taking or restoring a state marks every RAM page clean in the memory map; when the same
+    state is restored again only the pages written since then are copied back.
+
+    serialize() writes a versioned binary format: an 8 byte magic, a version number and a list
+    of tagged chunks (tag, length, payload). Readers skip chunks they don't know, so chunks can
+    be added without a new version; the version only goes up when an existing chunk changes.
+*/
+
+// the parts of one machine a state is taken from and restored to
+struct MachineParts {
+    m6800_cpu_device* cpu;
+    MemoryMapManager* memory_map;
+    memory_device* ram;
+    display_io* display;
+    keypad_io* keypad;
+    MC6820* pia;
+    const std::vector<rom_device*>* roms;
+};
+
+class MachineState {
+public:
+    static const uint32_t VERSION = 1;
+
+    MachineState();
+
+    void capture(const MachineParts& machine, unsigned long long total_cycles);
+    // false if the machine's RAM or ROMs aren't the ones the state was taken from
+    bool fits(const MachineParts& machine) const;
+    // dirty_only: the machine's RAM held this state when its dirty pages were last cleared
+    void restore(const MachineParts& machine, bool dirty_only) const;
+    // everything but RAM and the ROM list, for the rewind buffer which keeps RAM as page deltas
+    void capture_devices(const MachineParts& machine, unsigned long long total_cycles);
+    void restore_devices(const MachineParts& machine) const;
+
+    // changes with every capture or deserialize, copies of a state keep it
+    uint64_t get_id() const;
+    unsigned long long get_total_cycles() const;
+    const m6800_state& get_cpu() const;
+    const std::vector<uint8_t>& get_ram() const;
+
+    std::vector<uint8_t> serialize() const;
+    // false if the data isn't a state, is from a newer version or is cut short
+    bool deserialize(const uint8_t* data, size_t size);
+
+private:
+    struct RomEntry {
+        offs_t address;
+        uint32_t size;
+        uint64_t hash;
+    };
+
+    uint64_t id;
+    unsigned long long total_cycles;
+    m6800_state cpu;
+    offs_t ram_start;
+    std::vector<uint8_t> ram;
+    uint8_t display[96];
+    uint8_t keypad[4];
+    MC6820State pia;
+    std::vector<RomEntry> roms;
+};
+
+#endif // MACHINE_STATE_H
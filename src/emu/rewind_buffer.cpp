@@ -0,0 +1,151 @@
+#include "rewind_buffer.h"
+
+#include <string.h>
+
+RewindBuffer::RewindBuffer(size_t budget) {
+    this->budget = budget;
+    bytes = 0;
+    since_keyframe = 0;
+}
+
+void RewindBuffer::set_budget(size_t budget) {
+    this->budget = budget;
+    trim();
+}
+
+size_t RewindBuffer::get_budget() {
+    return budget;
+}
+
+void RewindBuffer::record(const MachineParts& machine, unsigned long long total_cycles) {
+    // nothing ran since the last frame, pages written meanwhile stay dirty for the next one
+    if (!frames.empty() && frames.back().devices.get_total_cycles() == total_cycles) {
+        return;
+    }
+
+    frames.emplace_back();
+    Frame& frame = frames.back();
+    frame.devices.capture_devices(machine, total_cycles);
+
+    offs_t ram_start = machine.ram->get_start();
+    offs_t ram_end = machine.ram->get_end();
+    const uint8_t* memory = machine.ram->get_mapped_memory();
+
+    frame.keyframe = frames.size() == 1 || since_keyframe >= KEYFRAME_INTERVAL;
+    if (frame.keyframe) {
+        frame.data.assign(memory, memory + (ram_end - ram_start + 1));
+        since_keyframe = 0;
+    } else {
+        int first = ram_start >> MemoryMapManager::PAGE_SHIFT;
+        int last = ram_end >> MemoryMapManager::PAGE_SHIFT;
+        for (int page = first; page <= last; page++) {
+            if (machine.memory_map->is_dirty(page, MemoryMapManager::TRACK_REWIND)) {
+                // RAM starts and ends on page boundaries on the ET-3400
+                const uint8_t* source = &memory[(page << MemoryMapManager::PAGE_SHIFT) - ram_start];
+                frame.pages.push_back(page);
+                frame.data.insert(frame.data.end(), source, source + MemoryMapManager::PAGE_SIZE);
+            }
+        }
+        since_keyframe++;
+    }
+    machine.memory_map->clear_dirty(MemoryMapManager::TRACK_REWIND);
+
+    bytes += frame_bytes(frame);
+    trim();
+}
+
+bool RewindBuffer::restore(const MachineParts& machine, unsigned long long cycle, unsigned long long& restored_cycle) {
+    if (frames.empty() || frames.front().devices.get_total_cycles() > cycle) {
+        return false;
+    }
+
+    // newest frame at or before cycle
+    size_t low = 0;
+    size_t high = frames.size();
+    while (high - low > 1) {
+        size_t middle = (low + high) / 2;
+        if (frames[middle].devices.get_total_cycles() <= cycle) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    size_t index = low;
+    size_t keyframe = index;
+    while (!frames[keyframe].keyframe) {
+        keyframe--;
+    }
+
+    offs_t ram_start = machine.ram->get_start();
+    size_t ram_size = machine.ram->get_end() - ram_start + 1;
+    uint8_t* memory = machine.ram->get_mapped_memory();
+
+    memcpy(memory, frames[keyframe].data.data(), ram_size);
+    for (size_t i = keyframe + 1; i <= index; i++) {
+        const Frame& frame = frames[i];
+        for (size_t k = 0; k < frame.pages.size(); k++) {
+            offs_t offset = (frame.pages[k] << MemoryMapManager::PAGE_SHIFT) - ram_start;
+            memcpy(&memory[offset], &frame.data[k * MemoryMapManager::PAGE_SIZE], MemoryMapManager::PAGE_SIZE);
+        }
+    }
+    // drops code built from the old bytes and tells save states every page changed
+    machine.memory_map->notify_write(ram_start, ram_size);
+    machine.memory_map->clear_dirty(MemoryMapManager::TRACK_REWIND);
+
+    frames[index].devices.restore_devices(machine);
+    restored_cycle = frames[index].devices.get_total_cycles();
+
+    while (frames.size() > index + 1) {
+        bytes -= frame_bytes(frames.back());
+        frames.pop_back();
+    }
+    since_keyframe = index - keyframe;
+    return true;
+}
+
+void RewindBuffer::clear() {
+    frames.clear();
+    bytes = 0;
+    since_keyframe = 0;
+}
+
+bool RewindBuffer::empty() {
+    return frames.empty();
+}
+
+unsigned long long RewindBuffer::get_oldest_cycle() {
+    return frames.empty() ? 0 : frames.front().devices.get_total_cycles();
+}
+
+unsigned long long RewindBuffer::get_newest_cycle() {
+    return frames.empty() ? 0 : frames.back().devices.get_total_cycles();
+}
+
+size_t RewindBuffer::get_frames() {
+    return frames.size();
+}
+
+size_t RewindBuffer::get_bytes() {
+    return bytes;
+}
+
+size_t RewindBuffer::frame_bytes(const Frame& frame) {
+    return sizeof(Frame) + frame.pages.capacity() + frame.data.capacity();
+}
+
+void RewindBuffer::trim() {
+    while (bytes > budget) {
+        // a keyframe and its deltas go together, the newest keyframe always stays
+        size_t next = 1;
+        while (next < frames.size() && !frames[next].keyframe) {
+            next++;
+        }
+        if (next >= frames.size()) {
+            break;
+        }
+        for (size_t i = 0; i < next; i++) {
+            bytes -= frame_bytes(frames.front());
+            frames.pop_front();
+        }
+    }
+}
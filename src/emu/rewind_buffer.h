@@ -0,0 +1,63 @@
+#ifndef REWIND_BUFFER_H
+#define REWIND_BUFFER_H
+
+#include "machine_state.h"
+
+#include <deque>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/*
+    Rewind buffer
+
+    Records the machine after every emulated frame so the debugger can go back in time. Every
+    KEYFRAME_INTERVAL frames a frame holds a full copy of RAM, the frames in between only hold
+    the RAM pages written since the frame before. Which pages those are comes from the memory
+    map's dirty tracking, so recording never compares memory: a frame costs the registers and
+    device state plus a copy of each written page.
+
+    The oldest frames are dropped, a keyframe and its deltas at a time, to stay inside the
+    memory budget.
+*/
+class RewindBuffer {
+public:
+    static const size_t DEFAULT_BUDGET = 64 * 1024 * 1024;
+    static const int KEYFRAME_INTERVAL = 60;
+
+    RewindBuffer(size_t budget = DEFAULT_BUDGET);
+
+    void set_budget(size_t budget);
+    size_t get_budget();
+
+    // called by the emulation thread between two frames
+    void record(const MachineParts& machine, unsigned long long total_cycles);
+    // restores the newest frame recorded at or before cycle and drops the frames after it,
+    // returns false if every frame is newer
+    bool restore(const MachineParts& machine, unsigned long long cycle, unsigned long long& restored_cycle);
+    void clear();
+
+    bool empty();
+    unsigned long long get_oldest_cycle();
+    unsigned long long get_newest_cycle();
+    size_t get_frames();
+    size_t get_bytes();
+
+private:
+    struct Frame {
+        MachineState devices; /* registers and device state, RAM is kept in pages and data */
+        bool keyframe;
+        std::vector<uint8_t> pages; /* numbers of the RAM pages in data, empty for a keyframe */
+        std::vector<uint8_t> data;
+    };
+
+    size_t budget;
+    size_t bytes;
+    int since_keyframe;
+    std::deque<Frame> frames;
+
+    static size_t frame_bytes(const Frame& frame);
+    void trim();
+};
+
+#endif // REWIND_BUFFER_H
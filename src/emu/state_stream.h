@@ -0,0 +1,131 @@
+#ifndef STATE_STREAM_H
+#define STATE_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+/*
+    Little-endian writer and reader for the binary formats of save states and input journals:
+    plain integers and byte runs, grouped in tagged chunks (4 byte tag, 32 bit length, payload).
+*/
+
+// little-endian writer for the serialized format
+class StateWriter {
+public:
+    StateWriter(std::vector<uint8_t>& out) : out(out) {
+        chunk_start = 0;
+    }
+
+    void u8(uint8_t value) {
+        out.push_back(value);
+    }
+
+    void u16(uint16_t value) {
+        u8(value & 0xFF);
+        u8(value >> 8);
+    }
+
+    void u32(uint32_t value) {
+        u16(value & 0xFFFF);
+        u16(value >> 16);
+    }
+
+    void u64(uint64_t value) {
+        u32(value & 0xFFFFFFFF);
+        u32(value >> 32);
+    }
+
+    void bytes(const uint8_t* data, size_t size) {
+        out.insert(out.end(), data, data + size);
+    }
+
+    void begin_chunk(const char* tag) {
+        bytes((const uint8_t*)tag, 4);
+        chunk_start = out.size();
+        u32(0);
+    }
+
+    void end_chunk() {
+        uint32_t length = out.size() - chunk_start - 4;
+        for (int i = 0; i < 4; i++) {
+            out[chunk_start + i] = (length >> (i * 8)) & 0xFF;
+        }
+    }
+
+private:
+    std::vector<uint8_t>& out;
+    size_t chunk_start;
+};
+
+// reads what StateWriter wrote, running past the end leaves ok false and returns zeros
+class StateReader {
+public:
+    StateReader(const uint8_t* data, size_t size) {
+        this->data = data;
+        this->size = size;
+        position = 0;
+        ok = true;
+    }
+
+    bool ok;
+
+    uint8_t u8() {
+        if (position >= size) {
+            ok = false;
+            return 0;
+        }
+        return data[position++];
+    }
+
+    uint16_t u16() {
+        uint16_t low = u8();
+        return low | (u8() << 8);
+    }
+
+    uint32_t u32() {
+        uint32_t low = u16();
+        return low | ((uint32_t)u16() << 16);
+    }
+
+    uint64_t u64() {
+        uint64_t low = u32();
+        return low | ((uint64_t)u32() << 32);
+    }
+
+    void bytes(uint8_t* out, size_t count) {
+        if (count == 0) {
+            return;
+        }
+        if (count > size - position) {
+            ok = false;
+            memset(out, 0, count);
+            return;
+        }
+        memcpy(out, &data[position], count);
+        position += count;
+    }
+
+    // a reader over the next length bytes, which are skipped in this one
+    StateReader sub(size_t length) {
+        if (length > size - position) {
+            ok = false;
+            length = size - position;
+        }
+        StateReader reader(&data[position], length);
+        position += length;
+        return reader;
+    }
+
+    size_t remaining() {
+        return size - position;
+    }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+};
+
+#endif // STATE_STREAM_H
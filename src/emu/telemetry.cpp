@@ -0,0 +1,142 @@
+#include "telemetry.h"
+#include "../util/frame_pacer.h"
+
+const int Telemetry::JITTER_BOUNDS_US[TelemetrySnapshot::JITTER_BUCKETS - 1] = { 50, 100, 250, 500, 1000, 2500, 5000 };
+
+Telemetry::Telemetry() {
+    Counter* counters[] = { &instructions, &cycles, &slices, &repaints };
+    for (Counter* counter : counters) {
+        counter->value = 0;
+        counter->base = 0;
+    }
+    for (int i = 0; i < TelemetrySnapshot::JITTER_BUCKETS; i++) {
+        jitter[i].value = 0;
+        jitter[i].base = 0;
+    }
+    window_start = 0;
+    pause();
+}
+
+void Telemetry::reset() {
+    instructions.reset();
+    cycles.reset();
+    slices.reset();
+    repaints.reset();
+    for (int i = 0; i < TelemetrySnapshot::JITTER_BUCKETS; i++) {
+        jitter[i].reset();
+    }
+}
+
+void Telemetry::get(TelemetrySnapshot& snapshot) {
+    snapshot.instructions = instructions.get();
+    snapshot.cycles = cycles.get();
+    snapshot.slices = slices.get();
+    snapshot.repaints = repaints.get();
+    for (int i = 0; i < TelemetrySnapshot::JITTER_BUCKETS; i++) {
+        snapshot.jitter[i] = jitter[i].get();
+    }
+    snapshot.emulated_mhz = emulated_mhz;
+    snapshot.mips = mips;
+    snapshot.slice_us = slice_us;
+    snapshot.slice_max_us = slice_max_us;
+    snapshot.host_load = host_load;
+    snapshot.overshoot_us = overshoot_us;
+    snapshot.overshoot_max_us = overshoot_max_us;
+    snapshot.repaint_hz = repaint_hz;
+}
+
+void Telemetry::add_repaint() {
+    // the only counter written from outside the worker
+    repaints.value.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Telemetry::add_slice(unsigned long long instructions, unsigned long long cycles, int64_t host_ns) {
+    this->instructions.add(instructions);
+    this->cycles.add(cycles);
+    slices.add(1);
+
+    int64_t now = FramePacer::now();
+    if (window_start == 0) {
+        // the slice just run started before the window, so it is left out of the rates
+        start_window(now);
+        return;
+    }
+    window_instructions += instructions;
+    window_cycles += cycles;
+    window_slices++;
+    window_host_ns += host_ns;
+    if (host_ns > window_slice_max_ns) {
+        window_slice_max_ns = host_ns;
+    }
+    if (now - window_start >= WINDOW_NS) {
+        end_window(now);
+        start_window(now);
+    }
+}
+
+void Telemetry::add_wait(int64_t late_ns) {
+    int64_t late_us = late_ns / 1000;
+    int bucket = 0;
+    while (bucket < TelemetrySnapshot::JITTER_BUCKETS - 1 && late_us > JITTER_BOUNDS_US[bucket]) {
+        bucket++;
+    }
+    jitter[bucket].add(1);
+
+    window_waits++;
+    window_late_ns += late_ns;
+    if (late_ns > window_late_max_ns) {
+        window_late_max_ns = late_ns;
+    }
+}
+
+void Telemetry::add_idle(unsigned long long cycles) {
+    this->cycles.add(cycles);
+
+    int64_t now = FramePacer::now();
+    if (window_start == 0) {
+        start_window(now);
+        return;
+    }
+    window_cycles += cycles;
+    if (now - window_start >= WINDOW_NS) {
+        end_window(now);
+        start_window(now);
+    }
+}
+
+void Telemetry::pause() {
+    window_start = 0;
+    emulated_mhz = 0;
+    mips = 0;
+    slice_us = 0;
+    slice_max_us = 0;
+    host_load = 0;
+    overshoot_us = 0;
+    overshoot_max_us = 0;
+    repaint_hz = 0;
+}
+
+void Telemetry::start_window(int64_t now) {
+    window_start = now;
+    window_instructions = 0;
+    window_cycles = 0;
+    window_slices = 0;
+    window_repaints = repaints.value.load(std::memory_order_relaxed);
+    window_host_ns = 0;
+    window_slice_max_ns = 0;
+    window_late_ns = 0;
+    window_late_max_ns = 0;
+    window_waits = 0;
+}
+
+void Telemetry::end_window(int64_t now) {
+    double elapsed_us = (now - window_start) / 1000.0;
+    emulated_mhz = window_cycles / elapsed_us;
+    mips = window_instructions / elapsed_us;
+    slice_us = window_slices > 0 ? window_host_ns / 1000.0 / window_slices : 0;
+    slice_max_us = window_slice_max_ns / 1000.0;
+    host_load = window_host_ns / 1000.0 / elapsed_us;
+    overshoot_us = window_waits > 0 ? window_late_ns / 1000.0 / window_waits : 0;
+    overshoot_max_us = window_late_max_ns / 1000.0;
+    repaint_hz = (repaints.value.load(std::memory_order_relaxed) - window_repaints) * 1e6 / elapsed_us;
+}
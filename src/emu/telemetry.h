@@ -0,0 +1,116 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <stdint.h>
+
+/*
+    Telemetry
+
+    Performance counters of the emulator thread. The worker reports each slice of CPU time it
+    runs and each frame wait, the UI reports each display repaint. Every counter has a single
+    writer and is an atomic, so any thread can read them while the emulator runs without
+    stopping it, and the worker pays a few relaxed stores per frame for them.
+
+    Totals count from the last reset(). Rates and averages are measured over the last complete
+    window of about a second, and drop to zero while the emulator is paused. Cycles skipped in
+    idle loops count as emulated but take no host time.
+
+    Frame waits are sorted into a histogram by how late the worker woke up: bucket i counts
+    the wake ups later than the bound of bucket i - 1 and no later than JITTER_BOUNDS_US[i],
+    the last bucket everything later.
+*/
+struct TelemetrySnapshot {
+    static const int JITTER_BUCKETS = 8;
+
+    unsigned long long instructions; /* retired */
+    unsigned long long cycles; /* emulated, skipped idle and delay loop cycles included */
+    unsigned long long slices; /* times the worker ran the CPU */
+    unsigned long long repaints; /* display repaints reported by the UI */
+    unsigned long long jitter[JITTER_BUCKETS];
+
+    double emulated_mhz;
+    double mips;
+    double slice_us; /* host time to run one slice, on average */
+    double slice_max_us;
+    double host_load; /* share of wall time spent running slices */
+    double overshoot_us; /* how late frame waits woke up, on average */
+    double overshoot_max_us;
+    double repaint_hz;
+
+    /* filled in by et3400emu, counted since it was created */
+    unsigned long long idle_cycles;
+    unsigned long long delay_loop_hits;
+    unsigned long long delay_loop_cycles;
+    double drift_us;
+    double jitter_us;
+    int resyncs;
+};
+
+class Telemetry {
+public:
+    static const int64_t WINDOW_NS = 1000000000;
+    static const int JITTER_BOUNDS_US[TelemetrySnapshot::JITTER_BUCKETS - 1];
+
+    Telemetry();
+
+    // can be called from any thread
+    void reset();
+    void get(TelemetrySnapshot& snapshot);
+    void add_repaint();
+
+    // called by the worker only
+    void add_slice(unsigned long long instructions, unsigned long long cycles, int64_t host_ns);
+    void add_wait(int64_t late_ns);
+    // cycles skipped while the worker slept in an idle loop, none in turbo mode
+    void add_idle(unsigned long long cycles);
+    void pause();
+
+private:
+    struct Counter {
+        std::atomic<unsigned long long> value;
+        std::atomic<unsigned long long> base; /* value at the last reset */
+
+        void add(unsigned long long amount) {
+            value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+        unsigned long long get() {
+            return value.load(std::memory_order_relaxed) - base.load(std::memory_order_relaxed);
+        }
+        void reset() {
+            base.store(value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    };
+
+    Counter instructions;
+    Counter cycles;
+    Counter slices;
+    Counter repaints;
+    Counter jitter[TelemetrySnapshot::JITTER_BUCKETS];
+
+    std::atomic<double> emulated_mhz;
+    std::atomic<double> mips;
+    std::atomic<double> slice_us;
+    std::atomic<double> slice_max_us;
+    std::atomic<double> host_load;
+    std::atomic<double> overshoot_us;
+    std::atomic<double> overshoot_max_us;
+    std::atomic<double> repaint_hz;
+
+    /* the window being measured, only touched by the worker */
+    int64_t window_start; /* 0 until the first slice after a pause */
+    unsigned long long window_instructions;
+    unsigned long long window_cycles;
+    unsigned long long window_slices;
+    unsigned long long window_repaints; /* repaint count at the start */
+    int64_t window_host_ns;
+    int64_t window_slice_max_ns;
+    int64_t window_late_ns;
+    int64_t window_late_max_ns;
+    int window_waits;
+
+    void start_window(int64_t now);
+    void end_window(int64_t now);
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,60 @@
+#ifndef BREAKPOINT_BITMAP_H
+#define BREAKPOINT_BITMAP_H
+
+#include "../common/common_defs.h"
+#include <atomic>
+#include <stdint.h>
+
+/*
+    One bit per address of the 64K address space, mirroring the breakpoints held by the
+    BreakpointManager. The CPU thread reads it without taking a lock; the manager updates it
+    while holding its own lock, one atomic word at a time.
+*/
+class BreakpointBitmap {
+public:
+    static const int WORD_COUNT = 0x10000 / 32;
+
+    BreakpointBitmap() {
+        clear();
+    }
+
+    // true if any breakpoint is set, the CPU skips the bitmap entirely when this is false
+    bool isArmed() const {
+        return armed.load(std::memory_order_acquire) != 0;
+    }
+
+    bool test(offs_t address) const {
+        return (words[(address >> 5) & (WORD_COUNT - 1)].load(std::memory_order_relaxed) >> (address & 31)) & 1;
+    }
+
+    void set(offs_t address) {
+        std::atomic<uint32_t>& word = words[(address >> 5) & (WORD_COUNT - 1)];
+        uint32_t bit = 1u << (address & 31);
+        if (!(word.load(std::memory_order_relaxed) & bit)) {
+            word.fetch_or(bit, std::memory_order_release);
+            armed.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    void reset(offs_t address) {
+        std::atomic<uint32_t>& word = words[(address >> 5) & (WORD_COUNT - 1)];
+        uint32_t bit = 1u << (address & 31);
+        if (word.load(std::memory_order_relaxed) & bit) {
+            word.fetch_and(~bit, std::memory_order_release);
+            armed.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void clear() {
+        for (int i = 0; i < WORD_COUNT; i++) {
+            words[i].store(0, std::memory_order_relaxed);
+        }
+        armed.store(0, std::memory_order_release);
+    }
+
+private:
+    std::atomic<uint32_t> words[WORD_COUNT]; /* 8 KB */
+    std::atomic<int> armed; /* number of bits set */
+};
+
+#endif // BREAKPOINT_BITMAP_H
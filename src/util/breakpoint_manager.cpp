@@ -2,6 +2,7 @@
 
 BreakpointManager::BreakpointManager() {
     breakpoints = new std::vector<Breakpoint>;
+    temporary = -1;
 }
 
 BreakpointManager::~BreakpointManager() {
@@ -12,20 +13,62 @@ std::vector<Breakpoint>* BreakpointManager::getBreakpoints() {
     return breakpoints;
 }
 
+const BreakpointBitmap* BreakpointManager::getBitmap() {
+    return &bitmap;
+}
+
 bool BreakpointManager::hasBreakpoint(offs_t address) {
     _lock.lock();
+    bool found = find(address);
+    _lock.unlock();
+    return found;
+}
+
+void BreakpointManager::setTemporaryBreakpoint(offs_t address) {
+    _lock.lock();
+    if (temporary != -1 && !find(temporary)) {
+        bitmap.reset(temporary);
+    }
+    temporary = address;
+    bitmap.set(address);
+    _lock.unlock();
+}
+
+void BreakpointManager::clearTemporaryBreakpoint() {
+    _lock.lock();
+    if (temporary != -1 && !find(temporary)) {
+        bitmap.reset(temporary);
+    }
+    temporary = -1;
+    _lock.unlock();
+}
+
+bool BreakpointManager::isTemporaryBreakpoint(offs_t address) {
+    _lock.lock();
+    bool temp = temporary == (int)address;
+    _lock.unlock();
+    return temp;
+}
+
+// callers hold _lock
+bool BreakpointManager::find(offs_t address) {
     std::vector<Breakpoint>::const_iterator it = breakpoints->begin();
     while (it != breakpoints->end()) {
         if ((*it).address == address) {
-            _lock.unlock();
             return true;
         }
         it++;
     }
-    _lock.unlock();
     return false;
 }
 
+// callers hold _lock, keeps the bit of the temporary breakpoint
+void BreakpointManager::unmark(offs_t address) {
+    if ((int)address != temporary) {
+        bitmap.reset(address);
+    }
+}
+
 void BreakpointManager::addBreakpoints(std::vector<Breakpoint>* newBreakpoints) {
     _lock.lock();
     std::vector<Breakpoint>::iterator current = newBreakpoints->begin();
@@ -42,6 +85,7 @@ void BreakpointManager::addBreakpoints(std::vector<Breakpoint>* newBreakpoints)
 
         if (!bfound) {
             breakpoints->push_back(*current);
+            bitmap.set((*current).address);
         }
         current++;
     }
@@ -53,12 +97,14 @@ void BreakpointManager::addBreakpoint(offs_t address) {
     std::vector<Breakpoint>::iterator it = breakpoints->begin();
     while (it != breakpoints->end()) {
         if ((*it).address == address) {
+            _lock.unlock();
             return;
         }
         it++;
     }
 
     breakpoints->push_back(Breakpoint { address, true });
+    bitmap.set(address);
     _lock.unlock();
 }
 
@@ -67,6 +113,7 @@ void BreakpointManager::clearRamBreakpoints() {
     std::vector<Breakpoint>::iterator it = breakpoints->begin();
     while (it != breakpoints->end()) {
         if ((*it).address < 0x0400) {
+            unmark((*it).address);
             it = breakpoints->erase(it);
         } else {
             it++;
@@ -80,6 +127,7 @@ void BreakpointManager::removeBreakpoint(offs_t address) {
     std::vector<Breakpoint>::iterator it = breakpoints->begin();
     while (it != breakpoints->end()) {
         if ((*it).address == address) {
+            unmark(address);
             it = breakpoints->erase(it);
         } else {
             it++;
@@ -93,6 +141,7 @@ void BreakpointManager::addOrRemoveBreakpoint(offs_t address) {
     std::vector<Breakpoint>::iterator it = breakpoints->begin();
     while (it != breakpoints->end()) {
         if ((*it).address == address) {
+            unmark(address);
             it = breakpoints->erase(it);
             _lock.unlock();
             return;
@@ -102,6 +151,7 @@ void BreakpointManager::addOrRemoveBreakpoint(offs_t address) {
     }
 
     breakpoints->push_back(Breakpoint { address, true });
+    bitmap.set(address);
     _lock.unlock();
 }
 
@@ -3,6 +3,7 @@
 
 #include "../common/common_defs.h"
 #include "breakpoint.h"
+#include "breakpoint_bitmap.h"
 #include <QString>
 #include <mutex>
 #include <thread>
@@ -21,10 +22,20 @@ public:
     void loadBreakpoints(QString path, bool& success);
     void saveBreakpoints(QString path, bool& success);
     std::vector<Breakpoint>* getBreakpoints();
+    const BreakpointBitmap* getBitmap();
+    // marks one extra address in the bitmap without adding it to the list, for run to address
+    void setTemporaryBreakpoint(offs_t address);
+    void clearTemporaryBreakpoint();
+    bool isTemporaryBreakpoint(offs_t address);
 
 private:
     std::vector<Breakpoint>* breakpoints;
+    BreakpointBitmap bitmap;
+    int temporary; /* address of the temporary breakpoint, -1 if none */
     std::mutex _lock;
+
+    bool find(offs_t address);
+    void unmark(offs_t address);
 };
 
 #endif // BREAKPOINT_MANAGER_H
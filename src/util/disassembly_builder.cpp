@@ -1,35 +1,90 @@
 #include "disassembly_builder.h"
 
+#include <algorithm>
+
 void DisassemblyBuilder::disassemble(std::vector<DisassemblyLine>* lines, uint8_t* memory, int& ptr, offs_t& address, Label* label) {
-    DasmResult result = Disassembler::disassemble(&memory[ptr], address);
+    DasmLine result;
+    Disassembler::disassemble(&memory[ptr], address, result);
     QString opcodes = QString("%1 %2 %3");
     int i = 0;
-    for (; i < result.byteLength; i++) {
+    for (; i < result.length; i++) {
         opcodes = opcodes.arg(memory[ptr + i], 2, 16, QChar('0')).toUpper();
     }
     for (; i < 3; i++) {
         opcodes = opcodes.arg("  ");
     }
-    lines->push_back(DisassemblyLine { address, DisassemblyType::Assembly, opcodes, QString(result.instruction), result.operand, label });
-    ptr += result.byteLength;
-    address += result.byteLength;
+    lines->push_back(DisassemblyLine { address, DisassemblyType::Assembly, opcodes, QString(result.instruction), QString(result.operand), label });
+    ptr += result.length;
+    address += result.length;
 }
 
 void DisassemblyBuilder::build(std::vector<DisassemblyLine>* lines, offs_t start, offs_t end, uint8_t* memory, std::vector<Label>* labels) {
     lines->clear();
-    offs_t address = start;
-    std::vector<Label>::iterator label = labels->begin();
-    bool hasLabels = labels->size() > 0;
+    decode(lines, start, start, end, memory, labels, nullptr, 0);
+}
+
+void DisassemblyBuilder::update(std::vector<DisassemblyLine>* lines, offs_t start, offs_t end, uint8_t* memory, std::vector<Label>* labels, offs_t first, offs_t last) {
+    if (lines->empty() || first > end || last < start) {
+        return;
+    }
+
+    // the last line starting at or before the first changed byte holds it, unless it is inside
+    // a labelled block, which only decodes the same way from the label's start
+    size_t from = std::upper_bound(lines->begin(), lines->end(), first,
+                      [](offs_t address, const DisassemblyLine& line) { return address < line.address; })
+        - lines->begin();
+    if (from > 0) {
+        from--;
+    }
+    while (from > 0 && (*lines)[from].label != nullptr && (*lines)[from].address != (*lines)[from].label->start) {
+        from--;
+    }
+    while (from > 0 && (*lines)[from - 1].address == (*lines)[from].address) {
+        from--;
+    }
+
+    std::vector<DisassemblyLine> decoded;
+    size_t to = decode(&decoded, (*lines)[from].address, start, end, memory, labels, lines, last);
+
+    lines->erase(lines->begin() + from, lines->begin() + to);
+    lines->insert(lines->begin() + from, decoded.begin(), decoded.end());
+}
+
+bool DisassemblyBuilder::isBoundary(const std::vector<DisassemblyLine>* lines, size_t index) {
+    const DisassemblyLine& line = (*lines)[index];
+    if (index > 0 && (*lines)[index - 1].address == line.address) {
+        // the comment above it comes first
+        return false;
+    }
+    return line.label == nullptr || line.address == line.label->start;
+}
+
+size_t DisassemblyBuilder::decode(std::vector<DisassemblyLine>* lines, offs_t address, offs_t start, offs_t end, uint8_t* memory, std::vector<Label>* labels, const std::vector<DisassemblyLine>* old, offs_t last) {
+    std::vector<Label>::iterator label = std::lower_bound(labels->begin(), labels->end(), address,
+        [](const Label& label, offs_t address) { return label.start < address; });
+    bool hasLabels = label != labels->end();
     // QChar filler = QLatin1Char('0');
-    int ptr = 0;
+    int ptr = address - start;
     int i = 0;
     int line_count = 0;
+    size_t next = 0; /* first old line at or after address */
 
     while (address <= end) {
+        if (old != nullptr && address > last) {
+            // past the change, the old lines from the same boundary on are still right
+            while (next < old->size() && (*old)[next].address < address) {
+                next++;
+            }
+            if (next < old->size() && (*old)[next].address == address && isBoundary(old, next)) {
+                return next;
+            }
+        }
+
         if (hasLabels && address > label->start) {
-            while (address > label->start) {
+            while (label != labels->end() && address > label->start) {
                 label++;
             }
+            hasLabels = label != labels->end();
         }
 
         if (hasLabels && address == label->start) {
@@ -82,4 +137,5 @@ void DisassemblyBuilder::build(std::vector<DisassemblyLine>* lines, offs_t start
             disassemble(lines, memory, ptr, address, NULL);
         }
     }
+    return old != nullptr ? old->size() : 0;
 }
@@ -24,12 +24,31 @@ struct DisassemblyLine {
     int bytes;
 };
 
+/*
+    Builds the lines the debugger shows for the memory between start and end, memory being
+    the bytes at start.
+
+    After the bytes between first and last change, update() decodes again only the lines
+    around them: it starts from the instruction (or labelled block) holding first, and stops
+    as soon as it lands, past last, on an address where an old line started at the top level.
+    From there on the old lines are what a full build would give. A change that shifts the
+    instruction boundaries is followed until the two decodings line up again, which on 6800
+    code is usually within a few instructions.
+
+    The lines point into labels, so any change to the labels needs a full build().
+*/
 class DisassemblyBuilder {
 public:
     static void build(std::vector<DisassemblyLine>* lines, offs_t start, offs_t end, uint8_t* memory, std::vector<Label>* labels);
+    static void update(std::vector<DisassemblyLine>* lines, offs_t start, offs_t end, uint8_t* memory, std::vector<Label>* labels, offs_t first, offs_t last);
 
 private:
     static void disassemble(std::vector<DisassemblyLine>* lines, uint8_t* memory, int& ptr, offs_t& address, Label* label);
+    // decodes from address to the end, or with old lines, until old lines can take over after
+    // last; returns the index of that old line
+    static size_t decode(std::vector<DisassemblyLine>* lines, offs_t address, offs_t start, offs_t end, uint8_t* memory, std::vector<Label>* labels, const std::vector<DisassemblyLine>* old, offs_t last);
+    // true if decoding from the line's address gives the line and those after it
+    static bool isBoundary(const std::vector<DisassemblyLine>* lines, size_t index);
 };
 
 #endif // DISASSEMBLY_BUILDER_H
\ No newline at end of file
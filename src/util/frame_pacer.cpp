@@ -0,0 +1,143 @@
+#include "frame_pacer.h"
+#include <math.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#endif // __linux__
+
+static const int64_t NS_PER_SECOND = 1000000000;
+
+FramePacer::FramePacer() {
+    drift = 0;
+    jitter = 0;
+    resyncs = 0;
+    wake = 0;
+    cycleCarry = 0;
+    start();
+}
+
+void FramePacer::start() {
+    epoch = now();
+    frame = 0;
+    windowStart = epoch;
+    windowCount = 0;
+    windowSum = 0;
+    windowSquares = 0;
+}
+
+int FramePacer::nextFrameCycles(long clockHz) {
+    cycleCarry += clockHz;
+    int cycles = (int)(cycleCarry / FRAME_RATE);
+    cycleCarry -= (long)cycles * FRAME_RATE;
+    return cycles;
+}
+
+int64_t FramePacer::waitForFrame() {
+    frame++;
+    int64_t due = deadline(frame);
+    int64_t time = now();
+
+    if (time < due) {
+        sleepUntil(due);
+        time = now();
+        if (time < due) {
+            // interrupted, the caller has something else to do and waits for this frame again
+            frame--;
+            wake = 0;
+            return -1;
+        }
+    } else if (time - due > MAX_CATCH_UP_FRAMES * NS_PER_SECOND / FRAME_RATE) {
+        // too far behind to catch up (host suspended, debugger attached...), drop the lost time
+        epoch = time;
+        frame = 0;
+        due = time;
+        resyncs++;
+    }
+
+    double late = (double)(time - due);
+    windowCount++;
+    windowSum += late;
+    windowSquares += late * late;
+
+    if (time - windowStart >= NS_PER_SECOND) {
+        double mean = windowSum / windowCount;
+        double variance = windowSquares / windowCount - mean * mean;
+        drift = mean / 1000;
+        jitter = variance > 0 ? sqrt(variance) / 1000 : 0;
+        windowStart = time;
+        windowCount = 0;
+        windowSum = 0;
+        windowSquares = 0;
+    }
+    wake = 0;
+    return time - due;
+}
+
+double FramePacer::getDrift() {
+    return drift;
+}
+
+double FramePacer::getJitter() {
+    return jitter;
+}
+
+int FramePacer::getResyncs() {
+    return resyncs;
+}
+
+int64_t FramePacer::deadline(int64_t frame) {
+    // computed from frame 0 each time so rounding never accumulates
+    return epoch + frame * NS_PER_SECOND / FRAME_RATE;
+}
+
+#ifdef __linux__
+
+int64_t FramePacer::now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * NS_PER_SECOND + ts.tv_nsec;
+}
+
+void FramePacer::interrupt() {
+    wake = 1;
+    syscall(SYS_futex, (int*)&wake, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+void FramePacer::sleepUntil(int64_t time) {
+    struct timespec ts;
+    ts.tv_sec = time / NS_PER_SECOND;
+    ts.tv_nsec = time % NS_PER_SECOND;
+    // FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC timeout, returns straight away if
+    // wake is already set
+    while (wake == 0) {
+        if (syscall(SYS_futex, (int*)&wake, FUTEX_WAIT_BITSET_PRIVATE, 0, &ts, NULL, FUTEX_BITSET_MATCH_ANY) == -1 && errno == ETIMEDOUT) {
+            break;
+        }
+    }
+}
+
+#else
+
+int64_t FramePacer::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void FramePacer::interrupt() {
+    std::lock_guard<std::mutex> guard(wakeLock);
+    wake = 1;
+    wakeCondition.notify_one();
+}
+
+void FramePacer::sleepUntil(int64_t time) {
+    std::chrono::steady_clock::time_point deadline(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(time)));
+    std::unique_lock<std::mutex> guard(wakeLock);
+    wakeCondition.wait_until(guard, deadline, [this] { return wake != 0; });
+}
+
+#endif // __linux__
@@ -0,0 +1,77 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <atomic>
+#include <stdint.h>
+
+#ifndef __linux__
+#include <condition_variable>
+#include <mutex>
+#endif // __linux__
+
+/*
+    Paces the emulator thread against absolute frame deadlines on the monotonic clock.
+
+    Frame n is due at start + n / FRAME_RATE seconds, so the time spent emulating a frame
+    doesn't add up into the schedule. The cycles handed out for each frame carry the fraction
+    left over from the previous ones, so over a long run the emulated clock matches the
+    requested rate exactly. After a stall the pacer runs frames back to back until it has
+    caught up, but gives up and starts a new schedule when it is more than MAX_CATCH_UP_FRAMES
+    behind.
+
+    On Linux the wait is a futex wait with an absolute CLOCK_MONOTONIC deadline, which times
+    like clock_nanosleep(TIMER_ABSTIME) but can be cut short by interrupt() from another thread.
+*/
+class FramePacer {
+public:
+    static const int FRAME_RATE = 60;
+    static const int MAX_CATCH_UP_FRAMES = 6;
+
+    FramePacer();
+
+    // starts a new schedule from now, call after pausing or leaving turbo mode
+    void start();
+    // cycles to run in the next frame at the given clock
+    int nextFrameCycles(long clockHz);
+    // sleeps until the current frame is due, then moves on to the next one; returns how late
+    // it woke up in nanoseconds, or -1 when interrupted, in which case the frame stays current
+    int64_t waitForFrame();
+    // can be called from any thread: ends the current wait early, or the next one if the
+    // pacer isn't waiting
+    void interrupt();
+
+    // how far wall time ran ahead of emulated time at each frame, averaged over the last
+    // second, in microseconds
+    double getDrift();
+    // spread (standard deviation) of the wake up times over the last second, in microseconds
+    double getJitter();
+    // number of times the pacer gave up catching up and started a new schedule
+    int getResyncs();
+
+    static int64_t now();
+
+private:
+    int64_t epoch; /* monotonic time of frame 0, in nanoseconds */
+    int64_t frame;
+    long cycleCarry; /* cycles times FRAME_RATE owed from previous frames */
+
+    /* wake up lateness statistics, collected over one second */
+    int64_t windowStart;
+    int windowCount;
+    double windowSum;
+    double windowSquares;
+
+    std::atomic<double> drift;
+    std::atomic<double> jitter;
+    std::atomic<int> resyncs;
+    std::atomic<int> wake; /* set by interrupt(), futex word on Linux */
+#ifndef __linux__
+    std::mutex wakeLock;
+    std::condition_variable wakeCondition;
+#endif // __linux__
+
+    int64_t deadline(int64_t frame);
+    void sleepUntil(int64_t time);
+};
+
+#endif // FRAME_PACER_H
@@ -37,7 +37,7 @@ QString getSettingsPath(bool& success) {
 
 Settings load_settings() {
 
-    Settings settings { false, false };
+    Settings settings { false, false, false };
 
     bool success;
     QString settingsFile = getSettingsPath(success);
@@ -62,6 +62,8 @@ Settings load_settings() {
                     settings.showTips = true;
                 } else if (list1.at(0) == "ShowMemoryView" && list1.at(1) == "true") {
                     settings.showMemoryView = true;
+                } else if (list1.at(0) == "ShowHud" && list1.at(1) == "true") {
+                    settings.showHud = true;
                 }
                 qDebug() << list1;
             }
@@ -102,6 +104,8 @@ void save_settings(Settings* settings) {
         out << "ShowTips=" << (settings->showTips ? "true" : "false");
         out << "\r\n";
         out << "ShowMemoryView=" << (settings->showMemoryView ? "true" : "false");
+        out << "\r\n";
+        out << "ShowHud=" << (settings->showHud ? "true" : "false");
 
         out.flush();
 
@@ -4,6 +4,7 @@
 struct Settings {
     bool showTips;
     bool showMemoryView;
+    bool showHud;
 };
 
 Settings load_settings();
@@ -0,0 +1,55 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+
+/*
+    Fixed size ring buffer for passing items from one producer thread to one consumer thread
+    without locking. Capacity must be a power of two; one slot is kept free to tell a full
+    queue from an empty one.
+*/
+template <typename T, size_t Capacity>
+class SpscQueue {
+public:
+    SpscQueue() {
+        head = 0;
+        tail = 0;
+    }
+
+    // producer side, returns false if the queue is full
+    bool push(const T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t next = (h + 1) & (Capacity - 1);
+        if (next == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        items[h] = item;
+        head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side, returns false if the queue is empty
+    bool pop(T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items[t];
+        tail.store((t + 1) & (Capacity - 1), std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+    }
+
+private:
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    T items[Capacity];
+    std::atomic<size_t> head; /* next slot to write, owned by the producer */
+    std::atomic<size_t> tail; /* next slot to read, owned by the consumer */
+};
+
+#endif // SPSC_QUEUE_H
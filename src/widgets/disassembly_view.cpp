@@ -1,5 +1,6 @@
 #include "disassembly_view.h"
 #include <QDebug>
+#include <algorithm>
 
 DisassemblyView::DisassemblyView(QWidget* parent)
     : QFrame(parent) {
@@ -18,6 +19,12 @@ DisassemblyView::DisassemblyView(QWidget* parent)
     current = -1;
     breakpoint_icon = QPixmap(":/buttons/BreakpointEnable_16x.png");
     lines = new std::vector<DisassemblyLine>;
+    emu_ptr = nullptr;
+    heat = nullptr;
+    heat_total = 0;
+    heat_max = 0;
+    heat_ticks = 0;
+    code_ticks = 0;
 
     m_paintTimer = new QTimer(this);
     m_paintTimer->start(36); // 38ms, or every 1/30th of a second
@@ -40,6 +47,7 @@ DisassemblyView::~DisassemblyView() {
     m_paintTimer->stop();
     delete m_paintTimer;
     delete buffer;
+    delete heat;
     qDebug() << "DisassemblyView view destroy done";
 }
 
@@ -201,6 +209,10 @@ void DisassemblyView::bufferDraw() {
                 painter.drawText(200, y, line[ctr].instruction);
                 painter.setPen(operand_color);
                 painter.drawText(260, y, line[ctr].operand);
+
+                if (heat != nullptr) {
+                    drawHeat(painter, line[ctr].address, y);
+                }
             }
         }
 
@@ -213,6 +225,49 @@ void DisassemblyView::bufferDraw() {
     painter.restore();
 }
 
+void DisassemblyView::drawHeat(QPainter& painter, offs_t address, int y) {
+    uint32_t cycles = heat->get_cycles(address);
+    if (cycles == 0) {
+        return;
+    }
+
+    // the bar is scaled to the hottest address, the text is the share of all cycles
+    int x = width() - HEAT_WIDTH - 5;
+    int bar = (int)((double)cycles / heat_max * HEAT_WIDTH);
+    if (bar < 1) {
+        bar = 1;
+    }
+    int hue = 60 - (int)(60.0 * cycles / heat_max); /* yellow for cool, red for hot */
+
+    painter.save();
+    painter.fillRect(x, y - 12, bar, item_height - 6, QColor::fromHsv(hue, 200, 255));
+    painter.setPen(QColor("#000000"));
+    painter.drawText(x + 2, y, QString("%1%").arg(cycles * 100.0 / heat_total, 5, 'f', 2));
+    painter.restore();
+}
+
+void DisassemblyView::refreshHeat() {
+    if (emu_ptr == nullptr) {
+        return;
+    }
+
+    if (heat == nullptr) {
+        heat = new m6800_profiler;
+    }
+    if (!emu_ptr->get_profile(*heat)) {
+        delete heat;
+        heat = nullptr;
+        return;
+    }
+    heat_total = heat->get_total_cycles();
+    heat_max = heat->get_max_cycles();
+    if (heat_max == 0) {
+        // nothing ran yet, or the profile was cleared
+        delete heat;
+        heat = nullptr;
+    }
+}
+
 void DisassemblyView::resizeEvent(QResizeEvent* event) {
     QSize size = event->size();
     buffer = new QPixmap(size);
@@ -383,9 +438,81 @@ void DisassemblyView::redraw() {
     // emit on_size(max_vscroll);
     // is_memory_set = true;
 
+    // copying the profile waits for the emulator, so only do it every few frames
+    if (emu_ptr != nullptr && emu_ptr->get_profiling() && ++heat_ticks >= HEAT_REFRESH_TICKS) {
+        heat_ticks = 0;
+        refreshHeat();
+    }
+    // so does asking for the written pages
+    if (emu_ptr != nullptr && is_memory_set && isVisible() && ++code_ticks >= CODE_REFRESH_TICKS) {
+        code_ticks = 0;
+        refreshCode();
+    }
+
     this->update();
 }
 
+void DisassemblyView::refreshCode() {
+    emu_ptr->get_written_pages(written);
+
+    int selected_address = selected > -1 && selected < (int)lines->size() ? (int)lines->at(selected).address : -1;
+    int current_address = current > -1 && current < (int)lines->size() ? (int)lines->at(current).address : -1;
+
+    // from the last run of pages down, so the lines before each run keep their index
+    bool changed = false;
+    int first_page = start >> MemoryMapManager::PAGE_SHIFT;
+    int page = end >> MemoryMapManager::PAGE_SHIFT;
+    while (page >= first_page) {
+        if (!written[page]) {
+            page--;
+            continue;
+        }
+        int last_page = page;
+        while (page > first_page && written[page - 1]) {
+            page--;
+        }
+        offs_t first = std::max<offs_t>(page << MemoryMapManager::PAGE_SHIFT, start);
+        offs_t last = std::min<offs_t>((last_page << MemoryMapManager::PAGE_SHIFT) | MemoryMapManager::PAGE_MASK, end);
+        DisassemblyBuilder::update(lines, start, end, memory, emu_ptr->labels->getLabels(), first, last);
+        changed = true;
+        page--;
+    }
+    if (!changed) {
+        return;
+    }
+
+    // selected and current are line numbers, keep them on their addresses
+    if (selected_address >= 0) {
+        selected = findIndex(selected_address);
+    }
+    if (current_address >= 0) {
+        current = findIndex(current_address);
+    }
+    updateScrollRange();
+}
+
+int DisassemblyView::findIndex(offs_t address) {
+    int index = 0;
+    std::vector<DisassemblyLine>::iterator line = lines->begin();
+    while (line != lines->end()) {
+        if (line->address == address) {
+            return index;
+        }
+        index++;
+        line++;
+    }
+    return -1;
+}
+
+void DisassemblyView::updateScrollRange() {
+    int x = lines->size() - visible_items + 1;
+    max_vscroll = x > 0 ? x : 0;
+    if (offset > max_vscroll) {
+        offset = max_vscroll;
+    }
+    emit onSize(max_vscroll);
+}
+
 void DisassemblyView::clearCurrent() {
     current = -1;
 }
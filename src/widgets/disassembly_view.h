@@ -2,6 +2,7 @@
 #define DISASSEMBLYVIEW_H
 
 #include "../common/common_defs.h"
+#include "../cpu/profiler.h"
 #include "../dasm/disassembler.h"
 #include "../dev/memory_map.h"
 #include "../emu/et3400.h"
@@ -46,6 +47,10 @@ public:
     void refresh();
     void addLabel();
     void ensureVisible(offs_t address);
+    // takes a fresh copy of the emulator's profile for the heat column
+    void refreshHeat();
+    // disassembles again the code in RAM pages written since the last look
+    void refreshCode();
 
 signals:
     void onScroll(int steps);
@@ -77,6 +82,18 @@ private:
 
     std::vector<DisassemblyLine>* lines;
 
+    static const int HEAT_REFRESH_TICKS = 14; /* paint timer ticks between profile copies */
+    static const int CODE_REFRESH_TICKS = 8; /* paint timer ticks between looks at written pages */
+    static const int HEAT_WIDTH = 110;
+
+    m6800_profiler* heat; /* last copy of the profile, null until there is one */
+    unsigned long long heat_total;
+    uint32_t heat_max;
+    int heat_ticks;
+
+    std::vector<bool> written; /* RAM pages written, from the emulator */
+    int code_ticks;
+
     bool running;
     bool is_memory_set;
     offs_t start;
@@ -88,8 +105,11 @@ private:
     int current;
 
     DisassemblyLine findLine(offs_t address);
+    int findIndex(offs_t address);
+    void updateScrollRange();
     void addOrRemoveBreakpoint(int line_number);
     void bufferDraw();
+    void drawHeat(QPainter& painter, offs_t address, int y);
     void showContextMenu(const QPoint& pos);
     void adjustSelected(int direction);
 
@@ -1,8 +1,11 @@
 
 #include "display.h"
 
+#include <QGuiApplication>
+#include <QPaintEvent>
 #include <QPainter>
 #include <QPainterPath>
+#include <QScreen>
 
 Display::Display(QWidget* parent)
     : QWidget(parent) {
@@ -17,102 +20,141 @@ Display::Display(QWidget* parent)
     setAutoFillBackground(true);
     running = true;
 
-    // m_paintTimer = new QTimer(this);
-    // m_paintTimer->start(17); // 17ms, or every 1/60th of a second
-    // connect(this->m_paintTimer, SIGNAL(timeout()), this, SLOT(redraw()));
     device = new display_io;
-
-    action = new QAction;
-    connect(action, &QAction::triggered, this, &Display::redraw);
+    read_patterns(patterns);
+    glyph_ratio = 0;
+
+    // polled once per screen refresh, so a display that changes thousands of times a second
+    // in turbo mode still costs at most one repaint per refresh
+    int refresh_ms = 17;
+    QScreen* screen = QGuiApplication::primaryScreen();
+    if (screen != nullptr && screen->refreshRate() >= 1) {
+        refresh_ms = qMax(1, (int)(1000 / screen->refreshRate()));
+    }
+    m_paintTimer = new QTimer(this);
+    m_paintTimer->setTimerType(Qt::PreciseTimer);
+    m_paintTimer->start(refresh_ms);
+    connect(this->m_paintTimer, &QTimer::timeout, this, &Display::redraw);
 
     this->setFixedSize(QSize(320, 85));
 }
 
 Display::~Display() {
-    delete (action);
+    m_paintTimer->stop();
 }
 
-void Display::paintEvent(QPaintEvent* /* event */) {
-    QPainter painter(this);
-    QString letters[] = { "H", "I", "N", "Z", "V", "C" };
-    // Clear display
-    painter.setBrush(QBrush(Qt::black));
+QRect Display::digit_rect(int position) {
+    return QRect(20 + position * 45, 10, 45, 70);
+}
 
-    painter.fillRect(this->rect(), painter.brush());
+void Display::read_patterns(uint8_t* patterns) {
+    uint8_t memory[display_io::SIZE];
+    painted_generation = device->snapshot(memory);
 
-    painter.setPen(Qt::white);
-    // // Clear segment area only
-    // painter.save();
-    // for (int address = 0xC16F; address >= 0xC110; address--)
-    // {
-    //     if ((address & 0x08) != 0x08)
-    //     {
-    //         int position = 6 - ((address & 0xF0) >> 4);
-    //         painter.save();
-    //         painter.translate(20 + position * 45, 10);
-    //         painter.fillRect(QRect(0, 0, 38, 54), painter.brush());
-    //         painter.restore();
-    //     }
-    // }
-    // painter.restore();
-
-    painter.save();
-    for (int address = 0xC16F; address >= 0xC110; address--) {
-        // prevent writing on all addresses, minor performance increase
-        if ((address & 0x08) != 0x08) {
-
-            int position = 6 - ((address & 0xF0) >> 4);
-            int segment = address & 0x7;
-            uint8_t segdata = device->read(address);
-
-            painter.save();
-            painter.translate(20 + position * 45, 10);
-
-            uint8_t state = segdata & 1;
-
-            switch (segment) {
-            case 0:
-                painter.drawPixmap(11, 23, hr[state]);
-                break;
-            case 1:
-                painter.drawPixmap(5, 11, vt[state]);
-                break;
-            case 2:
-                painter.drawPixmap(4, 27, vt[state]);
-                break;
-            case 3:
-                painter.drawPixmap(8, 42, hr[state]);
-                break;
-            case 4:
-                painter.drawPixmap(25, 27, vt[state]);
-                break;
-            case 5:
-                painter.drawPixmap(26, 11, vt[state]);
-                break;
-            case 6:
-                painter.drawPixmap(11, 5, hr[state]);
-                break;
-            case 7:
-                painter.drawPixmap(31, 42, dp[state]);
-                break;
+    // the leftmost digit is at 0xC160, the rightmost at 0xC110
+    for (int position = 0; position < DIGITS; position++) {
+        const uint8_t* segments = &memory[(5 - position) * 0x10];
+        uint8_t pattern = 0;
+        for (int segment = 0; segment < 8; segment++) {
+            pattern |= (segments[segment] & 1) << segment;
+        }
+        patterns[position] = pattern;
+    }
+}
+
+const QPixmap& Display::glyph(int position, uint8_t pattern) {
+    qreal ratio = devicePixelRatioF();
+    if (ratio != glyph_ratio) {
+        // moved to a screen with another scale
+        for (int i = 0; i < DIGITS; i++) {
+            for (int j = 0; j < 256; j++) {
+                glyphs[i][j] = QPixmap();
             }
-            painter.restore();
+        }
+        glyph_ratio = ratio;
+    }
+
+    QPixmap& glyph = glyphs[position][pattern];
+    if (!glyph.isNull()) {
+        return glyph;
+    }
+
+    static const char* letters[] = { "H", "I", "N", "Z", "V", "C" };
+    QSize size = digit_rect(position).size();
+    glyph = QPixmap(size * ratio);
+    glyph.setDevicePixelRatio(ratio);
+    glyph.fill(Qt::black);
+
+    QPainter painter(&glyph);
+    painter.setFont(font());
+    painter.setPen(Qt::white);
+    for (int segment = 7; segment >= 0; segment--) {
+        uint8_t state = (pattern >> segment) & 1;
+
+        switch (segment) {
+        case 0:
+            painter.drawPixmap(11, 23, hr[state]);
+            break;
+        case 1:
+            painter.drawPixmap(5, 11, vt[state]);
+            break;
+        case 2:
+            painter.drawPixmap(4, 27, vt[state]);
+            break;
+        case 3:
+            painter.drawPixmap(8, 42, hr[state]);
+            break;
+        case 4:
+            painter.drawPixmap(25, 27, vt[state]);
+            break;
+        case 5:
+            painter.drawPixmap(26, 11, vt[state]);
+            break;
+        case 6:
+            painter.drawPixmap(11, 5, hr[state]);
+            break;
+        case 7:
+            painter.drawPixmap(31, 42, dp[state]);
+            break;
+        }
+        // drawn over itself once per segment, which is what gives the letter its weight
+        painter.drawText(15, 65, letters[position]);
+    }
+    painter.end();
+
+    return glyph;
+}
+
+void Display::paintEvent(QPaintEvent* event) {
+    QPainter painter(this);
 
-            painter.save();
-            painter.translate(20 + position * 45, 10);
-            painter.drawText(15, 65, letters[position]);
-            painter.restore();
+    // only the digits Qt asked for are drawn, the rest of the widget is background
+    painter.fillRect(event->rect(), Qt::black);
+    for (int position = 0; position < DIGITS; position++) {
+        QRect rect = digit_rect(position);
+        if (event->region().intersects(rect)) {
+            painter.drawPixmap(rect.topLeft(), glyph(position, patterns[position]));
         }
     }
-    painter.restore();
 
     painter.end();
+
+    if (on_paint) {
+        on_paint();
+    }
 }
 
 void Display::redraw() {
-    this->update();
-}
+    if (device->get_generation() == painted_generation) {
+        return;
+    }
 
-void Display::update_display() {
-    action->trigger();
-}
\ No newline at end of file
+    uint8_t changed[DIGITS];
+    read_patterns(changed);
+    for (int position = 0; position < DIGITS; position++) {
+        if (changed[position] != patterns[position]) {
+            patterns[position] = changed[position];
+            update(digit_rect(position));
+        }
+    }
+}
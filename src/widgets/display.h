@@ -4,11 +4,20 @@
 #include <QBrush>
 #include <QPen>
 #include <QPixmap>
+#include <QTimer>
 #include <QWidget>
-// #include <QTimer>
 #include "../dev/display_dev.h"
-#include <QAction>
+#include <functional>
 
+/*
+    Draws the six digits of the trainer's display.
+
+    Each digit is drawn from a pre-composited glyph: its seven segments and decimal point on
+    or off, and the flag letter under it. A glyph is built the first time its position and
+    segment pattern are shown and kept, so a paint is one blit per digit. redraw() compares the
+    new segment patterns with the painted ones and only asks Qt to repaint the digits that
+    changed.
+*/
 class Display : public QWidget {
     Q_OBJECT
 
@@ -16,9 +25,15 @@ public:
     explicit Display(QWidget* parent = nullptr);
     ~Display();
     display_io* device;
-    void update_display();
+    // called on the GUI thread after each repaint
+    std::function<void()> on_paint;
+
+    static const int DIGITS = 6;
+    // where the digit at position (0 is the leftmost) is drawn
+    static QRect digit_rect(int position);
 
 public slots:
+    // repaints if the display memory changed since the last paint
     void redraw();
 
 protected:
@@ -28,9 +43,16 @@ private:
     QPixmap hr[2];
     QPixmap vt[2];
     QPixmap dp[2];
-    QAction* action;
     bool running;
-    // QTimer *m_paintTimer;
+    QTimer* m_paintTimer;
+    uint8_t patterns[DIGITS]; /* segment pattern of each digit, bit 0 = g up to bit 7 = dp */
+    unsigned painted_generation;
+    QPixmap glyphs[DIGITS][256]; /* null until first shown */
+    qreal glyph_ratio; /* device pixel ratio the glyphs were built for */
+
+    // copies the segment patterns out of the device and remembers the generation they came from
+    void read_patterns(uint8_t* patterns);
+    const QPixmap& glyph(int position, uint8_t pattern);
 };
 
 #endif // DISPLAY_H
@@ -52,9 +52,17 @@ QPushButton* Keypad::create_button(QString name, QString icon, keypad_io::Keys k
 }
 
 void Keypad::press_key(keypad_io::Keys key) {
-    device->press_key(key);
+    if (on_press) {
+        on_press(key);
+    } else {
+        device->press_key(key);
+    }
 }
 
 void Keypad::release_key(keypad_io::Keys key) {
-    device->release_key(key);
+    if (on_release) {
+        on_release(key);
+    } else {
+        device->release_key(key);
+    }
 }
@@ -7,6 +7,7 @@
 #include <QPushButton>
 #include <QSize>
 #include <QWidget>
+#include <functional>
 #include <thread>
 
 class Keypad : public QWidget {
@@ -16,6 +17,9 @@ public:
     explicit Keypad(QWidget* parent = nullptr);
     ~Keypad();
     keypad_io* device;
+    // when set, presses go here instead of straight to the device
+    std::function<void(keypad_io::Keys)> on_press;
+    std::function<void(keypad_io::Keys)> on_release;
 
 public slots:
     void press_key(keypad_io::Keys key);
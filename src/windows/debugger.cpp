@@ -35,6 +35,40 @@ void DebuggerDialog::step(bool checked) {
     }
 }
 
+void DebuggerDialog::step_back(bool checked) {
+    if (emu_ptr->step_back()) {
+        after_rewind();
+    }
+}
+
+void DebuggerDialog::rewind_to_cycle(bool checked) {
+    emu_ptr->halt();
+    unsigned long long oldest = emu_ptr->get_rewind_oldest();
+    unsigned long long current = emu_ptr->total_cycles;
+
+    bool ok;
+    QString text = QInputDialog::getText(this, "Rewind to Cycle",
+                                         QString("Cycle (%1 - %2):").arg(oldest).arg(current),
+                                         QLineEdit::Normal, QString::number(current), &ok);
+    if (!ok) {
+        update_button_state();
+        return;
+    }
+
+    unsigned long long cycle = text.trimmed().toULongLong(&ok);
+    if (!ok || !emu_ptr->rewind_to(cycle)) {
+        QMessageBox::warning(this, "Rewind to Cycle", QString("Cannot rewind to cycle %1, the recorded cycles are %2 - %3.").arg(text.trimmed()).arg(oldest).arg(current));
+    }
+    after_rewind();
+}
+
+void DebuggerDialog::after_rewind() {
+    pauseAndUpdateDisassembler();
+    update_button_state();
+    disassembly_scrollbar->setValue(disassembly_view->offset);
+    memory_view->redraw();
+}
+
 void DebuggerDialog::refresh() {
     disassembly_view->refresh();
     memory_view->redraw();
@@ -143,8 +177,8 @@ void DebuggerDialog::set_emulator(et3400emu* emu) {
     if (!emu_set) {
         emu_ptr = emu;
         emu_ptr->on_breakpoint = [this] {
-            // We cannot update UI items from another thread, so we trigger a QAction breakpoint_handler_action call breakpoint_handler asynchronously
-            breakpoint_handler_action->trigger();
+            // called on the emulation thread, the UI is updated from the event loop of this dialog's thread
+            QMetaObject::invokeMethod(this, [this] { breakpoint_handler(false); }, Qt::QueuedConnection);
         };
         emu_set = true;
         memory_view->set_emulator(emu);
@@ -341,6 +375,73 @@ void DebuggerDialog::save_labels() {
     emu_ptr->labels->saveLabels(fileName, 0x1400, 0x1BFF, success);
 }
 
+void DebuggerDialog::toggle_profiling(bool checked) {
+    emu_ptr->set_profiling(checked);
+    disassembly_view->refreshHeat();
+}
+
+void DebuggerDialog::clear_profile(bool checked) {
+    emu_ptr->clear_profile();
+    disassembly_view->refreshHeat();
+}
+
+void DebuggerDialog::save_profile(bool checked) {
+    QString fileName = QFileDialog::getSaveFileName(this,
+        "Save Profile", "", "CSV Files (*.csv)");
+
+    if (fileName == nullptr)
+        return;
+
+    if (!emu_ptr->save_profile(fileName)) {
+        QMessageBox::warning(this, "Save Profile", "Nothing has been profiled yet, or " + fileName + " can't be written");
+    }
+}
+
+void DebuggerDialog::save_function_profile(bool checked) {
+    QString fileName = QFileDialog::getSaveFileName(this,
+        "Save Function Profile", "", "CSV Files (*.csv)");
+
+    if (fileName == nullptr)
+        return;
+
+    if (!emu_ptr->save_function_profile(fileName)) {
+        QMessageBox::warning(this, "Save Function Profile", "Nothing has been profiled yet, or " + fileName + " can't be written");
+    }
+}
+
+void DebuggerDialog::save_folded_stacks(bool checked) {
+    QString fileName = QFileDialog::getSaveFileName(this,
+        "Save Folded Stacks", "", "Folded Stacks (*.folded)");
+
+    if (fileName == nullptr)
+        return;
+
+    if (!emu_ptr->save_folded_stacks(fileName)) {
+        QMessageBox::warning(this, "Save Folded Stacks", "Nothing has been profiled yet, or " + fileName + " can't be written");
+    }
+}
+
+void DebuggerDialog::start_trace() {
+    QString fileName = QFileDialog::getSaveFileName(this,
+        "Start Trace", "", "Trace Files (*.trace)");
+
+    if (fileName == nullptr)
+        return;
+
+    if (!emu_ptr->start_trace(fileName)) {
+        QMessageBox::warning(this, "Start Trace", "Cannot write " + fileName);
+        return;
+    }
+    start_trace_action->setEnabled(false);
+    stop_trace_action->setEnabled(true);
+}
+
+void DebuggerDialog::stop_trace() {
+    emu_ptr->stop_trace();
+    start_trace_action->setEnabled(true);
+    stop_trace_action->setEnabled(false);
+}
+
 void DebuggerDialog::after_load_ram() {
     refresh();
     update_button_state();
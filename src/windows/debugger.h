@@ -33,9 +33,11 @@
 #include <QDialog>
 #include <QGridLayout>
 #include <QGroupBox>
+#include <QInputDialog>
 #include <QKeyEvent>
 #include <QLabel>
 #include <QMenu>
+#include <QMessageBox>
 #include <QObject>
 #include <QScrollBar>
 #include <QSizeGrip>
@@ -82,6 +84,17 @@ private:
     QAction* toggle_disassembly_action;
     QAction* toggle_status_action;
 
+    QToolButton* rewind_selector;
+    QAction* step_back_action;
+    QAction* rewind_to_action;
+
+    QToolButton* profile_selector;
+    QAction* profile_action;
+    QAction* clear_profile_action;
+    QAction* save_profile_action;
+    QAction* save_function_profile_action;
+    QAction* save_folded_stacks_action;
+
     QToolButton* labels_selector;
     QAction* add_label_action;
     QAction* goto_label_action;
@@ -92,7 +105,8 @@ private:
     QScrollBar* disassembly_scrollbar;
     QGroupBox* status_groupBox;
 
-    QAction* breakpoint_handler_action;
+    QAction* start_trace_action;
+    QAction* stop_trace_action;
 
     MemoryView* memory_view;
     DisassemblyView* disassembly_view;
@@ -109,6 +123,14 @@ private:
     void stop(bool checked);
     void step(bool checked);
     void reset(bool checked);
+    void step_back(bool checked);
+    void rewind_to_cycle(bool checked);
+    void after_rewind();
+    void toggle_profiling(bool checked);
+    void clear_profile(bool checked);
+    void save_profile(bool checked);
+    void save_function_profile(bool checked);
+    void save_folded_stacks(bool checked);
 
     void setupUI();
     void update_memory_scrollbar(int value);
@@ -146,6 +168,8 @@ private:
     void save_breakpoints();
     void load_labels();
     void save_labels();
+    void start_trace();
+    void stop_trace();
 };
 
 #endif // DEBUGGER_H
\ No newline at end of file
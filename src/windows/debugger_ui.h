@@ -33,6 +33,42 @@ void DebuggerDialog::setupUI() {
     MakeButton(step_button, "Step in (F10)", ":/buttons/StepIntoArrow_16x.png", Qt::Key_F10, step);
     MakeButton(reset_button, "Reset (ESC)", ":/buttons/Restart_16x.png", Qt::Key_Escape, reset);
 
+    rewind_selector = new QToolButton(toolbar);
+    rewind_selector->setToolButtonStyle(Qt::ToolButtonTextOnly);
+    rewind_selector->setText("Rewind   ");
+    rewind_selector->setPopupMode(QToolButton::ToolButtonPopupMode::InstantPopup);
+
+    MakeTriggeredAction(step_back_action, "Step Back", Qt::SHIFT + Qt::Key_F10, step_back);
+    MakeTriggeredAction(rewind_to_action, "Rewind to Cycle...", Qt::CTRL + Qt::Key_R, rewind_to_cycle);
+
+    QMenu* rewind_selector_menu = new QMenu(rewind_selector);
+    rewind_selector_menu->addAction(step_back_action);
+    rewind_selector_menu->addAction(rewind_to_action);
+    rewind_selector->setMenu(rewind_selector_menu);
+
+    profile_selector = new QToolButton(toolbar);
+    profile_selector->setToolButtonStyle(Qt::ToolButtonTextOnly);
+    profile_selector->setText("Profile   ");
+    profile_selector->setPopupMode(QToolButton::ToolButtonPopupMode::InstantPopup);
+
+    profile_action = new QAction("Profile", this);
+    profile_action->setCheckable(true);
+    profile_action->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_P));
+    connect(profile_action, &QAction::toggled, this, &DebuggerDialog::toggle_profiling);
+
+    MakeTriggeredAction(clear_profile_action, "Clear Profile", 0, clear_profile);
+    MakeTriggeredAction(save_profile_action, "Save Profile...", 0, save_profile);
+    MakeTriggeredAction(save_function_profile_action, "Save Function Profile...", 0, save_function_profile);
+    MakeTriggeredAction(save_folded_stacks_action, "Save Folded Stacks...", 0, save_folded_stacks);
+
+    QMenu* profile_selector_menu = new QMenu(profile_selector);
+    profile_selector_menu->addAction(profile_action);
+    profile_selector_menu->addAction(clear_profile_action);
+    profile_selector_menu->addAction(save_profile_action);
+    profile_selector_menu->addAction(save_function_profile_action);
+    profile_selector_menu->addAction(save_folded_stacks_action);
+    profile_selector->setMenu(profile_selector_menu);
+
     panel_selector = new QToolButton(toolbar);
     panel_selector->setToolButtonStyle(Qt::ToolButtonTextOnly);
     panel_selector->setText("Panels   ");
@@ -61,6 +97,10 @@ void DebuggerDialog::setupUI() {
     QAction* openMap_action = new QAction("Load Labels (RAM)", this);
     QAction* saveMap_action = new QAction("Save Labels (RAM)", this);
 
+    start_trace_action = new QAction("Start Trace...", this);
+    stop_trace_action = new QAction("Stop Trace", this);
+    stop_trace_action->setEnabled(false);
+
     QToolButton* file_button = new QToolButton(toolbar);
     file_button->setToolButtonStyle(Qt::ToolButtonTextOnly);
     file_button->setText("File   ");
@@ -74,6 +114,9 @@ void DebuggerDialog::setupUI() {
     file_menu->addAction(saveBrk_action);
     file_menu->addAction(openMap_action);
     file_menu->addAction(saveMap_action);
+    file_menu->addSeparator();
+    file_menu->addAction(start_trace_action);
+    file_menu->addAction(stop_trace_action);
     file_button->setMenu(file_menu);
 
     connect(openRam_action, &QAction::triggered, this, &DebuggerDialog::load_ram);
@@ -82,6 +125,8 @@ void DebuggerDialog::setupUI() {
     connect(saveBrk_action, &QAction::triggered, this, &DebuggerDialog::save_breakpoints);
     connect(openMap_action, &QAction::triggered, this, &DebuggerDialog::load_labels);
     connect(saveMap_action, &QAction::triggered, this, &DebuggerDialog::save_labels);
+    connect(start_trace_action, &QAction::triggered, this, &DebuggerDialog::start_trace);
+    connect(stop_trace_action, &QAction::triggered, this, &DebuggerDialog::stop_trace);
 
     toolbar->addWidget(file_button);
     toolbar->addSeparator();
@@ -89,6 +134,8 @@ void DebuggerDialog::setupUI() {
     toolbar->addWidget(stop_button);
     toolbar->addWidget(step_button);
     toolbar->addWidget(reset_button);
+    toolbar->addWidget(rewind_selector);
+    toolbar->addWidget(profile_selector);
     toolbar->addSeparator();
     toolbar->addWidget(panel_selector);
     toolbar->addWidget(labels_selector);
@@ -189,9 +236,6 @@ void DebuggerDialog::setupUI() {
     connect(disassembly_view, &DisassemblyView::onRemoveBreakpoint, this, &DebuggerDialog::remove_breakpoint);
     connect(disassembly_view, &DisassemblyView::onAddorRemoveBreakpoint, this, &DebuggerDialog::add_or_remove_breakpoint);
 
-    breakpoint_handler_action = new QAction;
-    connect(breakpoint_handler_action, &QAction::triggered, this, &DebuggerDialog::breakpoint_handler);
-
     resize(QSize(985, 721));
 
     // setFixedSize(QSize(985, 721));
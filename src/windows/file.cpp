@@ -82,4 +82,29 @@ void File::save_ram(QWidget* parent, et3400emu* emu_ptr) {
 
     // resume emulation
     emu_ptr->start();
-}
\ No newline at end of file
+}
+void File::save_recording(QWidget* parent, et3400emu* emu_ptr) {
+    QString fileName = QFileDialog::getSaveFileName(parent,
+        "Save Recording", "", "ET-3400 Recordings (*.etr)");
+
+    if (fileName == nullptr)
+        return;
+
+    // the recording runs up to the moment it is saved, the emulation keeps going
+    if (!emu_ptr->save_recording(fileName)) {
+        QMessageBox::warning(parent, "Save Recording", "Cannot write " + fileName);
+    }
+}
+
+void File::replay(QWidget* parent, et3400emu* emu_ptr) {
+    QString fileName = QFileDialog::getOpenFileName(parent,
+        "Replay Recording", "", "ET-3400 Recordings (*.etr)");
+
+    if (fileName == nullptr)
+        return;
+
+    // plays back in turbo mode and pauses where the recording ended
+    if (!emu_ptr->replay(fileName)) {
+        QMessageBox::warning(parent, "Replay Recording", fileName + " is not a recording made with these ROMs");
+    }
+}
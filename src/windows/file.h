@@ -3,6 +3,7 @@
 
 #include "../emu/et3400.h"
 #include <QFileDialog>
+#include <QMessageBox>
 #include <QObject>
 #include <QString>
 #include <vector>
@@ -11,6 +12,8 @@ class File {
 public:
     static void load_ram(QWidget* parent, et3400emu* emu_ptr);
     static void save_ram(QWidget* parent, et3400emu* emu_ptr);
+    static void save_recording(QWidget* parent, et3400emu* emu_ptr);
+    static void replay(QWidget* parent, et3400emu* emu_ptr);
 };
 
 #endif // FILE_H
\ No newline at end of file
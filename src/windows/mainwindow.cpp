@@ -15,6 +15,9 @@ MainWindow::MainWindow(QWidget* parent)
     QAction* settings_action = new QAction("&Settings", this);
     QAction* about_action = new QAction("&About", this);
     QAction* tips_action = new QAction("Show &Tips", this);
+    QAction* hud_action = new QAction("Performance &HUD", this);
+    hud_action->setCheckable(true);
+    hud_action->setChecked(settings.showHud);
 
     QAction* openRam_action = new QAction("&Load RAM", this);
     openRam_action->setShortcut(Qt::CTRL + Qt::Key_O);
@@ -22,6 +25,10 @@ MainWindow::MainWindow(QWidget* parent)
     QAction* saveRam_action = new QAction("&Save RAM", this);
     saveRam_action->setShortcut(Qt::CTRL + Qt::Key_S);
 
+    QAction* startRecording_action = new QAction("Start &Recording", this);
+    QAction* saveRecording_action = new QAction("Save Recording...", this);
+    QAction* replay_action = new QAction("Re&play Recording...", this);
+
     QAction* quit_action = new QAction("E&xit", this);
     quit_action->setShortcut(Qt::CTRL + Qt::Key_X);
 
@@ -30,6 +37,10 @@ MainWindow::MainWindow(QWidget* parent)
     file->addAction(openRam_action);
     file->addAction(saveRam_action);
     file->addSeparator();
+    file->addAction(startRecording_action);
+    file->addAction(saveRecording_action);
+    file->addAction(replay_action);
+    file->addSeparator();
     file->addAction(quit_action);
 
     menuBar()->addAction(debugger_action);
@@ -37,6 +48,7 @@ MainWindow::MainWindow(QWidget* parent)
     QMenu* config_menu;
     config_menu = menuBar()->addMenu("&Config");
     config_menu->addAction(settings_action);
+    config_menu->addAction(hud_action);
 
     QMenu* help_menu;
     help_menu = menuBar()->addMenu("&Help");
@@ -48,12 +60,16 @@ MainWindow::MainWindow(QWidget* parent)
 
     connect(openRam_action, &QAction::triggered, this, &MainWindow::load_ram);
     connect(saveRam_action, &QAction::triggered, this, &MainWindow::save_ram);
+    connect(startRecording_action, &QAction::triggered, this, &MainWindow::start_recording);
+    connect(saveRecording_action, &QAction::triggered, this, &MainWindow::save_recording);
+    connect(replay_action, &QAction::triggered, this, &MainWindow::replay);
     connect(quit_action, &QAction::triggered, qApp, QApplication::quit);
 
     connect(debugger_action, &QAction::triggered, this, &MainWindow::show_debugger);
     connect(settings_action, &QAction::triggered, this, &MainWindow::show_settings);
     connect(about_action, &QAction::triggered, this, &MainWindow::show_about);
     connect(tips_action, &QAction::triggered, this, &MainWindow::show_tips);
+    connect(hud_action, &QAction::toggled, this, &MainWindow::show_hud);
 
     // Layout
     QGridLayout* mainLayout = new QGridLayout;
@@ -70,23 +86,27 @@ MainWindow::MainWindow(QWidget* parent)
 
     setCentralWidget(central);
 
+    // drawn over the free corner left of the keypad, outside the layout
+    hud = new QLabel(central);
+    hud->setStyleSheet("QLabel { font-family: monospace; font-size: 10px; color: white; background-color: rgba(0, 0, 0, 160); padding: 4px }");
+    hud->setAttribute(Qt::WA_TransparentForMouseEvents);
+    hud->hide();
+
     setWindowTitle(tr("ET-3400 Emulator"));
 
     setFixedSize(QSize(350, 500));
 
     execute_emu();
 
-    last_cycles = 0;
-
     // setAttribute(Qt::WA_DeleteOnClose);
     // connect( widget, SIGNAL(destroyed(QObject*)), this, SLOT(widgetDestroyed(QObject*)) );
     if (settings.showTips) {
         show_tips();
     }
 
-    QTimer* timer = new QTimer(this);
-    connect(timer, &QTimer::timeout, this, QOverload<>::of(&MainWindow::fps));
-    timer->start(1000);
+    hud_timer = new QTimer(this);
+    connect(hud_timer, &QTimer::timeout, this, &MainWindow::update_hud);
+    show_hud(settings.showHud);
 }
 
 void MainWindow::show_tips() {
@@ -95,17 +115,44 @@ void MainWindow::show_tips() {
     tips->show();
 }
 
-void MainWindow::fps() {
-    int cps = 0;
-    if (last_cycles == 0) {
-        cps = emu->total_cycles;
+void MainWindow::show_hud(bool show) {
+    if (show) {
+        update_hud();
+        hud->show();
+        hud->raise();
+        hud_timer->start(HUD_INTERVAL_MS);
     } else {
-        cps = emu->total_cycles - last_cycles;
+        hud_timer->stop();
+        hud->hide();
+    }
+    if (settings.showHud != show) {
+        settings.showHud = show;
+        save_settings(&settings);
     }
+}
 
-    std::cout << cps << std::endl;
+void MainWindow::update_hud() {
+    TelemetrySnapshot t;
+    emu->get_telemetry(t);
+
+    QString text;
+    text += QString::asprintf("%7.3f MHz %7.3f MIPS\n", t.emulated_mhz, t.mips);
+    text += QString::asprintf("slice %6.0f us max %6.0f\n", t.slice_us, t.slice_max_us);
+    text += QString::asprintf("host  %6.1f %%\n", t.host_load * 100);
+    text += QString::asprintf("late  %6.0f us max %6.0f\n", t.overshoot_us, t.overshoot_max_us);
+    text += QString::asprintf("drift %6.0f us jit %6.0f\n", t.drift_us, t.jitter_us);
+    text += QString::asprintf("paint %6.1f Hz\n", t.repaint_hz);
+    text += QString::asprintf("idle  %6llu Mcyc\n", t.idle_cycles / 1000000);
+    // frame wake up lateness, one column per bucket of Telemetry::JITTER_BOUNDS_US
+    text += "wake ";
+    for (int i = 0; i < TelemetrySnapshot::JITTER_BUCKETS; i++) {
+        text += QString::asprintf(" %llu", t.jitter[i]);
+    }
+    hud->setText(text);
+    hud->adjustSize();
 
-    last_cycles = emu->total_cycles;
+    QWidget* parent = hud->parentWidget();
+    hud->move(8, parent->height() - hud->height() - 8);
 }
 
 void MainWindow::show_debugger() {
@@ -132,10 +179,17 @@ void MainWindow::save_ram() {
     File::save_ram(this, emu);
 }
 
-void MainWindow::updatecps() {
-    int cps = emu->get_cycles() - last_cycles;
-    last_cycles = emu->get_cycles();
-    cout << cps << endl;
+void MainWindow::start_recording() {
+    emu->start_recording();
+}
+
+void MainWindow::save_recording() {
+    File::save_recording(this, emu);
+}
+
+void MainWindow::replay() {
+    File::replay(this, emu);
+    debugger_dialog->after_load_ram();
 }
 
 void MainWindow::closeEvent(QCloseEvent* event) {
@@ -156,55 +210,55 @@ MainWindow::~MainWindow() {
 void MainWindow::keyPressEvent(QKeyEvent* ev) {
     switch (ev->key()) {
     case Qt::Key_0:
-        emu->keypad->press_key(keypad_io::Key0);
+        emu->press_key(keypad_io::Key0);
         break;
     case Qt::Key_1:
-        emu->keypad->press_key(keypad_io::Key1);
+        emu->press_key(keypad_io::Key1);
         break;
     case Qt::Key_2:
-        emu->keypad->press_key(keypad_io::Key2);
+        emu->press_key(keypad_io::Key2);
         break;
     case Qt::Key_3:
-        emu->keypad->press_key(keypad_io::Key3);
+        emu->press_key(keypad_io::Key3);
         break;
     case Qt::Key_4:
-        emu->keypad->press_key(keypad_io::Key4);
+        emu->press_key(keypad_io::Key4);
         break;
     case Qt::Key_5:
-        emu->keypad->press_key(keypad_io::Key5);
+        emu->press_key(keypad_io::Key5);
         break;
     case Qt::Key_6:
-        emu->keypad->press_key(keypad_io::Key6);
+        emu->press_key(keypad_io::Key6);
         break;
     case Qt::Key_7:
-        emu->keypad->press_key(keypad_io::Key7);
+        emu->press_key(keypad_io::Key7);
         break;
     case Qt::Key_8:
-        emu->keypad->press_key(keypad_io::Key8);
+        emu->press_key(keypad_io::Key8);
         break;
     case Qt::Key_9:
-        emu->keypad->press_key(keypad_io::Key9);
+        emu->press_key(keypad_io::Key9);
         break;
     case Qt::Key_A:
-        emu->keypad->press_key(keypad_io::KeyA);
+        emu->press_key(keypad_io::KeyA);
         break;
     case Qt::Key_B:
-        emu->keypad->press_key(keypad_io::KeyB);
+        emu->press_key(keypad_io::KeyB);
         break;
     case Qt::Key_C:
-        emu->keypad->press_key(keypad_io::KeyC);
+        emu->press_key(keypad_io::KeyC);
         break;
     case Qt::Key_D:
-        emu->keypad->press_key(keypad_io::KeyD);
+        emu->press_key(keypad_io::KeyD);
         break;
     case Qt::Key_E:
-        emu->keypad->press_key(keypad_io::KeyE);
+        emu->press_key(keypad_io::KeyE);
         break;
     case Qt::Key_F:
-        emu->keypad->press_key(keypad_io::KeyF);
+        emu->press_key(keypad_io::KeyF);
         break;
     case Qt::Key_Escape:
-        emu->keypad->press_key(keypad_io::KeyReset);
+        emu->press_key(keypad_io::KeyReset);
         break;
     }
 }
@@ -212,55 +266,55 @@ void MainWindow::keyPressEvent(QKeyEvent* ev) {
 void MainWindow::keyReleaseEvent(QKeyEvent* ev) {
     switch (ev->key()) {
     case Qt::Key_0:
-        emu->keypad->release_key(keypad_io::Key0);
+        emu->release_key(keypad_io::Key0);
         break;
     case Qt::Key_1:
-        emu->keypad->release_key(keypad_io::Key1);
+        emu->release_key(keypad_io::Key1);
         break;
     case Qt::Key_2:
-        emu->keypad->release_key(keypad_io::Key2);
+        emu->release_key(keypad_io::Key2);
         break;
     case Qt::Key_3:
-        emu->keypad->release_key(keypad_io::Key3);
+        emu->release_key(keypad_io::Key3);
         break;
     case Qt::Key_4:
-        emu->keypad->release_key(keypad_io::Key4);
+        emu->release_key(keypad_io::Key4);
         break;
     case Qt::Key_5:
-        emu->keypad->release_key(keypad_io::Key5);
+        emu->release_key(keypad_io::Key5);
         break;
     case Qt::Key_6:
-        emu->keypad->release_key(keypad_io::Key6);
+        emu->release_key(keypad_io::Key6);
         break;
     case Qt::Key_7:
-        emu->keypad->release_key(keypad_io::Key7);
+        emu->release_key(keypad_io::Key7);
         break;
     case Qt::Key_8:
-        emu->keypad->release_key(keypad_io::Key8);
+        emu->release_key(keypad_io::Key8);
         break;
     case Qt::Key_9:
-        emu->keypad->release_key(keypad_io::Key9);
+        emu->release_key(keypad_io::Key9);
         break;
     case Qt::Key_A:
-        emu->keypad->release_key(keypad_io::KeyA);
+        emu->release_key(keypad_io::KeyA);
         break;
     case Qt::Key_B:
-        emu->keypad->release_key(keypad_io::KeyB);
+        emu->release_key(keypad_io::KeyB);
         break;
     case Qt::Key_C:
-        emu->keypad->release_key(keypad_io::KeyC);
+        emu->release_key(keypad_io::KeyC);
         break;
     case Qt::Key_D:
-        emu->keypad->release_key(keypad_io::KeyD);
+        emu->release_key(keypad_io::KeyD);
         break;
     case Qt::Key_E:
-        emu->keypad->release_key(keypad_io::KeyE);
+        emu->release_key(keypad_io::KeyE);
         break;
     case Qt::Key_F:
-        emu->keypad->release_key(keypad_io::KeyF);
+        emu->release_key(keypad_io::KeyF);
         break;
     case Qt::Key_Escape:
-        emu->keypad->release_key(keypad_io::KeyReset);
+        emu->release_key(keypad_io::KeyReset);
         break;
     }
 }
@@ -279,7 +333,10 @@ void MainWindow::execute_emu() {
     debugger_dialog->set_settings(&settings);
 
     keypad->device->on_reset_press = [this] { emu->reset(); };
-    emu->on_render_frame = [this] { display->update_display(); };
+    // the buttons go through the emulator so presses are journaled
+    keypad->on_press = [this](keypad_io::Keys key) { emu->press_key(key); };
+    keypad->on_release = [this](keypad_io::Keys key) { emu->release_key(key); };
+    display->on_paint = [this] { emu->count_repaint(); };
 
     emu->init();
     emu->start();
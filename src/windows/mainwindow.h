@@ -18,6 +18,7 @@
 #include <QApplication>
 #include <QCloseEvent>
 #include <QFile>
+#include <QLabel>
 #include <QMainWindow>
 #include <QMenu>
 #include <QMenuBar>
@@ -32,6 +33,8 @@ class MainWindow : public QMainWindow {
     const uint16_t FANTOMII_ADDR = 0x1400;
     const uint16_t TINYBASIC_ADDR = 0x1C00;
 
+    const int HUD_INTERVAL_MS = 500;
+
 public:
     MainWindow(QWidget* parent = 0);
     ~MainWindow();
@@ -42,22 +45,26 @@ public:
     void execute_emu();
 
 private:
-    long long last_cycles;
     Settings settings;
     Display* display;
     Keypad* keypad;
     SettingsDialog* settings_dialog;
     DebuggerDialog* debugger_dialog;
     et3400emu* emu;
+    QLabel* hud;
+    QTimer* hud_timer;
 
     void load_ram();
     void save_ram();
+    void start_recording();
+    void save_recording();
+    void replay();
     void show_about();
     void show_settings();
     void show_debugger();
     void show_tips();
-    void updatecps();
-    void fps();
+    void show_hud(bool show);
+    void update_hud();
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
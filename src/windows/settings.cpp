@@ -1,6 +1,7 @@
 #include "settings.h"
 
 SettingsDialog::SettingsDialog() {
+    emu_ptr = nullptr;
 }
 
 SettingsDialog::SettingsDialog(QWidget* parent)
@@ -9,7 +10,9 @@ SettingsDialog::SettingsDialog(QWidget* parent)
     setFixedSize(QSize(350, 250));
     setWindowTitle("Settings");
 
-    QPushButton* reset_button = new QPushButton("Reset Clock", this);
+    emu_ptr = nullptr;
+
+    reset_button = new QPushButton("Reset Clock", this);
     reset_button->setGeometry(250, 15, 80, 30);
 
     clock_rate_label = new QLabel("Clock Rate", this);
@@ -33,8 +36,20 @@ SettingsDialog::SettingsDialog(QWidget* parent)
     slider->setMinimum(1);
     slider->setMaximum(400);
 
+    turbo_checkbox = new QCheckBox("Turbo (run as fast as possible)", this);
+    turbo_checkbox->setGeometry(10, 95, 320, 25);
+
+    speed_label = new QLabel(this);
+    speed_label->setStyleSheet("font-size:12px;");
+    speed_label->setGeometry(10, 120, 320, 25);
+
+    speed_timer = new QTimer(this);
+
     connect(slider, &QSlider::valueChanged, this, &SettingsDialog::setClockRate);
     connect(reset_button, &QPushButton::clicked, this, [this] { slider->setValue(100); });
+    connect(turbo_checkbox, &QCheckBox::toggled, this, &SettingsDialog::setTurbo);
+    connect(speed_timer, &QTimer::timeout, this, &SettingsDialog::updateSpeed);
+    speed_timer->start(500);
 
     // addWidget(clock_rate_label);
     // addWidget(warning_label);
@@ -64,6 +79,31 @@ void SettingsDialog::setClockRate(int clock_rate) {
     emu_ptr->set_clock_rate(clock_rate);
 }
 
+void SettingsDialog::setTurbo(bool enabled) {
+    // the clock rate doesn't apply while running flat out
+    slider->setEnabled(!enabled);
+    reset_button->setEnabled(!enabled);
+
+    emu_ptr->set_turbo(enabled);
+}
+
+void SettingsDialog::updateSpeed() {
+    if (emu_ptr == nullptr || !isVisible()) {
+        return;
+    }
+    double mhz = emu_ptr->get_emulated_mhz();
+    if (mhz > 0 && emu_ptr->get_turbo()) {
+        speed_label->setText(QString("Emulated speed: %1 MHz").arg(mhz, 0, 'f', 2));
+    } else if (mhz > 0) {
+        speed_label->setText(QString("Emulated speed: %1 MHz (drift %2 us, jitter %3 us)")
+                                 .arg(mhz, 0, 'f', 3)
+                                 .arg(emu_ptr->get_pacing_drift(), 0, 'f', 0)
+                                 .arg(emu_ptr->get_pacing_jitter(), 0, 'f', 0));
+    } else {
+        speed_label->setText("Emulated speed: stopped");
+    }
+}
+
 void SettingsDialog::set_emulator(et3400emu* emu) {
     emu_ptr = emu;
     int clock_rate = emu_ptr->get_clock_rate();
@@ -73,4 +113,6 @@ void SettingsDialog::set_emulator(et3400emu* emu) {
     } else {
         warning_label->hide();
     }
+    turbo_checkbox->setChecked(emu_ptr->get_turbo());
+    updateSpeed();
 }
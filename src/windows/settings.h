@@ -2,12 +2,14 @@
 #define SETTINGS_H
 
 #include "../emu/et3400.h"
+#include <QCheckBox>
 #include <QDialog>
 #include <QGridLayout>
 #include <QLabel>
 #include <QPushButton>
 #include <QSlider>
 #include <QString>
+#include <QTimer>
 #include <QVBoxLayout>
 #include <QWidget>
 
@@ -33,11 +35,17 @@ signals:
 
 public slots:
     void setClockRate(int value);
+    void setTurbo(bool enabled);
+    void updateSpeed();
 
 private:
     QSlider* slider;
+    QPushButton* reset_button;
+    QCheckBox* turbo_checkbox;
     QLabel* clock_rate_label;
+    QLabel* speed_label;
     QLabel* warning_label;
+    QTimer* speed_timer;
     et3400emu* emu_ptr;
 };
 
@@ -0,0 +1,664 @@
+/*
+    Runs the same programs through every dispatch loop of m6800_cpu_device in lockstep
+
+    Each scenario builds one machine per loop: the opcode function pointer table, the switch,
+    computed goto, predecoded blocks with and without delay loop skipping, translated code
+    when built with the JIT, and the instrumented loop with both profilers attached. All of
+    them get the same slices and key presses. After every slice the CPU registers, cycle count,
+    retired instruction count, RAM and display of each machine are hashed and compared with
+    the table loop's, and the first difference fails the test. At the end of each scenario the
+    profiler must account for every instruction run and, unless the CPU went into WAI, every
+    cycle, and the call profiler must have charged the same cycles to its routines.
+
+    --write FILE saves a hash of each scenario and --compare FILE checks them, so a build with
+    other options (lazy condition codes) can be held against the default build.
+*/
+
+#include "../src/cpu/call_profiler.h"
+#include "../src/cpu/jit_x64.h"
+#include "../src/cpu/m6800.h"
+#include "../src/cpu/profiler.h"
+#include "../src/dev/devices.h"
+#include "../src/util/srec.h"
+
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifndef ET3400_ROM_DIR
+#define ET3400_ROM_DIR "src/resources/rom"
+#endif
+
+#ifndef ET3400_SAMPLES_DIR
+#define ET3400_SAMPLES_DIR "samples"
+#endif
+
+static const int CYCLES_PER_SLICE = 16667;
+static const int RAM_SIZE = 0x0800;
+static const int DISPLAY_SIZE = 96;
+
+typedef void (m6800_cpu_device::*run_func)();
+
+struct Loop {
+    const char* name;
+    run_func func;
+    bool delay_loops;
+    bool profiled;
+};
+
+static const Loop loops[] = {
+    { "table", &m6800_cpu_device::execute_run_table, false, false },
+    { "switch", &m6800_cpu_device::execute_run_switch, false, false },
+#if defined(__GNUC__)
+    { "goto", &m6800_cpu_device::execute_run_goto, false, false },
+#endif
+    { "blocks", &m6800_cpu_device::execute_run_blocks, true, false },
+    { "blocks-noskip", &m6800_cpu_device::execute_run_blocks, false, false },
+#if M6800_JIT_X64
+    { "jit", &m6800_cpu_device::execute_run_jit, true, false },
+#endif
+    { "instrumented", &m6800_cpu_device::execute_run_instrumented, false, true },
+};
+
+static const int LOOP_COUNT = sizeof(loops) / sizeof(loops[0]);
+
+// FNV-1a
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static bool load_file(const char* path, uint8_t* buffer, size_t size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    bool loaded = fread(buffer, 1, size, file) == size;
+    fclose(file);
+    return loaded;
+}
+
+struct Machine {
+    MemoryMapManager memory_map;
+    memory_device ram { 0x0000, RAM_SIZE, false };
+    memory_device fantom { 0x1400, 0x0800, true };
+    memory_device basic { 0x1C00, 0x0800, true };
+    memory_device monitor { 0xFC00, 0x0400, true };
+    keypad_io keypad;
+    display_io display;
+    m6800_cpu_device cpu { &memory_map };
+    const Loop& loop;
+    m6800_profiler* profile = nullptr;
+    m6800_call_profiler* calls = nullptr;
+    unsigned long long cycles_run = 0; /* until the CPU went into WAI, which the profiler doesn't see */
+    bool waited = false;
+
+    Machine(const Loop& loop, const uint8_t* image)
+        : loop(loop) {
+        ram.load(0x0000, (uint8_t*)image, RAM_SIZE);
+        memset(display.get_mapped_memory(), 0, DISPLAY_SIZE);
+        memory_map.map(&ram);
+        memory_map.map(&keypad);
+        memory_map.map(&display);
+        memory_map.map(&fantom);
+        memory_map.map(&basic);
+        memory_map.map(&monitor);
+        keypad.init();
+        load_rom(fantom, "/fantomii.bin", 0x1400, 0x0800);
+        load_rom(basic, "/tinybasic.bin", 0x1C00, 0x0800);
+        load_rom(monitor, "/monitor.bin", 0xFC00, 0x0400);
+
+        cpu.check_breakpoint = [](uint32_t) { return false; };
+        cpu.delay_loop_enabled = loop.delay_loops;
+        if (loop.profiled) {
+            profile = new m6800_profiler();
+            calls = new m6800_call_profiler();
+            cpu.profile = profile;
+            cpu.calls = calls;
+        }
+        cpu.device_start();
+        cpu.device_reset();
+    }
+
+    ~Machine() {
+        delete profile;
+        delete calls;
+    }
+
+    static void load_rom(memory_device& rom, const char* name, offs_t address, size_t size) {
+        std::vector<uint8_t> buffer(size, 0);
+        if (!load_file((std::string(ET3400_ROM_DIR) + name).c_str(), buffer.data(), size)) {
+            fprintf(stderr, "can't read %s%s\n", ET3400_ROM_DIR, name);
+        }
+        rom.load(address, buffer.data(), size);
+    }
+
+    void run(int cycles) {
+        cpu.m_icount = cycles;
+        (cpu.*loop.func)();
+        waited |= (cpu.m_wai_state & m6800_cpu_device::M6800_WAI) != 0;
+        if (!waited) {
+            cycles_run += cycles - cpu.m_icount;
+        }
+    }
+
+    // the profile holds every instruction run and, short of a WAI, every cycle, and the call
+    // profile the same cycles
+    bool check_profile(const std::string& name) {
+        unsigned long long counted = 0;
+        for (int address = 0; address < m6800_profiler::ADDRESSES; address++) {
+            counted += profile->get_count(address);
+        }
+        if (counted != cpu.instructions_retired) {
+            printf("%s: the profile counted %llu of %llu instructions\n", name.c_str(), counted, cpu.instructions_retired);
+            return false;
+        }
+        unsigned long long cycles = profile->get_total_cycles();
+        if (!waited && cycles != cycles_run) {
+            printf("%s: the profile counted %llu of %llu cycles\n", name.c_str(), cycles, cycles_run);
+            return false;
+        }
+        if (calls->get_total_cycles() != cycles) {
+            printf("%s: the call profile charged %llu of %llu cycles\n", name.c_str(), calls->get_total_cycles(), cycles);
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t state_hash() {
+        m6800_state state;
+        memset(&state, 0, sizeof(state));
+        cpu.save_state(state);
+        uint64_t hash = hash_bytes(0xCBF29CE484222325ULL, &state, sizeof(state));
+        hash = hash_bytes(hash, &cpu.instructions_retired, sizeof(cpu.instructions_retired));
+        hash = hash_bytes(hash, ram.get_mapped_memory(), RAM_SIZE);
+        return hash_bytes(hash, display.get_mapped_memory(), DISPLAY_SIZE);
+    }
+};
+
+/*
+    One machine per loop, stepped together
+*/
+class Lockstep {
+public:
+    Lockstep(const std::string& name, const uint8_t* image) {
+        this->name = name;
+        slice = 0;
+        hash = 0xCBF29CE484222325ULL;
+        failed = false;
+        for (int i = 0; i < LOOP_COUNT; i++) {
+            machines.push_back(new Machine(loops[i], image));
+        }
+    }
+
+    ~Lockstep() {
+        for (Machine* machine : machines) {
+            delete machine;
+        }
+    }
+
+    // runs a slice on every machine and compares them, false once they have gone apart
+    bool run(int cycles = CYCLES_PER_SLICE) {
+        if (failed) {
+            return false;
+        }
+        for (Machine* machine : machines) {
+            machine->run(cycles);
+        }
+        uint64_t expected = machines[0]->state_hash();
+        for (int i = 1; i < LOOP_COUNT; i++) {
+            if (machines[i]->state_hash() != expected) {
+                report(*machines[i]);
+                failed = true;
+                return false;
+            }
+        }
+        hash = hash_bytes(hash, &expected, sizeof(expected));
+        slice++;
+        return true;
+    }
+
+    bool run_slices(int count, int cycles = CYCLES_PER_SLICE) {
+        for (int i = 0; i < count; i++) {
+            if (!run(cycles)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void press_key(keypad_io::Keys key) {
+        for (Machine* machine : machines) {
+            machine->keypad.press_key(key);
+        }
+    }
+
+    void release_key(keypad_io::Keys key) {
+        for (Machine* machine : machines) {
+            machine->keypad.release_key(key);
+        }
+    }
+
+    void set_pc(uint16_t pc) {
+        for (Machine* machine : machines) {
+            machine->cpu.m_pc.d = pc;
+        }
+    }
+
+    void set_sp(uint16_t sp) {
+        for (Machine* machine : machines) {
+            machine->cpu.m_s.d = sp;
+        }
+    }
+
+    const Machine* profiled() const {
+        for (Machine* machine : machines) {
+            if (machine->profile != nullptr) {
+                return machine;
+            }
+        }
+        return nullptr;
+    }
+
+    bool check_profiles() {
+        for (Machine* machine : machines) {
+            if (machine->profile != nullptr && !machine->check_profile(name)) {
+                failed = true;
+            }
+        }
+        return !failed;
+    }
+
+    std::string name;
+    uint64_t hash; /* of the state after every slice */
+    bool failed;
+
+private:
+    std::vector<Machine*> machines;
+    int slice;
+
+    void report(Machine& machine) {
+        Machine& table = *machines[0];
+        CpuStatus expected = table.cpu.get_status();
+        CpuStatus got = machine.cpu.get_status();
+        printf("%s: %s differs from table after slice %d\n", name.c_str(), machine.loop.name, slice);
+        printf("  pc %04x/%04x sp %04x/%04x x %04x/%04x a %02x/%02x b %02x/%02x cc %02x/%02x icount %d/%d\n",
+            got.pc, expected.pc, got.sp, expected.sp, got.ix, expected.ix, got.acca, expected.acca,
+            got.accb, expected.accb, got.cc, expected.cc, machine.cpu.m_icount, table.cpu.m_icount);
+        printf("  instructions retired %llu/%llu\n", machine.cpu.instructions_retired, table.cpu.instructions_retired);
+        for (int address = 0; address < RAM_SIZE; address++) {
+            uint8_t value = machine.ram.get_mapped_memory()[address];
+            uint8_t expected_value = table.ram.get_mapped_memory()[address];
+            if (value != expected_value) {
+                printf("  first RAM difference at %04x: %02x/%02x\n", address, value, expected_value);
+                break;
+            }
+        }
+    }
+};
+
+static bool load_sample(const char* name, uint8_t* image) {
+    std::vector<srec_block> blocks;
+    std::string path = std::string(ET3400_SAMPLES_DIR "/") + name;
+    bool loaded = SrecReader::Read(QString::fromStdString(path), &blocks);
+    for (srec_block& block : blocks) {
+        int size = block.bytecount - 3;
+        if (block.address + size <= RAM_SIZE) {
+            memcpy(&image[block.address], block.data, size);
+        }
+        free(block.data);
+    }
+    if (!loaded) {
+        printf("can't read %s\n", path.c_str());
+    }
+    return loaded;
+}
+
+struct Result {
+    std::string name;
+    uint64_t hash;
+    bool failed;
+};
+
+static std::vector<Result> results;
+
+static void record(Lockstep& lockstep) {
+    lockstep.check_profiles();
+    results.push_back(Result { lockstep.name, lockstep.hash, lockstep.failed });
+}
+
+static void tap_key(Lockstep& lockstep, keypad_io::Keys key) {
+    lockstep.press_key(key);
+    lockstep.run_slices(10);
+    lockstep.release_key(key);
+    lockstep.run_slices(30);
+}
+
+// the Monitor from reset, typing a few commands
+static void monitor_keys() {
+    uint8_t image[RAM_SIZE] = { 0 };
+    Lockstep lockstep("monitor keys", image);
+    lockstep.run_slices(100);
+    tap_key(lockstep, keypad_io::KeyE);
+    tap_key(lockstep, keypad_io::Key1);
+    tap_key(lockstep, keypad_io::KeyC);
+    record(lockstep);
+}
+
+// the sample programs, started at each of their entry points
+static bool samples() {
+    struct {
+        const char* file;
+        uint16_t start;
+    } samples[] = {
+        { "samp123a.s19", 0x0000 },
+        { "samp123a.s19", 0x0030 },
+        { "samp123a.s19", 0x0060 },
+        { "samp45a.s19", 0x0000 },
+        { "samp45a.s19", 0x0060 },
+        { "samp6a.s19", 0x0000 },
+    };
+
+    for (auto& sample : samples) {
+        uint8_t image[RAM_SIZE] = { 0 };
+        if (!load_sample(sample.file, image)) {
+            return false;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "%s@%04X", sample.file, sample.start);
+        Lockstep lockstep(name, image);
+        lockstep.run_slices(20);
+        lockstep.set_pc(sample.start);
+        lockstep.run_slices(400);
+        tap_key(lockstep, keypad_io::Key7);
+        lockstep.run_slices(70);
+        record(lockstep);
+    }
+    return true;
+}
+
+// a routine that drops its return address with INS INS and leaves by a JMP to its caller's
+// RTS, which the call profiler has to unwind from the stack pointer alone
+static void discarded_returns() {
+    static const uint8_t main_loop[] = {
+        0x8E, 0x00, 0xFF, //      LDS #$00FF
+        0xBD, 0x00, 0x10, // loop JSR $0010
+        0x20, 0xFB, //            BRA loop
+    };
+    static const uint8_t routines[] = {
+        0x8D, 0x0E, //       $0010 BSR $0020
+        0x39, //                   RTS
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0x31, //             $0020 INS
+        0x31, //                   INS
+        0x7E, 0x00, 0x30, //       JMP $0030
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0x39, //             $0030 RTS
+    };
+    uint8_t image[RAM_SIZE] = { 0 };
+    memcpy(&image[0x0000], main_loop, sizeof(main_loop));
+    memcpy(&image[0x0010], routines, sizeof(routines));
+
+    Lockstep lockstep("discarded returns", image);
+    lockstep.set_pc(0x0000);
+    // LDS, then 100 turns of JSR 9 + BRA 4 in the root, BSR 8 + RTS 5 in $0010 and INS 4 +
+    // INS 4 + JMP 3 in $0020; $0020 has returned once INS INS pops its return address, so
+    // the JMP is charged to $0010
+    lockstep.run(3 + 100 * 37);
+    record(lockstep);
+
+    const Machine* machine = lockstep.profiled();
+    if (machine == nullptr || lockstep.failed) {
+        return;
+    }
+    struct {
+        uint32_t function;
+        unsigned long long calls;
+        unsigned long long inclusive;
+        unsigned long long exclusive;
+    } expected[] = {
+        { m6800_call_profiler::ROOT, 0, 3 + 100 * 37, 3 + 100 * 13 },
+        { 0x0010, 100, 100 * 24, 100 * 16 },
+        { 0x0020, 100, 100 * 8, 100 * 8 },
+    };
+    std::vector<m6800_function_stats> stats = machine->calls->summarize();
+    for (auto& routine : expected) {
+        bool found = false;
+        for (m6800_function_stats& got : stats) {
+            if (got.function != routine.function) {
+                continue;
+            }
+            found = true;
+            if (got.calls != routine.calls || got.inclusive != routine.inclusive || got.exclusive != routine.exclusive) {
+                printf("%s: routine %04x has %llu calls, %llu/%llu cycles, expected %llu calls, %llu/%llu cycles\n",
+                    lockstep.name.c_str(), routine.function, got.calls, got.inclusive, got.exclusive,
+                    routine.calls, routine.inclusive, routine.exclusive);
+                results.back().failed = true;
+            }
+        }
+        if (!found) {
+            printf("%s: routine %04x never ran\n", lockstep.name.c_str(), routine.function);
+            results.back().failed = true;
+        }
+    }
+}
+
+static uint32_t next_random(uint32_t& seed) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+// counted delay loops, 16 and 8 bit, up and down, one with a NOP in it, which the block and
+// JIT loops run at once; slices of random length end them partway through
+static void delay_loops() {
+    static const uint8_t program[] = {
+        0xCE, 0x12, 0x34, // $0100 LDX #$1234
+        0x09, //             wait1 DEX
+        0x26, 0xFD, //             BNE wait1
+        0x7C, 0x00, 0x10, //       INC $0010
+        0x86, 0x40, //             LDAA #$40
+        0x4A, //             wait2 DECA
+        0x26, 0xFD, //             BNE wait2
+        0x7C, 0x00, 0x11, //       INC $0011
+        0xC6, 0x00, //             LDAB #0
+        0x5C, //             wait3 INCB
+        0x01, //                   NOP
+        0x26, 0xFC, //             BNE wait3
+        0x7C, 0x00, 0x12, //       INC $0012
+        0xCE, 0xF0, 0x00, //       LDX #$F000
+        0x08, //             wait4 INX
+        0x26, 0xFD, //             BNE wait4
+        0xC6, 0x80, //             LDAB #$80
+        0x5A, //             wait5 DECB
+        0x26, 0xFD, //             BNE wait5
+        0x86, 0x00, //             LDAA #0
+        0x4C, //             wait6 INCA
+        0x26, 0xFD, //             BNE wait6
+        0x20, 0xD4, //             BRA $0100
+    };
+    uint8_t image[RAM_SIZE] = { 0 };
+    memcpy(&image[0x0100], program, sizeof(program));
+
+    Lockstep lockstep("delay loops", image);
+    lockstep.set_pc(0x0100);
+    lockstep.run_slices(100);
+    uint32_t seed = 0x0926;
+    for (int slice = 0; slice < 1000; slice++) {
+        lockstep.run(1 + next_random(seed) % 40000);
+    }
+    record(lockstep);
+}
+
+// counted loops around random register, memory and branch instructions, some storing into
+// their own code, run in slices of random length
+static void structured_programs(int count) {
+    static const uint8_t inherent[] = { 0x01, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x16, 0x17, 0x19, 0x1B, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x43, 0x44, 0x46, 0x48, 0x49, 0x4A, 0x4C, 0x4D, 0x4F, 0x53, 0x5A, 0x5C, 0x5D, 0x5F };
+    static const uint8_t immediate[] = { 0x80, 0x81, 0x84, 0x86, 0x88, 0x89, 0x8A, 0x8B, 0xC0, 0xC1, 0xC6, 0xCB };
+    static const uint8_t memory[] = { 0x60, 0x6C, 0x7A, 0x7C, 0x96, 0x97, 0x9B, 0xA6, 0xA7, 0xB6, 0xB7, 0xD6, 0xD7, 0xE7 };
+
+    for (int program = 0; program < count; program++) {
+        uint32_t seed = 0x6800 + program;
+        uint8_t image[RAM_SIZE] = { 0 };
+        int address = 0;
+        while (address < 0x1E0) {
+            // LDX #n, the body, DEX, BNE body
+            image[address++] = 0xCE;
+            image[address++] = 0;
+            image[address++] = 1 + next_random(seed) % 20;
+            int body = address;
+            int length = 1 + next_random(seed) % 8;
+            for (int i = 0; i < length && address < 0x1F0; i++) {
+                int kind = next_random(seed) % 10;
+                if (kind < 5) {
+                    image[address++] = inherent[next_random(seed) % sizeof(inherent)];
+                } else if (kind < 6) {
+                    image[address++] = immediate[next_random(seed) % sizeof(immediate)];
+                    image[address++] = next_random(seed) % 4 ? next_random(seed) % 3 : next_random(seed);
+                } else if (kind < 8) {
+                    uint8_t opcode = memory[next_random(seed) % sizeof(memory)];
+                    image[address++] = opcode;
+                    if ((opcode & 0xF0) == 0x70 || (opcode & 0xF0) == 0xB0) {
+                        // mostly data above the code, now and then the code itself
+                        image[address++] = next_random(seed) % 2;
+                        image[address++] = next_random(seed) % 10 ? 0x80 + next_random(seed) % 0x80 : next_random(seed) % 0x1F0;
+                    } else {
+                        image[address++] = next_random(seed) % 10 ? 0x80 + next_random(seed) % 0x40 : next_random(seed);
+                    }
+                } else if (kind < 9) {
+                    image[address++] = 0x20 + next_random(seed) % 16;
+                    image[address++] = next_random(seed) % 4;
+                } else {
+                    image[address++] = 0x36 + next_random(seed) % 2;
+                }
+            }
+            image[address++] = 0x09;
+            image[address++] = 0x26;
+            image[address] = (uint8_t)(body - (address + 1));
+            address++;
+        }
+        // JMP 0
+        image[address++] = 0x7E;
+        image[address++] = 0x00;
+        image[address++] = 0x00;
+
+        char name[64];
+        snprintf(name, sizeof(name), "structured #%d", program);
+        Lockstep lockstep(name, image);
+        lockstep.set_pc(0x0000);
+        lockstep.set_sp(0x07F0);
+        for (int slice = 0; slice < 300; slice++) {
+            lockstep.run(1 + next_random(seed) % 3000);
+        }
+        record(lockstep);
+    }
+}
+
+// random bytes, to reach the odd opcodes and addressing corners
+static void random_programs(int count) {
+    for (int program = 0; program < count; program++) {
+        uint32_t seed = 0x3400 + program;
+        uint8_t image[RAM_SIZE];
+        for (int address = 0; address < RAM_SIZE; address++) {
+            image[address] = next_random(seed);
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "random #%d", program);
+        Lockstep lockstep(name, image);
+        lockstep.set_pc(0x0000);
+        lockstep.set_sp(0x07F0);
+        for (int slice = 0; slice < 300; slice++) {
+            lockstep.run(1 + next_random(seed) % 3000);
+        }
+        record(lockstep);
+    }
+}
+
+static bool write_hashes(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        printf("can't write %s\n", path);
+        return false;
+    }
+    for (Result& result : results) {
+        fprintf(file, "%016llx %s\n", (unsigned long long)result.hash, result.name.c_str());
+    }
+    fclose(file);
+    return true;
+}
+
+static bool compare_hashes(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        printf("can't read %s\n", path);
+        return false;
+    }
+    std::map<std::string, uint64_t> expected;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        unsigned long long hash;
+        char name[200];
+        if (sscanf(line, "%llx %199[^\n]", &hash, name) == 2) {
+            expected[name] = hash;
+        }
+    }
+    fclose(file);
+
+    bool same = true;
+    for (Result& result : results) {
+        std::map<std::string, uint64_t>::iterator it = expected.find(result.name);
+        if (it == expected.end()) {
+            printf("%s: not in %s\n", result.name.c_str(), path);
+            same = false;
+        } else if (it->second != result.hash) {
+            printf("%s: %016llx, %s has %016llx\n", result.name.c_str(), (unsigned long long)result.hash, path, (unsigned long long)it->second);
+            same = false;
+        }
+    }
+    return same;
+}
+
+int main(int argc, char* argv[]) {
+    const char* write_path = nullptr;
+    const char* compare_path = nullptr;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--write") == 0) {
+            write_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--compare") == 0) {
+            compare_path = argv[i + 1];
+        } else {
+            printf("usage: %s [--write FILE] [--compare FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    monitor_keys();
+    if (!samples()) {
+        return 1;
+    }
+    discarded_returns();
+    delay_loops();
+    structured_programs(20);
+    random_programs(20);
+
+    int failed = 0;
+    for (Result& result : results) {
+        failed += result.failed;
+    }
+    printf("%d scenarios through %d loops, %d failed\n", (int)results.size(), LOOP_COUNT, failed);
+
+    bool ok = failed == 0;
+    if (ok && write_path != nullptr) {
+        ok = write_hashes(write_path);
+    }
+    if (ok && compare_path != nullptr) {
+        ok = compare_hashes(compare_path);
+    }
+    return ok ? 0 : 1;
+}
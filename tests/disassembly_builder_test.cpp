@@ -0,0 +1,124 @@
+/*
+    Checks DisassemblyBuilder::update() against a full build()
+
+    A block of random code with comment, assembly and data labels over parts of it is built
+    once, then written to at random: single bytes, short runs and runs over label edges and
+    the ends of the range. After every write update() is given the written span, and its lines
+    must be the ones build() gives for the new memory, field for field.
+*/
+
+#include "../src/util/disassembly_builder.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <vector>
+
+static const offs_t START = 0x0000;
+static const offs_t END = 0x07FF;
+static const int SIZE = END - START + 1;
+static const int WRITES = 2000;
+
+static uint32_t next_random(uint32_t& seed) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static bool same_line(const DisassemblyLine& a, const DisassemblyLine& b) {
+    return a.address == b.address && a.type == b.type && a.opcodes == b.opcodes && a.instruction == b.instruction
+        && a.operand == b.operand && a.label == b.label && a.bytes == b.bytes;
+}
+
+// the index of the first line that differs, or -1
+static int first_difference(const std::vector<DisassemblyLine>& got, const std::vector<DisassemblyLine>& expected) {
+    size_t count = std::min(got.size(), expected.size());
+    for (size_t i = 0; i < count; i++) {
+        if (!same_line(got[i], expected[i])) {
+            return (int)i;
+        }
+    }
+    return got.size() == expected.size() ? -1 : (int)count;
+}
+
+// labels every 64 to 191 bytes, taking turns at the three types, the blocks 2 to 33 bytes long
+static std::vector<Label> make_labels(uint32_t& seed) {
+    static const LabelType types[] = { COMMENT, ASSEMBLY, DATA };
+    std::vector<Label> labels;
+    offs_t address = START + 16;
+    for (int i = 0; address + 40 < END; i++) {
+        Label label;
+        label.start = address;
+        label.end = address + 1 + next_random(seed) % 32;
+        label.type = types[i % 3];
+        label.comment = QString("label %1").arg(i);
+        labels.push_back(label);
+        address = label.end + 64 + next_random(seed) % 128;
+    }
+    return labels;
+}
+
+static bool update_matches_build(uint32_t seed) {
+    // the decoder may read up to two bytes past the end of the range
+    uint8_t memory[SIZE + 2] = { 0 };
+    for (int i = 0; i < SIZE; i++) {
+        memory[i] = next_random(seed);
+    }
+    std::vector<Label> labels = make_labels(seed);
+
+    std::vector<DisassemblyLine> lines;
+    DisassemblyBuilder::build(&lines, START, END, memory, &labels);
+    for (int write = 0; write < WRITES; write++) {
+        offs_t first;
+        int length;
+        switch (next_random(seed) % 4) {
+        case 0:
+            // across the start or end of a label
+            {
+                const Label& label = labels[next_random(seed) % labels.size()];
+                offs_t edge = next_random(seed) & 1 ? label.start : label.end;
+                first = edge - next_random(seed) % 3;
+                length = 1 + next_random(seed) % 6;
+            }
+            break;
+        case 1:
+            // at either end of the range
+            first = next_random(seed) & 1 ? START : END - next_random(seed) % 4;
+            length = 1 + next_random(seed) % 4;
+            break;
+        default:
+            first = START + next_random(seed) % SIZE;
+            length = 1 + next_random(seed) % 4;
+            break;
+        }
+        offs_t last = std::min(first + length - 1, END);
+        for (offs_t address = first; address <= last; address++) {
+            memory[address - START] = next_random(seed);
+        }
+
+        DisassemblyBuilder::update(&lines, START, END, memory, &labels, first, last);
+        std::vector<DisassemblyLine> expected;
+        DisassemblyBuilder::build(&expected, START, END, memory, &labels);
+
+        int line = first_difference(lines, expected);
+        if (line >= 0) {
+            printf("update_matches_build: write %d to $%04X-$%04X left line %d at $%04X, a full build has $%04X\n",
+                write, first, last, line, line < (int)lines.size() ? lines[line].address : 0,
+                line < (int)expected.size() ? expected[line].address : 0);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    static const uint32_t seeds[] = { 0x6800, 0x3400, 0xC110, 0xFC00 };
+    int failed = 0;
+    for (uint32_t seed : seeds) {
+        bool ok = update_matches_build(seed);
+        printf("update_matches_build seed %04X  %s\n", seed, ok ? "ok" : "FAILED");
+        failed += !ok;
+    }
+    printf("%d checks, %d failed\n", (int)(sizeof(seeds) / sizeof(seeds[0])), failed);
+    return failed == 0 ? 0 : 1;
+}
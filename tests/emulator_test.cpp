@@ -0,0 +1,494 @@
+/*
+    Checks the emulator across threads: et3400emu's worker running programs in real time while
+    other threads send it commands and input, and the CPU taking interrupts raised from outside
+    the thread running it
+
+    Each check starts its own machine and fails with a message saying what it expected. The
+    checks that hold the emulator to wall clock time fail on a host too loaded to keep up, so
+    they only run with --timing, and then on their own.
+*/
+
+#include "../src/emu/et3400.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef ET3400_ROM_DIR
+#define ET3400_ROM_DIR "src/resources/rom"
+#endif
+
+typedef std::chrono::steady_clock clock_type;
+
+static double seconds_since(clock_type::time_point start) {
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+struct Emulator {
+    keypad_io* keypad = new keypad_io();
+    display_io* display = new display_io();
+    et3400emu* emu = new et3400emu(keypad, display);
+
+    ~Emulator() {
+        delete emu;
+        delete keypad;
+        delete display;
+    }
+
+    void load(const uint8_t* program, int size) {
+        emu->loadRAM(0, (uint8_t*)program, size);
+        emu->init();
+    }
+};
+
+// INCA; JMP 0 - busy, A changes every pass so it is never taken for an idle loop
+static const uint8_t busy_loop[] = { 0x4C, 0x7E, 0x00, 0x00 };
+
+// commands end the pacer's wait early; the rest of the frame must still be run at the
+// configured clock, not thrown away or handed out again as a new frame
+static bool clock_rate_with_commands() {
+    Emulator machine;
+    machine.load(busy_loop, sizeof(busy_loop));
+    machine.emu->set_idle_skip(false);
+    machine.emu->start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::vector<bool> pages;
+    unsigned long long start_cycles = machine.emu->total_cycles;
+    clock_type::time_point start = clock_type::now();
+    while (seconds_since(start) < 1.0) {
+        machine.emu->get_written_pages(pages);
+        std::this_thread::sleep_for(std::chrono::milliseconds(3));
+    }
+    double hz = (machine.emu->total_cycles - start_cycles) / seconds_since(start);
+
+    if (hz < 900000 || hz > 1100000) {
+        printf("clock_rate_with_commands: ran at %.3f MHz with a command every 3 ms, expected 1 MHz\n", hz / 1e6);
+        return false;
+    }
+    return true;
+}
+
+/*
+    A bare CPU with RAM at $0000, RAM for the vectors at $FF00 and the PIA at $1000, for the
+    interrupt checks. The program starts at $0000 with the stack at $00D0, so an interrupt
+    that arrives before its first instruction doesn't push over the vectors.
+*/
+struct Board {
+    MemoryMapManager memory_map;
+    memory_device ram { 0x0000, 0x0100, false };
+    memory_device vectors { 0xFF00, 0x0100, false };
+    RS232Adapter serial;
+    MC6820 pia { &serial };
+    m6800_cpu_device cpu { &memory_map };
+
+    Board(const uint8_t* program, int size, uint16_t irq, uint16_t nmi) {
+        uint8_t image[0x0100] = { 0 };
+        memcpy(image, program, size);
+        ram.load(0x0000, image, sizeof(image));
+        uint8_t top[0x0100] = { 0 };
+        top[0xF8] = irq >> 8;
+        top[0xF9] = irq & 0xFF;
+        top[0xFC] = nmi >> 8;
+        top[0xFD] = nmi & 0xFF;
+        vectors.load(0xFF00, top, sizeof(top));
+        memory_map.map(&ram);
+        memory_map.map(&vectors);
+        memory_map.map(&pia);
+        pia.on_irq = [this](bool asserted) { cpu.execute_set_input(M6800_IRQ_LINE, asserted ? ASSERT_LINE : CLEAR_LINE); };
+        cpu.check_breakpoint = [](uint32_t) { return false; };
+        cpu.device_start();
+        cpu.device_reset();
+        cpu.m_pc.d = 0x0000;
+        cpu.m_s.d = 0x00D0;
+    }
+
+    void run(int cycles) {
+        cpu.m_icount = cycles;
+        cpu.execute_run();
+    }
+
+    // may be called while another thread runs the CPU, the byte is read again every time
+    uint8_t peek(offs_t address) {
+        return ((volatile uint8_t*)ram.get_mapped_memory())[address];
+    }
+};
+
+// an edge on CA1 raises IRQ through the PIA, reading its data register clears it, and the
+// edge CRA doesn't select is ignored
+static bool pia_ca1_interrupt() {
+    static const uint8_t program[] = {
+        0x86, 0x07, //             LDAA #$07      CA1 interrupt on a rising edge
+        0xB7, 0x10, 0x01, //       STAA $1001
+        0x0E, //                   CLI
+        0x20, 0xFE, //       loop  BRA loop
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0xB6, 0x10, 0x00, // $0010 LDAA $1000
+        0x7C, 0x00, 0x40, //       INC $0040
+        0x3B, //                   RTI
+    };
+    Board board(program, sizeof(program), 0x0010, 0x0000);
+    board.run(100);
+
+    int expected[] = { 1, 1, 2 };
+    for (int i = 0; i < 3; i++) {
+        board.pia.set_ca1(i != 1);
+        board.run(100);
+        if (board.peek(0x40) != expected[i]) {
+            printf("pia_ca1_interrupt: the handler ran %d times after %s edge %d, expected %d\n",
+                board.peek(0x40), i == 1 ? "falling" : "rising", i, expected[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// NMI pulses shorter than an instruction, sent from another thread while the CPU runs, are
+// latched and each one taken once; the next pulse waits for the handler, since two edges
+// the CPU hasn't got to yet are one NMI
+static bool nmi_pulses_from_another_thread() {
+    static const uint8_t program[] = {
+        0x20, 0xFE, //       loop  BRA loop
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0x7C, 0x00, 0x40, // $0010 INC $0040
+        0x3B, //                   RTI
+    };
+    static const int PULSES = 200;
+    Board board(program, sizeof(program), 0x0000, 0x0010);
+
+    std::atomic<bool> done(false);
+    std::thread runner([&board, &done]() {
+        while (!done) {
+            board.run(10000);
+        }
+    });
+    int taken = 0;
+    for (int i = 0; i < PULSES && taken == i; i++) {
+        board.cpu.execute_set_input(INPUT_LINE_NMI, ASSERT_LINE);
+        board.cpu.execute_set_input(INPUT_LINE_NMI, CLEAR_LINE);
+        clock_type::time_point start = clock_type::now();
+        while ((taken = board.peek(0x40)) == i && seconds_since(start) < 10) {
+            std::this_thread::yield();
+        }
+    }
+    // long enough for a pulse taken twice to show
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    done = true;
+    runner.join();
+    taken = board.peek(0x40);
+
+    if (taken != PULSES) {
+        printf("nmi_pulses_from_another_thread: the handler ran %d times for %d pulses\n", taken, PULSES);
+        return false;
+    }
+    return true;
+}
+
+// the Monitor waiting for a key is skipped as idle; an NMI from another thread wakes the worker
+// and the handler at $00FD runs once per pulse. Returns the longest the worker took to wake,
+// or a negative time if the handler didn't run once per pulse
+static double idle_wake(const char* name) {
+    static const uint8_t handler[] = {
+        0x7C, 0x00, 0x40, // $0010 INC $0040
+        0x3B, //                   RTI
+    };
+    static const uint8_t vector[] = { 0x7E, 0x00, 0x10 }; // $00FD JMP $0010
+    static const int PULSES = 5;
+    Emulator machine;
+    machine.emu->loadROM(ET3400_ROM_DIR "/monitor.bin", 0xFC00, 0x0400);
+    machine.emu->loadRAM(0x0010, (uint8_t*)handler, sizeof(handler));
+    machine.emu->loadRAM(0x00FD, (uint8_t*)vector, sizeof(vector));
+    machine.emu->init();
+    machine.emu->start();
+
+    double slowest = 0;
+    for (int i = 0; i < PULSES; i++) {
+        clock_type::time_point start = clock_type::now();
+        while (!machine.emu->get_idle() && seconds_since(start) < 10) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        // well into the sleep
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        unsigned long long cycles = machine.emu->total_cycles;
+        start = clock_type::now();
+        machine.emu->set_input_line(INPUT_LINE_NMI, ASSERT_LINE);
+        machine.emu->set_input_line(INPUT_LINE_NMI, CLEAR_LINE);
+        while (machine.emu->total_cycles == cycles && seconds_since(start) < 10) {
+            std::this_thread::yield();
+        }
+        slowest = std::max(slowest, seconds_since(start));
+    }
+    machine.emu->halt();
+    MachineState state;
+    machine.emu->saveState(state);
+
+    if (state.get_ram()[0x40] != PULSES) {
+        printf("%s: the handler ran %d times for %d pulses\n", name, state.get_ram()[0x40], PULSES);
+        return -1;
+    }
+    return slowest;
+}
+
+static bool idle_wake_on_input() {
+    return idle_wake("idle_wake_on_input") >= 0;
+}
+
+// the worker wakes for the input line, well before IDLE_WAKE_MS would have woken it anyway
+static bool idle_wake_latency() {
+    double slowest = idle_wake("idle_wake_latency");
+    if (slowest < 0) {
+        return false;
+    }
+    if (slowest > et3400emu::IDLE_WAKE_MS / 5 / 1000.0) {
+        printf("idle_wake_latency: the worker took up to %.0f ms to wake, expected well under %d ms\n",
+            slowest * 1000, et3400emu::IDLE_WAKE_MS);
+        return false;
+    }
+    return true;
+}
+
+// waits up to ten seconds for the machine to settle in an idle loop
+static bool wait_idle(Emulator& machine) {
+    clock_type::time_point start = clock_type::now();
+    while (!machine.emu->get_idle() && seconds_since(start) < 10) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return machine.emu->get_idle();
+}
+
+// the telemetry keeps counting while the machine sleeps in an idle loop: in real time the
+// skipped cycles, and in turbo mode, where the clock stands still, the window still closes
+// and the clock rate drops to zero
+static bool idle_telemetry() {
+    Emulator machine;
+    machine.emu->loadROM(ET3400_ROM_DIR "/monitor.bin", 0xFC00, 0x0400);
+    machine.emu->init();
+    machine.emu->start();
+
+    TelemetrySnapshot before;
+    TelemetrySnapshot real_time;
+    bool idle = wait_idle(machine);
+    machine.emu->get_telemetry(before);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    machine.emu->get_telemetry(real_time);
+
+    machine.emu->set_turbo(true);
+    TelemetrySnapshot turbo;
+    idle = wait_idle(machine) && idle;
+    // over two windows, so at least one was spent asleep
+    std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+    machine.emu->get_telemetry(turbo);
+
+    if (!idle || real_time.cycles <= before.cycles || turbo.emulated_mhz != 0) {
+        printf("idle_telemetry: %s, %llu cycles counted in real time, %.3f MHz in turbo mode, expected some and 0\n",
+            idle ? "idle" : "not idle", real_time.cycles - before.cycles, turbo.emulated_mhz);
+        return false;
+    }
+    return true;
+}
+
+// the display changed by whole loads and single writes on one thread while another takes
+// snapshots: the memory only ever goes from all v, through v + 1 written from the first byte
+// on, to all v + 1, so any other snapshot is torn; equal generations must hold equal memory
+static bool display_snapshots() {
+    display_io display;
+    std::atomic<bool> done(false);
+    std::thread writer([&display, &done]() {
+        uint8_t memory[display_io::SIZE];
+        for (uint8_t value = 0; !done; value += 2) {
+            memset(memory, value, sizeof(memory));
+            display.load(memory);
+            for (int i = 0; i < display_io::SIZE; i++) {
+                display.write(0xC110 + i, value + 1);
+            }
+        }
+    });
+
+    uint8_t last[display_io::SIZE] = { 0 };
+    unsigned last_generation = 0;
+    int taken = 0;
+    const char* error = nullptr;
+    clock_type::time_point start = clock_type::now();
+    while (error == nullptr && seconds_since(start) < 0.5) {
+        uint8_t memory[display_io::SIZE];
+        unsigned generation = display.snapshot(memory);
+        int split = 0;
+        while (split < display_io::SIZE && memory[split] == memory[0]) {
+            split++;
+        }
+        for (int i = split; i < display_io::SIZE; i++) {
+            if (memory[i] != (uint8_t)(memory[0] - 1) || (memory[0] & 1) == 0) {
+                error = "torn";
+            }
+        }
+        if (generation & 1) {
+            error = "odd generation";
+        } else if (generation == last_generation && taken > 0 && memcmp(memory, last, sizeof(memory)) != 0) {
+            error = "different memory under one generation";
+        } else if ((int)(generation - last_generation) < 0) {
+            error = "generation went back";
+        }
+        memcpy(last, memory, sizeof(memory));
+        last_generation = generation;
+        taken++;
+    }
+    done = true;
+    writer.join();
+
+    if (error != nullptr) {
+        printf("display_snapshots: snapshot %d: %s\n", taken, error);
+        return false;
+    }
+    return true;
+}
+
+// the pages the debugger's disassembly decodes again: all of RAM on the first call, then
+// only the stack page while the Monitor waits for a key, and the page a file load wrote
+static bool written_pages() {
+    static const uint8_t program[] = { 0x01, 0x01, 0x01, 0x01 };
+    Emulator machine;
+    machine.emu->loadROM(ET3400_ROM_DIR "/monitor.bin", 0xFC00, 0x0400);
+    machine.emu->init();
+    machine.emu->start();
+
+    std::vector<bool> first;
+    machine.emu->get_written_pages(first);
+    int ram_pages = 0x0800 / MemoryMapManager::PAGE_SIZE;
+    for (int page = 0; page < ram_pages; page++) {
+        if (page >= (int)first.size() || !first[page]) {
+            printf("written_pages: RAM page %d wasn't in the first report\n", page);
+            return false;
+        }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    std::vector<bool> idle;
+    machine.emu->get_written_pages(idle);
+    // loads go straight to RAM, not through the worker
+    machine.emu->halt();
+    machine.emu->loadRAM(0x0300, (uint8_t*)program, sizeof(program));
+    std::vector<bool> loaded;
+    machine.emu->get_written_pages(loaded);
+
+    for (int page = 1; page < (int)idle.size(); page++) {
+        if (idle[page]) {
+            printf("written_pages: page %d was written while the Monitor waited for a key\n", page);
+            return false;
+        }
+    }
+    for (int page = 1; page < (int)loaded.size(); page++) {
+        if (loaded[page] != (page == 3)) {
+            printf("written_pages: page %d %s after a load to $0300\n", page, loaded[page] ? "written" : "not written");
+            return false;
+        }
+    }
+    return true;
+}
+
+// the registers, RAM and cycle count; m_icount isn't compared, a live session halts wherever
+// the last instruction of a frame ended and a replay exactly at the cycle the journal ends
+static bool same_state(const MachineState& a, const MachineState& b) {
+    const m6800_state& x = a.get_cpu();
+    const m6800_state& y = b.get_cpu();
+    return x.pc == y.pc && x.s == y.s && x.x == y.x && x.a == y.a && x.b == y.b && x.cc == y.cc
+        && x.wai_state == y.wai_state && a.get_total_cycles() == b.get_total_cycles() && a.get_ram() == b.get_ram();
+}
+
+// the Monitor, typed at in real time with idle skipping on, then replayed from the recording
+// with it on and off: both replays end in the state the live session did
+static bool journal_replay() {
+    Emulator machine;
+    machine.emu->loadROM(ET3400_ROM_DIR "/monitor.bin", 0xFC00, 0x0400);
+    machine.emu->loadROM(ET3400_ROM_DIR "/fantomii.bin", 0x1400, 0x0800);
+    machine.emu->loadROM(ET3400_ROM_DIR "/tinybasic.bin", 0x1C00, 0x0800);
+    machine.emu->init();
+    machine.emu->start();
+
+    static const keypad_io::Keys keys[] = { keypad_io::KeyE, keypad_io::Key1, keypad_io::Key2, keypad_io::KeyD, keypad_io::KeyA, keypad_io::Key0, keypad_io::KeyF, keypad_io::Key7 };
+    uint32_t seed = 0x6820;
+    for (int i = 0; i < 40; i++) {
+        seed = seed * 1103515245 + 12345;
+        keypad_io::Keys key = keys[(seed >> 16) % 8];
+        machine.emu->press_key(key);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5 + (seed >> 8) % 20));
+        machine.emu->release_key(key);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5 + (seed >> 4) % 20));
+        if (i == 20) {
+            machine.emu->press_key(keypad_io::KeyReset);
+        }
+    }
+    machine.emu->halt();
+
+    InputJournal journal;
+    machine.emu->get_recording(journal);
+    MachineState live;
+    machine.emu->saveState(live);
+    std::string display = machine.display->get_text();
+
+    for (int skip = 1; skip >= 0; skip--) {
+        machine.emu->set_idle_skip(skip != 0);
+        machine.emu->replay(journal);
+        clock_type::time_point start = clock_type::now();
+        while (machine.emu->get_replaying() && seconds_since(start) < 30) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        MachineState replayed;
+        machine.emu->saveState(replayed);
+
+        if (!same_state(replayed, live) || machine.display->get_text() != display) {
+            printf("journal_replay: %zu events replayed to cycle %llu with idle skipping %s, the live session ended at %llu in another state\n",
+                journal.get_events().size(), replayed.get_total_cycles(), skip ? "on" : "off", live.get_total_cycles());
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Check {
+    const char* name;
+    bool (*func)();
+    bool timing; /* measured against wall clock time */
+};
+
+static const Check checks[] = {
+    { "clock_rate_with_commands", clock_rate_with_commands, true },
+    { "pia_ca1_interrupt", pia_ca1_interrupt },
+    { "nmi_pulses_from_another_thread", nmi_pulses_from_another_thread },
+    { "display_snapshots", display_snapshots },
+    { "idle_wake_on_input", idle_wake_on_input },
+    { "idle_wake_latency", idle_wake_latency, true },
+    { "idle_telemetry", idle_telemetry },
+    { "written_pages", written_pages },
+    { "journal_replay", journal_replay },
+};
+
+int main(int argc, char* argv[]) {
+    bool timing = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--timing") == 0) {
+            timing = true;
+        } else {
+            printf("usage: %s [--timing]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    int run = 0;
+    int failed = 0;
+    for (const Check& check : checks) {
+        if (check.timing != timing) {
+            continue;
+        }
+        bool ok = check.func();
+        printf("%-32s %s\n", check.name, ok ? "ok" : "FAILED");
+        failed += !ok;
+        run++;
+    }
+    printf("%d checks, %d failed\n", run, failed);
+    return failed == 0 ? 0 : 1;
+}
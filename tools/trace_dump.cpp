@@ -0,0 +1,56 @@
+/*
+    Converts an instruction trace to text
+
+    usage: trace_dump <trace file> [first record] [record count]
+
+    Prints one line per instruction: the cycle it started on, its address and bytes, the
+    disassembly and the registers before it ran.
+*/
+
+#include "../src/cpu/trace.h"
+#include "../src/dasm/disassembler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <trace file> [first record] [record count]\n", argv[0]);
+        return 2;
+    }
+
+    unsigned long long first = argc > 2 ? strtoull(argv[2], nullptr, 10) : 0;
+    unsigned long long count = argc > 3 ? strtoull(argv[3], nullptr, 10) : ~0ULL;
+
+    m6800_trace_reader reader;
+    if (!reader.open(argv[1])) {
+        fprintf(stderr, "%s: can't read %s or it isn't a trace\n", argv[0], argv[1]);
+        return 1;
+    }
+
+    m6800_trace_record record;
+    unsigned long long index = 0;
+    unsigned long long printed = 0;
+    while (printed < count && reader.next(record)) {
+        if (index++ < first) {
+            continue;
+        }
+
+        char bytes[12];
+        int used = 0;
+        for (int i = 0; i < record.length; i++) {
+            used += snprintf(&bytes[used], sizeof(bytes) - used, "%02X ", record.bytes[i]);
+        }
+
+        DasmLine dasm;
+        Disassembler::disassemble(record.bytes, record.pc, dasm);
+        printf("%12llu  %04X  %-9s %-5s%-12s A=%02X B=%02X X=%04X S=%04X CC=%02X\n",
+            record.cycle, record.pc, bytes,
+            dasm.is_illegal ? "???" : dasm.instruction,
+            dasm.operand,
+            record.a, record.b, record.x, record.s, record.cc);
+        printed++;
+    }
+
+    return 0;
+}